@@ -162,6 +162,10 @@ namespace lava {
         if (!block.create(device, target->get_frame_count(), device->graphics_queue().family))
             return false;
 
+        // formats without blit support, optional
+        if (mip_generator.create(device, target->get_frame_count()))
+            staging.set_mip_func(mip_generator.get_func(), mip_generator.get_check());
+
         block_command = block.add_cmd([&](VkCommandBuffer cmd_buf) {
             scoped_label block_label(cmd_buf, _lava_block_, { default_color, 1.f });
 
@@ -169,6 +173,8 @@ namespace lava {
 
             {
                 scoped_label stage_label(cmd_buf, _lava_texture_staging_, { 0.f, 0.13f, 0.4f, 1.f });
+
+                mip_generator.reclaim(current_frame);
                 staging.stage(cmd_buf, current_frame);
             }
 
@@ -205,12 +211,18 @@ namespace lava {
 
         set_window_icon();
 
+        if (config.pipeline_cache)
+            manager.pipeline_cache_dir = file_system::get_pref_dir();
+
         if (!device) {
             device = create_device(config.physical_device);
             if (!device)
                 return false;
         }
 
+        if (!staging.create(device, default_staging_size, config.async_staging))
+            return false;
+
         if (!create_target())
             return false;
 
@@ -236,6 +248,11 @@ namespace lava {
 
             block.destroy();
 
+            staging.set_mip_func({});
+            mip_generator.destroy();
+
+            staging.destroy();
+
             destroy_target();
 
             if (config.save_window)
@@ -470,9 +487,16 @@ namespace lava {
 
             frame_counter++;
 
+            staging.submit(*frame_index);
+
             if (!block.process(*frame_index))
                 return false;
 
+            VkSemaphore staging_semaphore = 0;
+            ui64 staging_value = 0;
+            if (staging.consume_wait(*frame_index, staging_semaphore, staging_value))
+                plotter.add_wait_semaphore(staging_semaphore, staging_wait_stage, staging_value);
+
             return plotter.end_frame(block.get_buffers());
         });
     }
@@ -9,6 +9,7 @@
 #include <liblava/app/gui.hpp>
 #include <liblava/block.hpp>
 #include <liblava/frame.hpp>
+#include <liblava/resource/staging.hpp>
 
 namespace lava {
 
@@ -24,6 +25,9 @@ namespace lava {
             bool v_sync = false;
             index physical_device = 0;
 
+            bool pipeline_cache = true;
+            bool async_staging = true; // transfer queue
+
             lava::font font;
         };
 
@@ -44,6 +48,8 @@ namespace lava {
         lava::staging staging;
         lava::block block;
 
+        lava::mip_generator mip_generator;
+
         renderer plotter;
         forward_shading shading;
         render_target::ptr target;
@@ -149,6 +149,38 @@ namespace lava {
         }
     }
 
+    v3 camera::get_eye_position() const {
+        if ((type == camera_type::first_person) || (view == mat4(0.f)))
+            return position;
+
+        return v3(glm::inverse(view)[3]);
+    }
+
+    r32 camera::get_pixels_per_unit(v3 target, r32 viewport_height, r32 radius) const {
+        auto const distance = std::max(glm::length(target - get_eye_position()) - radius, z_near);
+
+        return viewport_height / (2.f * distance * std::tan(glm::radians(fov) * 0.5f));
+    }
+
+    ray camera::get_ray(mouse_position mouse_pos, uv2 window_size) const {
+        if ((window_size.x == 0) || (window_size.y == 0) || (view == mat4(0.f)))
+            return { get_eye_position(), v3(0.f, 0.f, -1.f) };
+
+        // y down in vulkan clip space like in the window
+        auto const x = to_r32(2.0 * mouse_pos.x / window_size.x - 1.0);
+        auto const y = to_r32(2.0 * mouse_pos.y / window_size.y - 1.0);
+
+        auto const inverse = glm::inverse(projection * view);
+
+        auto near_point = inverse * v4(x, y, 0.f, 1.f);
+        auto far_point = inverse * v4(x, y, 1.f, 1.f);
+
+        auto const origin = v3(near_point) / near_point.w;
+        auto const target = v3(far_point) / far_point.w;
+
+        return { origin, glm::normalize(target - origin) };
+    }
+
     void camera::update_projection() {
         projection = glm::perspective(glm::radians(fov), aspect_ratio, z_near, z_far);
 
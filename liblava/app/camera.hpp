@@ -51,6 +51,18 @@ namespace lava {
             return up || down || left || right;
         }
 
+        v3 get_eye_position() const;
+
+        mat4 get_view_projection() const {
+            return projection * view;
+        }
+
+        // projected size of one world unit at target, for mesh_lod::select
+        r32 get_pixels_per_unit(v3 target, r32 viewport_height, r32 radius = 0.f) const;
+
+        // window coordinates, as input::get_mouse_position -> world space ray for picking
+        ray get_ray(mouse_position mouse_pos, uv2 window_size) const;
+
         v3 position = v3(0.f);
         v3 rotation = v3(0.f);
 
@@ -4,6 +4,12 @@
 
 #pragma once
 
+#include <liblava/asset/asset_loader.hpp>
+#include <liblava/asset/asset_manager.hpp>
+#include <liblava/asset/mesh_cache.hpp>
 #include <liblava/asset/mesh_loader.hpp>
 #include <liblava/asset/scope_image.hpp>
+#include <liblava/asset/texture_cache.hpp>
+#include <liblava/asset/texture_encoder.hpp>
 #include <liblava/asset/texture_loader.hpp>
+#include <liblava/asset/texture_stream.hpp>
@@ -0,0 +1,219 @@
+// file      : liblava/asset/asset_loader.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#include <liblava/asset/asset_loader.hpp>
+
+namespace lava {
+
+    bool asset_loader::create(device_ptr d, task_scheduler& s, lava::staging* st) {
+        device = d;
+        scheduler = &s;
+        staging = st;
+
+        if (scheduler->get_worker_count() == 0)
+            log()->warn("asset loader - scheduler without workers");
+
+        return true;
+    }
+
+    void asset_loader::destroy() {
+        if (!scheduler)
+            return;
+
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+
+            auto queued = queue;
+            while (!queued.empty()) {
+                queued.top()->status->cancel();
+                queued.pop();
+            }
+        }
+
+        // cancelled jobs still pass through run_next
+        scheduler->wait(group);
+
+        for (auto& job : finished) {
+            if (job->result == load_state::decoded)
+                job->result = load_state::cancelled;
+
+            resolve(*job);
+        }
+
+        finished.clear();
+
+        scheduler = nullptr;
+        staging = nullptr;
+        device = nullptr;
+    }
+
+    texture_load::ptr asset_loader::load_texture(file_format filename, texture_type type, load_priority priority) {
+        auto handle = std::make_shared<texture_load>();
+        handle->priority = priority;
+        handle->path = filename.path;
+
+        if (!device || !texture_format_supported(device, filename.format)) {
+            log()->error("load texture {} - format not supported", filename.path);
+
+            handle->resolve(load_state::failed);
+            return handle;
+        }
+
+        auto item = std::make_shared<job>();
+        item->status = handle;
+
+        // decoded into a mapped upload buffer on the worker (vma is thread safe), image created in poll()
+        auto data = std::make_shared<texture_data>();
+        auto upload_buffer = std::make_shared<buffer::ptr>();
+
+        item->decode = [this, data, upload_buffer, filename, type]() {
+            return load_texture_data(filename, *data, type, scheduler, [&](texture_data const&, size_t size) -> data_ptr {
+                auto buffer = make_buffer();
+                if (!buffer->create_mapped(device, nullptr, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT))
+                    return nullptr;
+
+                *upload_buffer = buffer;
+                return as_ptr(buffer->get_mapped_data());
+            });
+        };
+
+        item->create = [this, handle, data, upload_buffer]() {
+            auto texture = make_texture();
+            if (!texture->create(device, data->size, data->format, data->layers, data->type, data->mip_levels_generation))
+                return false;
+
+            texture->set_upload_buffer(std::move(*upload_buffer));
+            handle->result = texture;
+
+            if (staging)
+                staging->add(texture);
+
+            return true;
+        };
+
+        add(item);
+        return handle;
+    }
+
+    mesh_load::ptr asset_loader::load_mesh(string_ref filename, bool optimize, load_priority priority) {
+        return add_mesh(filename, optimize, priority, 0, nullptr);
+    }
+
+    mesh_load::ptr asset_loader::add_mesh(string_ref filename, bool optimize, load_priority priority,
+                                          ui32 stride, mesh::pack_func pack) {
+        auto handle = std::make_shared<mesh_load>();
+        handle->priority = priority;
+        handle->path = filename;
+
+        if (!device) {
+            handle->resolve(load_state::failed);
+            return handle;
+        }
+
+        auto item = std::make_shared<job>();
+        item->status = handle;
+
+        item->decode = [handle, optimize, stride, pack]() {
+            auto mesh = lava::load_mesh(nullptr, str(handle->get_path()), optimize);
+            if (!mesh)
+                return false;
+
+            if (pack)
+                mesh->set_format(stride, pack);
+
+            handle->result = mesh;
+            return true;
+        };
+
+        item->create = [this, handle]() {
+            auto& mesh = handle->result;
+
+            if (staging)
+                return mesh->create(device, false, VMA_MEMORY_USAGE_GPU_ONLY) && staging->add(mesh);
+
+            return mesh->create(device);
+        };
+
+        add(item);
+        return handle;
+    }
+
+    ui32 asset_loader::poll(ui32 max_count) {
+        std::deque<job::ptr> ready;
+        {
+            std::unique_lock<std::mutex> lock(finished_mutex);
+
+            if ((max_count == 0) || (max_count >= finished.size())) {
+                ready.swap(finished);
+            } else {
+                ready.assign(finished.begin(), finished.begin() + max_count);
+                finished.erase(finished.begin(), finished.begin() + max_count);
+            }
+        }
+
+        for (auto& job : ready)
+            resolve(*job);
+
+        return to_ui32(ready.size());
+    }
+
+    void asset_loader::add(job::ptr job) {
+        pending.fetch_add(1, std::memory_order_acq_rel);
+
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+
+            job->sequence = sequence++;
+            queue.push(std::move(job));
+        }
+
+        scheduler->submit([&]() { run_next(); }, &group);
+    }
+
+    void asset_loader::run_next() {
+        job::ptr current;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            if (queue.empty())
+                return;
+
+            current = queue.top();
+            queue.pop();
+        }
+
+        auto& status = *current->status;
+
+        if (status.cancel_requested()) {
+            current->result = load_state::cancelled;
+        } else {
+            status.state.store(load_state::decoding, std::memory_order_release);
+
+            current->result = current->decode() ? load_state::decoded : load_state::failed;
+            if (current->result == load_state::decoded)
+                status.state.store(load_state::decoded, std::memory_order_release);
+        }
+
+        std::unique_lock<std::mutex> lock(finished_mutex);
+        finished.push_back(std::move(current));
+    }
+
+    void asset_loader::resolve(job& job) {
+        auto result = job.result;
+
+        if (result == load_state::decoded) {
+            if (job.status->cancel_requested())
+                result = load_state::cancelled;
+            else
+                result = job.create() ? load_state::ready : load_state::failed;
+        }
+
+        if (result == load_state::failed)
+            log()->error("load asset {}", job.status->get_path());
+
+        job.status->resolve(result);
+
+        pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+} // namespace lava
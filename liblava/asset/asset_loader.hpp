@@ -0,0 +1,198 @@
+// file      : liblava/asset/asset_loader.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <future>
+#include <liblava/asset/mesh_loader.hpp>
+#include <liblava/asset/texture_loader.hpp>
+#include <liblava/resource/staging.hpp>
+#include <liblava/util/scheduler.hpp>
+#include <queue>
+
+namespace lava {
+
+    enum class load_priority : type {
+        low = 0,
+        normal,
+        high
+    };
+
+    enum class load_state : type {
+        queued = 0,
+        decoding,
+        decoded, // waiting for poll()
+        ready,
+        failed,
+        cancelled
+    };
+
+    struct load_status : no_copy_no_move {
+        using ptr = std::shared_ptr<load_status>;
+
+        virtual ~load_status() = default;
+
+        load_state get_state() const {
+            return state.load(std::memory_order_acquire);
+        }
+
+        // ready, failed or cancelled
+        bool done() const {
+            auto const current = get_state();
+            return (current == load_state::ready) || (current == load_state::failed) || (current == load_state::cancelled);
+        }
+
+        // skips the decode when still queued, drops the result otherwise
+        void cancel() {
+            cancel_flag.store(true, std::memory_order_release);
+        }
+        bool cancel_requested() const {
+            return cancel_flag.load(std::memory_order_acquire);
+        }
+
+        load_priority get_priority() const {
+            return priority;
+        }
+
+        string const& get_path() const {
+            return path;
+        }
+
+    protected:
+        friend struct asset_loader;
+
+        virtual void resolve(load_state result) = 0;
+
+        std::atomic<load_state> state = { load_state::queued };
+        std::atomic<bool> cancel_flag = { false };
+
+        load_priority priority = load_priority::normal;
+        string path;
+    };
+
+    // resolved by asset_loader::poll() on the main thread
+    template<typename T>
+    struct load_handle : load_status {
+        using ptr = std::shared_ptr<load_handle<T>>;
+        using result_ptr = typename T::ptr;
+
+        load_handle()
+        : future(promise.get_future().share()) {}
+
+        // nullptr until ready
+        result_ptr get() const {
+            return get_state() == load_state::ready ? result : nullptr;
+        }
+
+        // do not wait on the thread that polls
+        std::shared_future<result_ptr> get_future() const {
+            return future;
+        }
+
+    private:
+        friend struct asset_loader;
+
+        void resolve(load_state value) override {
+            if (value != load_state::ready)
+                result = nullptr;
+
+            state.store(value, std::memory_order_release);
+            promise.set_value(result);
+        }
+
+        result_ptr result;
+
+        std::promise<result_ptr> promise;
+        std::shared_future<result_ptr> future;
+    };
+
+    using texture_load = load_handle<texture>;
+    using mesh_load = load_handle<mesh>;
+
+    // decode on the task scheduler, gpu resources and staging in poll() on the main thread
+    struct asset_loader : no_copy_no_move {
+        ~asset_loader() {
+            destroy();
+        }
+
+        // staging nullptr -> textures left to the caller, meshes in host visible memory
+        bool create(device_ptr device, task_scheduler& scheduler, lava::staging* staging = nullptr);
+
+        // cancels everything not resolved yet
+        void destroy();
+
+        texture_load::ptr load_texture(file_format filename, texture_type type = texture_type::tex_2d,
+                                       load_priority priority = load_priority::normal);
+
+        mesh_load::ptr load_mesh(string_ref filename, bool optimize = false,
+                                 load_priority priority = load_priority::normal);
+
+        // vertex buffer in Format, see vertex_format
+        template<typename Format>
+        mesh_load::ptr load_mesh(string_ref filename, bool optimize = false,
+                                 load_priority priority = load_priority::normal) {
+            return add_mesh(filename, optimize, priority, Format::stride, &Format::pack);
+        }
+
+        // main thread, max_count 0 -> all decoded
+        ui32 poll(ui32 max_count = 0);
+
+        // queued, decoding or waiting for poll()
+        ui32 get_pending() const {
+            return pending.load(std::memory_order_acquire);
+        }
+
+        bool busy() const {
+            return get_pending() > 0;
+        }
+
+    private:
+        struct job {
+            using ptr = std::shared_ptr<job>;
+
+            load_status::ptr status;
+            ui64 sequence = 0;
+
+            std::function<bool()> decode; // worker
+            std::function<bool()> create; // main thread
+
+            load_state result = load_state::queued;
+        };
+
+        struct job_order {
+            bool operator()(job::ptr const& a, job::ptr const& b) const {
+                if (a->status->get_priority() != b->status->get_priority())
+                    return a->status->get_priority() < b->status->get_priority();
+
+                return a->sequence > b->sequence;
+            }
+        };
+
+        mesh_load::ptr add_mesh(string_ref filename, bool optimize, load_priority priority,
+                                ui32 stride, mesh::pack_func pack);
+
+        void add(job::ptr job);
+
+        // pops the most urgent job, not the one that was submitted
+        void run_next();
+
+        void resolve(job& job);
+
+        device_ptr device = nullptr;
+        task_scheduler* scheduler = nullptr;
+        lava::staging* staging = nullptr;
+
+        task_group group;
+
+        std::mutex queue_mutex;
+        std::priority_queue<job::ptr, std::vector<job::ptr>, job_order> queue;
+        ui64 sequence = 0;
+
+        std::mutex finished_mutex;
+        std::deque<job::ptr> finished;
+
+        std::atomic<ui32> pending = { 0 };
+    };
+
+} // namespace lava
@@ -0,0 +1,248 @@
+// file      : liblava/asset/asset_manager.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#include <liblava/asset/asset_manager.hpp>
+
+namespace lava {
+
+    namespace {
+
+        size_t get_buffer_size(buffer::ptr const& buffer) {
+            return buffer ? to_size_t(buffer->get_size()) : 0;
+        }
+
+        // vertices and indices stay on the cpu for reload()
+        size_t get_mesh_cpu_size(mesh& mesh) {
+            auto const packed_size = mesh.get_vertex_stride() != sizeof(vertex) ? mesh.get_vertex_data_size() : 0;
+
+            return mesh.get_vertices().size() * sizeof(vertex) + mesh.get_indices().size() * sizeof(ui32) + packed_size;
+        }
+
+        size_t get_mesh_gpu_size(mesh& mesh) {
+            return get_buffer_size(mesh.get_vertex_buffer()) + get_buffer_size(mesh.get_index_buffer());
+        }
+
+    } // namespace
+
+    bool asset_manager::create(device_ptr d, index fc, lava::staging* st, task_scheduler* s) {
+        device = d;
+        frame_count = fc;
+        staging = st;
+        scheduler = s;
+
+        return device != nullptr;
+    }
+
+    void asset_manager::destroy() {
+        if (!device)
+            return;
+
+        for (auto& [asset, texture] : textures.get_all())
+            texture->destroy();
+
+        for (auto& [asset, mesh] : meshes.get_all())
+            mesh->destroy();
+
+        // caller waits for the device before
+        for (auto& item : retired_assets) {
+            if (item.texture)
+                item.texture->destroy();
+
+            if (item.mesh)
+                item.mesh->destroy();
+        }
+
+        textures = {};
+        meshes = {};
+
+        keys.clear();
+        entries.clear();
+        lru.clear();
+        retired_assets.clear();
+
+        current = {};
+
+        device = nullptr;
+        staging = nullptr;
+        scheduler = nullptr;
+    }
+
+    texture_ref asset_manager::load_texture(file_format filename, texture_type type) {
+        auto const key = fmt::format("texture:{}:{}:{}", filename.path, to_ui32(filename.format), to_ui32(type));
+
+        if (auto const asset = find(key); asset.valid())
+            return texture_ref(this, textures.get(asset));
+
+        auto texture = lava::load_texture(device, filename, type, scheduler);
+        if (!texture) {
+            log()->error("asset manager - load texture {}", filename.path);
+            return {};
+        }
+
+        if (staging)
+            staging->add(texture);
+
+        textures.add(texture, filename);
+        add(texture->get_id(), key, true, 0, to_size_t(texture->get_memory_size()));
+
+        return texture_ref(this, texture);
+    }
+
+    mesh_ref asset_manager::load_mesh(string_ref filename, bool optimize) {
+        auto const key = fmt::format("mesh:{}:{}", filename, optimize);
+
+        if (auto const asset = find(key); asset.valid())
+            return mesh_ref(this, meshes.get(asset));
+
+        auto mesh = lava::load_mesh(device, str(filename), optimize);
+        if (!mesh) {
+            log()->error("asset manager - load mesh {}", filename);
+            return {};
+        }
+
+        meshes.add(mesh, { .filename = filename });
+        add(mesh->get_id(), key, false, get_mesh_cpu_size(*mesh), get_mesh_gpu_size(*mesh));
+
+        return mesh_ref(this, mesh);
+    }
+
+    void asset_manager::update() {
+        ++frame;
+
+        // evicted assets may still be read by frames in flight
+        while (!retired_assets.empty() && (retired_assets.front().frame + frame_count < frame)) {
+            auto& item = retired_assets.front();
+
+            if (item.texture)
+                item.texture->destroy();
+
+            if (item.mesh)
+                item.mesh->destroy();
+
+            retired_assets.pop_front();
+        }
+
+        while (over_budget() && evict_oldest())
+            continue;
+
+        current.retired_count = to_ui32(retired_assets.size());
+    }
+
+    void asset_manager::trim() {
+        while (evict_oldest())
+            continue;
+
+        current.retired_count = to_ui32(retired_assets.size());
+    }
+
+    id asset_manager::find(string_ref key) {
+        auto const it = keys.find(key);
+        if (it == keys.end()) {
+            ++current.miss_count;
+            return undef_id;
+        }
+
+        ++current.hit_count;
+
+        retain(it->second);
+        return it->second;
+    }
+
+    void asset_manager::add(id::ref asset, string_ref key, bool is_texture, size_t cpu_size, size_t gpu_size) {
+        entry item;
+        item.key = key;
+        item.ref_count = 1;
+        item.cpu_size = cpu_size;
+        item.gpu_size = gpu_size;
+        item.is_texture = is_texture;
+        item.lru = lru.end();
+
+        keys.emplace(key, asset);
+        entries.emplace(asset, item);
+
+        current.cpu_size += cpu_size;
+        current.gpu_size += gpu_size;
+        ++current.asset_count;
+    }
+
+    void asset_manager::retain(id::ref asset) {
+        auto const it = entries.find(asset);
+        if (it == entries.end())
+            return;
+
+        auto& item = it->second;
+        if (item.ref_count++ > 0)
+            return;
+
+        lru.erase(item.lru);
+        item.lru = lru.end();
+
+        --current.unreferenced_count;
+    }
+
+    void asset_manager::release(id::ref asset) {
+        auto const it = entries.find(asset);
+        if (it == entries.end())
+            return;
+
+        auto& item = it->second;
+        if (--item.ref_count > 0)
+            return;
+
+        item.lru = lru.insert(lru.end(), asset);
+
+        ++current.unreferenced_count;
+    }
+
+    bool asset_manager::evict_oldest() {
+        // a texture still queued would be destroyed before staging records its copy
+        auto const candidate = std::find_if(lru.begin(), lru.end(), [&](id::ref asset) {
+            if (!staging || !entries.at(asset).is_texture)
+                return true;
+
+            return !staging->pending(*textures.get(asset));
+        });
+
+        if (candidate == lru.end())
+            return false;
+
+        auto const asset = *candidate;
+        lru.erase(candidate);
+
+        auto const it = entries.find(asset);
+        auto const& item = it->second;
+
+        retired retired_item;
+        retired_item.frame = frame;
+
+        if (item.is_texture) {
+            retired_item.texture = textures.get(asset);
+            textures.remove(asset);
+        } else {
+            retired_item.mesh = meshes.get(asset);
+            meshes.remove(asset);
+        }
+
+        retired_assets.push_back(std::move(retired_item));
+
+        log()->debug("asset manager - evict {}", item.key);
+
+        current.cpu_size -= item.cpu_size;
+        current.gpu_size -= item.gpu_size;
+        --current.asset_count;
+        --current.unreferenced_count;
+        ++current.evict_count;
+
+        keys.erase(item.key);
+        entries.erase(it);
+
+        return true;
+    }
+
+    bool asset_manager::over_budget() const {
+        return ((budget.cpu > 0) && (current.cpu_size > budget.cpu))
+               || ((budget.gpu > 0) && (current.gpu_size > budget.gpu));
+    }
+
+} // namespace lava
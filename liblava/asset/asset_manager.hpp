@@ -0,0 +1,232 @@
+// file      : liblava/asset/asset_manager.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/asset/mesh_loader.hpp>
+#include <liblava/asset/texture_loader.hpp>
+#include <liblava/resource/staging.hpp>
+#include <list>
+
+namespace lava {
+
+    struct asset_manager;
+
+    // bytes, 0 -> unlimited
+    struct asset_budget {
+        size_t cpu = 0;
+        size_t gpu = 0;
+    };
+
+    // counted reference, the asset stays cached after the last one is gone
+    template<typename T>
+    struct asset_ref {
+        using ptr = typename T::ptr;
+
+        asset_ref() = default;
+        ~asset_ref() {
+            reset();
+        }
+
+        asset_ref(asset_ref const& other);
+        asset_ref& operator=(asset_ref const& other);
+
+        asset_ref(asset_ref&& other) noexcept;
+        asset_ref& operator=(asset_ref&& other) noexcept;
+
+        void reset();
+
+        ptr const& get() const {
+            return object;
+        }
+        T* operator->() const {
+            return object.get();
+        }
+
+        bool valid() const {
+            return object != nullptr;
+        }
+        explicit operator bool() const {
+            return valid();
+        }
+
+        id::ref get_id() const {
+            return object ? object->get_id() : undef_id;
+        }
+
+    private:
+        friend struct asset_manager;
+
+        asset_ref(asset_manager* manager, ptr object)
+        : manager(manager), object(std::move(object)) {}
+
+        asset_manager* manager = nullptr;
+        ptr object;
+    };
+
+    using texture_ref = asset_ref<texture>;
+    using mesh_ref = asset_ref<mesh>;
+
+    // deduplicated by path and parameters, unreferenced assets evicted lru over budget
+    // main thread, references released there as well
+    struct asset_manager : no_copy_no_move {
+        struct stats {
+            size_t cpu_size = 0;
+            size_t gpu_size = 0;
+
+            ui32 asset_count = 0;
+            ui32 unreferenced_count = 0;
+            ui32 retired_count = 0;
+
+            ui32 hit_count = 0;
+            ui32 miss_count = 0;
+            ui32 evict_count = 0;
+        };
+
+        ~asset_manager() {
+            destroy();
+        }
+
+        // frame_count -> updates an evicted asset is kept for frames in flight
+        // staging nullptr -> textures left to the caller
+        bool create(device_ptr device, index frame_count, lava::staging* staging = nullptr,
+                    task_scheduler* scheduler = nullptr);
+
+        // every asset destroyed, references must not outlive the manager
+        void destroy();
+
+        texture_ref load_texture(file_format filename, texture_type type = texture_type::tex_2d);
+        mesh_ref load_mesh(string_ref filename, bool optimize = false);
+
+        // once per frame, destroys retired assets and evicts down to the budget
+        void update();
+
+        // evicts all unreferenced assets now, retired ones still wait for update()
+        void trim();
+
+        void set_budget(asset_budget const& value) {
+            budget = value;
+        }
+        asset_budget const& get_budget() const {
+            return budget;
+        }
+
+        stats const& get_stats() const {
+            return current;
+        }
+
+        // loaded assets, path and parameters as meta
+        texture_registry const& get_textures() const {
+            return textures;
+        }
+        mesh_registry const& get_meshes() const {
+            return meshes;
+        }
+
+    private:
+        template<typename T>
+        friend struct asset_ref;
+
+        struct entry {
+            string key;
+            ui32 ref_count = 0;
+
+            size_t cpu_size = 0;
+            size_t gpu_size = 0;
+
+            bool is_texture = false;
+
+            std::list<id>::iterator lru; // end -> referenced
+        };
+
+        struct retired {
+            lava::texture::ptr texture;
+            lava::mesh::ptr mesh;
+
+            ui64 frame = 0;
+        };
+
+        // existing key -> referenced again
+        id find(string_ref key);
+
+        void add(id::ref asset, string_ref key, bool is_texture, size_t cpu_size, size_t gpu_size);
+
+        void retain(id::ref asset);
+        void release(id::ref asset);
+
+        // false -> nothing left to evict, textures queued in staging are skipped
+        bool evict_oldest();
+
+        bool over_budget() const;
+
+        device_ptr device = nullptr;
+        lava::staging* staging = nullptr;
+        task_scheduler* scheduler = nullptr;
+
+        index frame_count = 0;
+        ui64 frame = 0;
+
+        asset_budget budget;
+        stats current;
+
+        texture_registry textures;
+        mesh_registry meshes;
+
+        std::map<string, id> keys;
+        std::map<id, entry> entries;
+
+        std::list<id> lru; // front -> least recently released
+        std::deque<retired> retired_assets;
+    };
+
+    template<typename T>
+    inline asset_ref<T>::asset_ref(asset_ref const& other)
+    : manager(other.manager), object(other.object) {
+        if (object)
+            manager->retain(object->get_id());
+    }
+
+    template<typename T>
+    inline asset_ref<T>& asset_ref<T>::operator=(asset_ref const& other) {
+        if (this != &other) {
+            if (other.object)
+                other.manager->retain(other.object->get_id());
+
+            reset();
+
+            manager = other.manager;
+            object = other.object;
+        }
+        return *this;
+    }
+
+    template<typename T>
+    inline asset_ref<T>::asset_ref(asset_ref&& other) noexcept
+    : manager(other.manager), object(std::move(other.object)) {
+        other.manager = nullptr;
+    }
+
+    template<typename T>
+    inline asset_ref<T>& asset_ref<T>::operator=(asset_ref&& other) noexcept {
+        if (this != &other) {
+            reset();
+
+            manager = other.manager;
+            object = std::move(other.object);
+
+            other.manager = nullptr;
+        }
+        return *this;
+    }
+
+    template<typename T>
+    inline void asset_ref<T>::reset() {
+        if (object && manager)
+            manager->release(object->get_id());
+
+        manager = nullptr;
+        object = nullptr;
+    }
+
+} // namespace lava
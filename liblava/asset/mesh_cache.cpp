@@ -0,0 +1,186 @@
+// file      : liblava/asset/mesh_cache.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <liblava/asset/mesh_cache.hpp>
+#include <liblava/file/file_system.hpp>
+#include <liblava/file/file_utils.hpp>
+#include <liblava/file/mapped_file.hpp>
+#include <liblava/util/log.hpp>
+
+namespace lava {
+
+    bool write_mesh_cache(string_ref filename, mesh_data const& data, mesh_cache_flags flags, i64 source_size, i64 source_time) {
+        mesh_cache_header header;
+        header.flags = to_ui32(flags);
+        header.source_size = source_size;
+        header.source_time = source_time;
+
+        auto const vertices_size = data.vertices.size() * sizeof(vertex);
+        auto const indices_size = data.indices.size() * sizeof(ui32);
+
+        header.vertex_count = data.vertices.size();
+        header.index_count = data.indices.size();
+        header.vertex_offset = align_up(sizeof(mesh_cache_header), mesh_cache_alignment);
+        header.index_offset = align_up(header.vertex_offset + vertices_size, mesh_cache_alignment);
+
+        if (!data.vertices.empty()) {
+            v3 bounds_min = data.vertices.front().position;
+            v3 bounds_max = bounds_min;
+
+            for (auto const& vertex : data.vertices) {
+                bounds_min = glm::min(bounds_min, vertex.position);
+                bounds_max = glm::max(bounds_max, vertex.position);
+            }
+
+            for (auto i = 0; i < 3; ++i) {
+                header.bounds_min[i] = bounds_min[i];
+                header.bounds_max[i] = bounds_max[i];
+            }
+        }
+
+        header.checksum = hash64((data_cptr) data.vertices.data(), vertices_size);
+        header.checksum = hash64((data_cptr) data.indices.data(), indices_size, header.checksum);
+
+        // written aside, a reader never maps a partial file
+        auto const temp_filename = get_temp_filename(filename);
+        {
+            std::ofstream file(temp_filename, std::ofstream::binary);
+            if (!file.is_open()) {
+                log()->error("write mesh cache {}", filename);
+                return false;
+            }
+
+            std::array<char, mesh_cache_alignment> const padding = {};
+
+            file.write((data_cptr) &header, sizeof(header));
+            file.write(padding.data(), header.vertex_offset - sizeof(header));
+
+            file.write((data_cptr) data.vertices.data(), vertices_size);
+            file.write(padding.data(), header.index_offset - (header.vertex_offset + vertices_size));
+
+            file.write((data_cptr) data.indices.data(), indices_size);
+
+            if (!file.good()) {
+                log()->error("write mesh cache {}", filename);
+
+                file.close();
+                fs::remove(temp_filename);
+                return false;
+            }
+        }
+
+        std::error_code error;
+        fs::rename(temp_filename, filename, error);
+        if (error) {
+            fs::remove(temp_filename, error);
+            return false;
+        }
+
+        return true;
+    }
+
+    namespace {
+
+        // header and checksum checked, vertices and indices point into the mapping
+        bool check_mesh_cache(mapped_file const& file, string_ref filename, mesh_cache_flags flags, i64 source_size, i64 source_time,
+                              mesh_cache_header& header, data_cptr& vertices, data_cptr& indices) {
+            if (!file.opened() || (file.get_size() < sizeof(mesh_cache_header)))
+                return false;
+
+            memcpy(&header, file.get(), sizeof(header));
+
+            mesh_cache_header const expected;
+            if ((memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0)
+                || (header.version != expected.version)
+                || (header.vertex_size != expected.vertex_size)
+                || (header.index_size != expected.index_size))
+                return false;
+
+            if (header.flags != to_ui32(flags))
+                return false;
+
+            if ((source_size != 0 && header.source_size != source_size)
+                || (source_time != 0 && header.source_time != source_time))
+                return false;
+
+            // counts checked by division, a corrupt header must not overflow
+            auto const file_size = ui64(file.get_size());
+            if ((header.vertex_offset > file_size) || (header.index_offset > file_size)
+                || (header.vertex_count > (file_size - header.vertex_offset) / sizeof(vertex))
+                || (header.index_count > (file_size - header.index_offset) / sizeof(ui32))
+                || (header.vertex_offset % alignof(vertex) != 0) || (header.index_offset % alignof(ui32) != 0))
+                return false;
+
+            vertices = file.get() + header.vertex_offset;
+            indices = file.get() + header.index_offset;
+
+            auto checksum = hash64(vertices, to_size_t(header.vertex_count * sizeof(vertex)));
+            checksum = hash64(indices, to_size_t(header.index_count * sizeof(ui32)), checksum);
+
+            if (checksum != header.checksum) {
+                log()->warn("mesh cache {} corrupt", filename);
+                return false;
+            }
+
+            return true;
+        }
+
+    } // namespace
+
+    bool read_mesh_cache(string_ref filename, mesh_data& data, mesh_cache_flags flags, i64 source_size, i64 source_time, mesh_cache_header* result) {
+        mapped_file file(filename);
+
+        mesh_cache_header header;
+        data_cptr vertices = nullptr;
+        data_cptr indices = nullptr;
+
+        if (!check_mesh_cache(file, filename, flags, source_size, source_time, header, vertices, indices))
+            return false;
+
+        // one copy out of the mapping, no zero fill before
+        auto const first_vertex = reinterpret_cast<vertex const*>(vertices);
+        data.vertices.assign(first_vertex, first_vertex + header.vertex_count);
+
+        auto const first_index = reinterpret_cast<ui32 const*>(indices);
+        data.indices.assign(first_index, first_index + header.index_count);
+
+        if (result)
+            *result = header;
+
+        return true;
+    }
+
+    bool read_mesh_cache(string_ref filename, mesh_cache_target const& target, mesh_cache_flags flags, i64 source_size, i64 source_time) {
+        mapped_file file(filename);
+
+        mesh_cache_header header;
+        data_cptr vertices = nullptr;
+        data_cptr indices = nullptr;
+
+        if (!check_mesh_cache(file, filename, flags, source_size, source_time, header, vertices, indices))
+            return false;
+
+        data_ptr vertex_target = nullptr;
+        data_ptr index_target = nullptr;
+        if (!target(header, vertex_target, index_target) || !vertex_target || !index_target)
+            return false;
+
+        memcpy(vertex_target, vertices, to_size_t(header.vertex_count * sizeof(vertex)));
+        memcpy(index_target, indices, to_size_t(header.index_count * sizeof(ui32)));
+
+        return true;
+    }
+
+    string get_mesh_cache_path(name filename) {
+        // a/b_c and a_b/c must not share a file
+        auto const path = fs::path(filename).lexically_normal().generic_string();
+        auto const key = hash64(path.data(), path.size());
+
+        return fmt::format("{}{}.{:016x}{}", file_system::get_pref_dir(), get_filename_from(path), key, _lmesh_);
+    }
+
+} // namespace lava
@@ -0,0 +1,67 @@
+// file      : liblava/asset/mesh_cache.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/resource/mesh.hpp>
+
+namespace lava {
+
+    constexpr name _lmesh_ = ".lmesh";
+
+    constexpr ui32 const mesh_cache_version = 1;
+    constexpr size_t const mesh_cache_alignment = 64;
+
+    // stored as bits in mesh_cache_header::flags
+    enum class mesh_cache_flags : ui32 {
+        none = 0,
+        optimized = 1 << 0,
+    };
+
+    // little endian, vertices and indices aligned for direct upload
+    struct mesh_cache_header {
+        c8 magic[4] = { 'L', 'M', 'S', 'H' };
+        ui32 version = mesh_cache_version;
+        ui32 vertex_size = sizeof(vertex);
+        ui32 index_size = sizeof(ui32);
+
+        ui32 flags = 0;
+        ui32 reserved = 0;
+
+        ui64 vertex_count = 0;
+        ui64 index_count = 0;
+        ui64 vertex_offset = 0;
+        ui64 index_offset = 0;
+
+        r32 bounds_min[3] = {};
+        r32 bounds_max[3] = {};
+
+        // source file, 0 -> not checked
+        i64 source_size = 0;
+        i64 source_time = 0;
+
+        ui64 checksum = 0; // hash64 of vertices and indices
+    };
+
+    static_assert(sizeof(mesh_cache_header) == 104, "mesh cache header layout");
+
+    bool write_mesh_cache(string_ref filename, mesh_data const& data, mesh_cache_flags flags = mesh_cache_flags::none,
+                          i64 source_size = 0, i64 source_time = 0);
+
+    // false -> missing, outdated or corrupt
+    // mesh_data keeps the cpu copy a mesh needs for reload(), one copy out of the mapping into the vectors
+    bool read_mesh_cache(string_ref filename, mesh_data& data, mesh_cache_flags flags = mesh_cache_flags::none,
+                         i64 source_size = 0, i64 source_time = 0, mesh_cache_header* header = nullptr);
+
+    // header checked -> memory for vertex_count vertices and index_count indices, e.g. mapped upload buffers
+    using mesh_cache_target = std::function<bool(mesh_cache_header const& header, data_ptr& vertices, data_ptr& indices)>;
+
+    // copied from the mapping straight into the target, nothing kept on the cpu
+    bool read_mesh_cache(string_ref filename, mesh_cache_target const& target, mesh_cache_flags flags = mesh_cache_flags::none,
+                         i64 source_size = 0, i64 source_time = 0);
+
+    // cache file for a file_system path in the pref dir
+    string get_mesh_cache_path(name filename);
+
+} // namespace lava
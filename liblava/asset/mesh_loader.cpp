@@ -2,8 +2,10 @@
 // copyright : Copyright (c) 2018-present, Lava Block OÜ
 // license   : MIT; see accompanying LICENSE file
 
+#include <liblava/asset/mesh_cache.hpp>
 #include <liblava/asset/mesh_loader.hpp>
 #include <liblava/file.hpp>
+#include <unordered_map>
 
 #ifndef LIBLAVA_TINYOBJLOADER
 #    define LIBLAVA_TINYOBJLOADER 1
@@ -29,44 +31,122 @@
 
 #endif
 
-lava::mesh::ptr lava::load_mesh(device_ptr device, name filename) {
+#if LIBLAVA_TINYOBJLOADER
+
+namespace lava {
+
+    // material files next to the obj, through file_system
+    struct file_material_reader : tinyobj::MaterialReader {
+        explicit file_material_reader(string base_dir)
+        : base_dir(std::move(base_dir)) {}
+
+        bool operator()(std::string const& mat_id, std::vector<tinyobj::material_t>* materials,
+                        std::map<std::string, int>* mat_map, std::string* warn, std::string* err) override {
+            file_data mtl_data(base_dir + mat_id);
+            if (!mtl_data.ptr) {
+                if (warn)
+                    *warn += "material file not found: " + mat_id + "\n";
+
+                return false;
+            }
+
+            data_stream_buffer buffer(mtl_data);
+            std::istream stream(&buffer);
+
+            tinyobj::LoadMtl(mat_map, materials, &stream, warn, err);
+            return true;
+        }
+
+    private:
+        string base_dir;
+    };
+
+} // namespace lava
+
+#endif
+
+lava::mesh::ptr lava::load_mesh(device_ptr device, name filename, bool optimize) {
 #if LIBLAVA_TINYOBJLOADER
     if (extension(filename, "OBJ")) {
+        i64 source_size = 0;
+        {
+            file file(filename);
+            if (file.opened())
+                source_size = file.get_size();
+        }
+
+        auto const source_time = file_system::get_last_modified(filename);
+        auto const cache_flags = optimize ? mesh_cache_flags::optimized : mesh_cache_flags::none;
+
+        // shipped next to the source or written to the pref dir on first load
+        string_list cache_files;
+        {
+            auto real_dir = file_system::get_real_dir(filename);
+            cache_files.push_back(real_dir ? string(real_dir) + "/" + filename + _lmesh_ : string(filename) + _lmesh_);
+        }
+
+        if (file_system::instance().ready())
+            cache_files.push_back(get_mesh_cache_path(filename));
+
+        for (auto& cache_file : cache_files) {
+            auto mesh = make_mesh();
+            if (!read_mesh_cache(cache_file, mesh->get_data(), cache_flags, source_size, source_time))
+                continue;
+
+            if (mesh->empty() || (device && !mesh->create(device)))
+                return nullptr;
+
+            log()->debug("load mesh {} - cache {}", filename, cache_file);
+            return mesh;
+        }
+
         tinyobj::attrib_t attrib;
         std::vector<tinyobj::shape_t> shapes;
         std::vector<tinyobj::material_t> materials;
         std::string err;
         std::string warn;
 
-        string target_file = filename;
-
-        file_remover temp_file_remover;
+        auto loaded = false;
         {
             file file(filename);
             if (file.opened() && file.get_type() == file_type::fs) {
-                string temp_file;
-                temp_file = file_system::get_pref_dir();
-                temp_file += get_filename_from(target_file, true);
-
-                scope_data temp_data(file.get_size());
-                if (!temp_data.ptr)
+                // parse straight from memory, archives have no path on disk
+                scope_data obj_data(file.get_size());
+                if (!obj_data.ptr)
                     return nullptr;
 
-                if (file_error(file.read(temp_data.ptr)))
+                if (file_error(file.read(obj_data.ptr)))
                     return nullptr;
 
-                if (!write_file(str(temp_file), temp_data.ptr, temp_data.size))
-                    return nullptr;
+                file.close();
 
-                target_file = temp_file;
+                data_stream_buffer buffer(obj_data);
+                std::istream stream(&buffer);
 
-                temp_file_remover.filename = target_file;
+                string base_dir = filename;
+                auto separator = base_dir.find_last_of('/');
+                base_dir = separator == string::npos ? "" : base_dir.substr(0, separator + 1);
+
+                file_material_reader material_reader(base_dir);
+
+                loaded = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &stream, &material_reader);
+            } else {
+                file.close();
+
+                loaded = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename);
             }
         }
 
-        if (tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, str(target_file))) {
+        if (loaded) {
             auto mesh = make_mesh();
 
+            auto& vertices = mesh->get_vertices();
+            auto& indices = mesh->get_indices();
+
+            // welding while loading, equal face corners share one vertex
+            std::unordered_map<vertex, ui32> unique_indices;
+            size_t corner_count = 0;
+
             for (auto const& shape : shapes) {
                 for (auto const& index : shape.mesh.indices) {
                     vertex vertex;
@@ -77,20 +157,36 @@ lava::mesh::ptr lava::load_mesh(device_ptr device, name filename) {
 
                     vertex.color = v4(1.f);
 
-                    if (!attrib.texcoords.empty())
-                        vertex.uv = v2(attrib.texcoords[2 * index.texcoord_index], 1.f - attrib.texcoords[2 * index.texcoord_index + 1]);
+                    vertex.uv = attrib.texcoords.empty() || (index.texcoord_index < 0) ? v2(0.f) : v2(attrib.texcoords[2 * index.texcoord_index], 1.f - attrib.texcoords[2 * index.texcoord_index + 1]);
 
-                    vertex.normal = attrib.normals.empty() ? v3(0.f) : v3(attrib.normals[3 * index.normal_index], attrib.normals[3 * index.normal_index + 1], attrib.normals[3 * index.normal_index + 2]);
+                    vertex.normal = attrib.normals.empty() || (index.normal_index < 0) ? v3(0.f) : v3(attrib.normals[3 * index.normal_index], attrib.normals[3 * index.normal_index + 1], attrib.normals[3 * index.normal_index + 2]);
 
-                    mesh->get_vertices().push_back(vertex);
-                    mesh->get_indices().push_back(mesh->get_indices_count());
+                    auto [it, inserted] = unique_indices.try_emplace(vertex, to_ui32(vertices.size()));
+                    if (inserted)
+                        vertices.push_back(vertex);
+
+                    indices.push_back(it->second);
+                    ++corner_count;
                 }
             }
 
+            if (corner_count > 0)
+                log()->debug("load mesh {} - {} vertices welded to {} ({:.1f}%)", filename, corner_count, vertices.size(),
+                             100.0 * to_r64(vertices.size()) / to_r64(corner_count));
+
             if (mesh->empty())
                 return nullptr;
 
-            if (!mesh->create(device))
+            if (attrib.normals.empty())
+                compute_normals(mesh->get_data());
+
+            if (optimize)
+                optimize_mesh(mesh->get_data(), true);
+
+            if (file_system::instance().ready())
+                write_mesh_cache(get_mesh_cache_path(filename), mesh->get_data(), cache_flags, source_size, source_time);
+
+            if (device && !mesh->create(device))
                 return nullptr;
 
             return mesh;
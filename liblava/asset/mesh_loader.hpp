@@ -4,10 +4,28 @@
 
 #pragma once
 
-#include <liblava/resource/mesh.hpp>
+#include <liblava/resource/mesh_optimizer.hpp>
+#include <liblava/resource/vertex_format.hpp>
+#include <liblava/resource/vertex_kernels.hpp>
 
 namespace lava {
 
-    mesh::ptr load_mesh(device_ptr device, name filename);
+    // default optimize in resource/mesh.hpp
+    mesh::ptr load_mesh(device_ptr device, name filename, bool optimize);
+
+    // vertex buffer in Format, see vertex_format
+    template<typename Format>
+    inline mesh::ptr load_mesh(device_ptr device, name filename, bool optimize = false) {
+        auto mesh = load_mesh(nullptr, filename, optimize);
+        if (!mesh)
+            return nullptr;
+
+        mesh->set_format<Format>();
+
+        if (!mesh->create(device))
+            return nullptr;
+
+        return mesh;
+    }
 
 } // namespace lava
@@ -0,0 +1,267 @@
+// file      : liblava/asset/texture_cache.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <liblava/asset/texture_cache.hpp>
+#include <liblava/asset/texture_encoder.hpp>
+#include <liblava/file/file.hpp>
+#include <liblava/file/file_system.hpp>
+#include <liblava/file/file_utils.hpp>
+#include <liblava/util/log.hpp>
+
+namespace lava {
+
+    namespace {
+
+        std::array<ui8, 12> const ktx_identifier = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+        constexpr ui32 const ktx_endianness = 0x04030201;
+        constexpr name ktx_cache_key = "lava.cache";
+
+        // gl compressed formats, 0 -> no cache
+        ui32 get_gl_internal_format(VkFormat format) {
+            switch (format) {
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+                return 0x83F0;
+            case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+                return 0x8C4C;
+            case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+                return 0x83F1;
+            case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+                return 0x8C4D;
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+                return 0x83F3;
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+                return 0x8C4F;
+            case VK_FORMAT_BC7_UNORM_BLOCK:
+                return 0x8E8C;
+            case VK_FORMAT_BC7_SRGB_BLOCK:
+                return 0x8E8D;
+            default:
+                return 0;
+            }
+        }
+
+        ui32 get_gl_base_internal_format(VkFormat format) {
+            auto const rgb = (format == VK_FORMAT_BC1_RGB_UNORM_BLOCK) || (format == VK_FORMAT_BC1_RGB_SRGB_BLOCK);
+            return rgb ? 0x1907 : 0x1908;
+        }
+
+        struct ktx_header {
+            std::array<ui8, 12> identifier = ktx_identifier;
+            ui32 endianness = ktx_endianness;
+            ui32 gl_type = 0;
+            ui32 gl_type_size = 1;
+            ui32 gl_format = 0;
+            ui32 gl_internal_format = 0;
+            ui32 gl_base_internal_format = 0;
+            ui32 pixel_width = 0;
+            ui32 pixel_height = 0;
+            ui32 pixel_depth = 0;
+            ui32 array_elements = 0;
+            ui32 faces = 1;
+            ui32 mip_levels = 0;
+            ui32 key_value_size = 0;
+        };
+
+        static_assert(sizeof(ktx_header) == 64, "ktx header layout");
+
+        string get_cache_value(i64 source_size, i64 source_time) {
+            return fmt::format("{} {} {}", texture_cache_version, source_size, source_time);
+        }
+
+        template<typename T>
+        bool read_value(file& file, T& value) {
+            return file.read_next((data_ptr) &value, sizeof(T)) == to_i64(sizeof(T));
+        }
+
+    } // namespace
+
+    bool write_texture_cache(string_ref filename, texture_data const& data, i64 source_size, i64 source_time) {
+        auto const internal_format = get_gl_internal_format(data.format);
+        if (!internal_format || (data.type != texture_type::tex_2d) || (data.layers.size() != 1))
+            return false;
+
+        auto const& levels = data.layers.front().levels;
+
+        // key and value null terminated, padded to 4 bytes
+        auto const value = get_cache_value(source_size, source_time);
+        auto const key_value_size = to_ui32(strlen(ktx_cache_key) + 1 + value.size() + 1);
+        auto const key_value_padding = align_up(key_value_size, 4u) - key_value_size;
+
+        ktx_header header;
+        header.gl_internal_format = internal_format;
+        header.gl_base_internal_format = get_gl_base_internal_format(data.format);
+        header.pixel_width = data.size.x;
+        header.pixel_height = data.size.y;
+        header.mip_levels = to_ui32(levels.size());
+        header.key_value_size = to_ui32(sizeof(ui32)) + key_value_size + key_value_padding;
+
+        // written aside, a reader never sees a partial file
+        auto const temp_filename = get_temp_filename(filename);
+        {
+            std::ofstream file(temp_filename, std::ofstream::binary);
+            if (!file.is_open()) {
+                log()->error("write texture cache {}", filename);
+                return false;
+            }
+
+            std::array<char, 4> const padding = {};
+
+            file.write((data_cptr) &header, sizeof(header));
+
+            file.write((data_cptr) &key_value_size, sizeof(key_value_size));
+            file.write(ktx_cache_key, strlen(ktx_cache_key) + 1);
+            file.write(value.c_str(), value.size() + 1);
+            file.write(padding.data(), key_value_padding);
+
+            // block sizes are multiples of 4, no mip padding
+            auto offset = size_t(0);
+            for (auto const& level : levels) {
+                if (offset + level.size > data.pixels.size())
+                    break;
+
+                file.write((data_cptr) &level.size, sizeof(level.size));
+                file.write(data.pixels.data() + offset, level.size);
+
+                offset += level.size;
+            }
+
+            if (!file.good() || (offset != data.pixels.size())) {
+                log()->error("write texture cache {}", filename);
+                file.close();
+
+                std::error_code error;
+                fs::remove(temp_filename, error);
+                return false;
+            }
+        }
+
+        std::error_code error;
+        fs::rename(temp_filename, filename, error);
+        if (error) {
+            fs::remove(temp_filename, error);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool read_texture_cache(string_ref filename, VkFormat format, texture_data& result,
+                            i64 source_size, i64 source_time, texture_data::target_func const& target) {
+        file file(str(filename));
+        if (!file.opened())
+            return false;
+
+        ktx_header header;
+        if (!read_value(file, header))
+            return false;
+
+        if ((header.identifier != ktx_identifier)
+            || (header.endianness != ktx_endianness)
+            || (header.gl_internal_format != get_gl_internal_format(format))
+            || (header.pixel_depth != 0) || (header.array_elements != 0) || (header.faces != 1)
+            || (header.mip_levels == 0) || (header.pixel_width == 0) || (header.pixel_height == 0))
+            return false;
+
+        // only our own entry counts, a foreign ktx is never taken as cache
+        auto found = false;
+        auto const key_value_end = file.tell() + header.key_value_size;
+
+        while (file.tell() + to_i64(sizeof(ui32)) <= key_value_end) {
+            ui32 entry_size = 0;
+            if (!read_value(file, entry_size) || (file.tell() + entry_size > key_value_end))
+                return false;
+
+            string entry(entry_size, '\0');
+            if (file.read_next(entry.data(), entry_size) != to_i64(entry_size))
+                return false;
+
+            file.seek(to_ui64(file.tell() + (align_up(entry_size, 4u) - entry_size)));
+
+            auto const separator = entry.find('\0');
+            if ((separator == string::npos) || (entry.compare(0, separator, ktx_cache_key) != 0))
+                continue;
+
+            auto const value = entry.substr(separator + 1, entry.find('\0', separator + 1) - separator - 1);
+            if (value != get_cache_value(source_size, source_time))
+                return false;
+
+            found = true;
+        }
+
+        if (!found || !file.seek(to_ui64(key_value_end)))
+            return false;
+
+        // a corrupt header must not size anything beyond the file
+        auto const size = uv2{ header.pixel_width, header.pixel_height };
+        if (header.mip_levels > mip_level_count(size))
+            return false;
+
+        // every level behind its ui32 image size
+        auto const remaining = to_size_t(file.get_size() - file.tell());
+        if (header.mip_levels * sizeof(ui32) > remaining)
+            return false;
+
+        auto const level_space = remaining - header.mip_levels * sizeof(ui32);
+        auto total_size = size_t(0);
+
+        texture::layer layer;
+
+        for (auto m = 0u; m < header.mip_levels; ++m) {
+            texture::mip_level level;
+            level.extent = { std::max(size.x >> m, 1u), std::max(size.y >> m, 1u) };
+
+            auto const level_size = get_block_data_size(format, level.extent);
+            if (level_size > level_space - total_size)
+                return false;
+
+            level.size = to_ui32(level_size);
+
+            layer.levels.push_back(level);
+            total_size += level_size;
+        }
+
+        result = {};
+        result.size = size;
+        result.format = format;
+        result.type = texture_type::tex_2d;
+        result.layers.push_back(layer);
+
+        data_ptr pixels = nullptr;
+        if (target) {
+            pixels = target(result, total_size);
+        } else {
+            result.pixels.resize(total_size);
+            pixels = result.pixels.data();
+        }
+
+        if (!pixels)
+            return false;
+
+        for (auto const& level : result.layers.front().levels) {
+            ui32 image_size = 0;
+            if (!read_value(file, image_size) || (image_size != level.size))
+                return false;
+
+            if (file.read_next(pixels, level.size) != to_i64(level.size))
+                return false;
+
+            pixels += level.size;
+        }
+
+        return true;
+    }
+
+    string get_texture_cache_path(name filename, VkFormat format) {
+        // a/b_c and a_b/c must not share a file
+        auto const path = fs::path(filename).lexically_normal().generic_string();
+        auto const key = hash64(path.data(), path.size());
+
+        return fmt::format("{}{}.{:016x}.{}{}", file_system::get_pref_dir(), get_filename_from(path), key, to_ui32(format), _ktx_);
+    }
+
+} // namespace lava
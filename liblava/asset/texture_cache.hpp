@@ -0,0 +1,27 @@
+// file      : liblava/asset/texture_cache.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/asset/texture_loader.hpp>
+
+namespace lava {
+
+    constexpr name _ktx_ = ".ktx";
+
+    constexpr ui32 const texture_cache_version = 1;
+
+    // ktx 1.1 with the block compressed chain, source in the key / value data
+    bool write_texture_cache(string_ref filename, texture_data const& data,
+                             i64 source_size = 0, i64 source_time = 0);
+
+    // false -> missing, outdated or not in format
+    bool read_texture_cache(string_ref filename, VkFormat format, texture_data& result,
+                            i64 source_size = 0, i64 source_time = 0,
+                            texture_data::target_func const& target = {});
+
+    // cache file for a file_system path and format in the pref dir
+    string get_texture_cache_path(name filename, VkFormat format);
+
+} // namespace lava
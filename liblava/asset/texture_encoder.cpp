@@ -0,0 +1,731 @@
+// file      : liblava/asset/texture_encoder.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#include <algorithm>
+#include <cmath>
+#include <liblava/asset/texture_encoder.hpp>
+#include <liblava/core/simd.hpp>
+#include <limits>
+
+namespace lava {
+
+    namespace {
+
+        using color = std::array<r32, 4>;
+        using block_indices = std::array<ui8, 16>;
+
+        // 16 texels, channels apart for 4 wide simd
+        struct texel_block {
+            alignas(16) std::array<std::array<r32, 16>, 4> channels;
+        };
+
+        constexpr ui32 const all_texels = 0xffff;
+
+        void load_block(ui8 const* pixels, uv2 size, ui32 block_x, ui32 block_y, texel_block& block) {
+            for (auto y = 0u; y < 4; ++y) {
+                auto const row = std::min(block_y * 4 + y, size.y - 1);
+
+                for (auto x = 0u; x < 4; ++x) {
+                    auto const column = std::min(block_x * 4 + x, size.x - 1);
+                    auto const texel = pixels + (to_size_t(row) * size.x + column) * 4;
+
+                    for (auto c = 0u; c < 4; ++c)
+                        block.channels[c][y * 4 + x] = texel[c];
+                }
+            }
+        }
+
+        // mean and dominant direction of channels [first, first + count), zero axis on flat blocks
+        void principal_axis(texel_block const& block, ui32 first, ui32 count, color& mean, color& axis) {
+            mean = {};
+            axis = {};
+
+            auto const last = first + count;
+
+            for (auto c = first; c < last; ++c) {
+                for (auto i = 0u; i < 16; ++i)
+                    mean[c] += block.channels[c][i];
+
+                mean[c] /= 16.f;
+            }
+
+            std::array<color, 4> covariance = {};
+
+            for (auto i = 0u; i < 16; ++i)
+                for (auto a = first; a < last; ++a)
+                    for (auto b = first; b < last; ++b)
+                        covariance[a][b] += (block.channels[a][i] - mean[a]) * (block.channels[b][i] - mean[b]);
+
+            auto widest = first;
+            for (auto c = first; c < last; ++c)
+                if (covariance[c][c] > covariance[widest][widest])
+                    widest = c;
+
+            if (covariance[widest][widest] <= 0.f)
+                return;
+
+            // power iteration from the widest channel
+            axis = covariance[widest];
+
+            for (auto iteration = 0u; iteration < 8; ++iteration) {
+                color next = {};
+                for (auto a = first; a < last; ++a)
+                    for (auto b = first; b < last; ++b)
+                        next[a] += covariance[a][b] * axis[b];
+
+                auto scale = 0.f;
+                for (auto c = first; c < last; ++c)
+                    scale = std::max(scale, std::abs(next[c]));
+
+                if (scale == 0.f)
+                    break;
+
+                for (auto c = first; c < last; ++c)
+                    axis[c] = next[c] / scale;
+            }
+
+            auto length = 0.f;
+            for (auto c = first; c < last; ++c)
+                length += axis[c] * axis[c];
+
+            length = std::sqrt(length);
+            if (length > 0.f)
+                for (auto c = first; c < last; ++c)
+                    axis[c] /= length;
+        }
+
+        // dot(texel - origin, axis) of all texels
+        void project(texel_block const& block, color const& origin, color const& axis,
+                     ui32 first, ui32 count, std::array<r32, 16>& result) {
+#if LIBLAVA_SIMD_SSE
+            for (auto group = 0u; group < 16; group += 4) {
+                auto sum = _mm_setzero_ps();
+
+                for (auto c = first; c < first + count; ++c) {
+                    auto const value = _mm_sub_ps(_mm_load_ps(&block.channels[c][group]), _mm_set1_ps(origin[c]));
+                    sum = _mm_add_ps(sum, _mm_mul_ps(value, _mm_set1_ps(axis[c])));
+                }
+
+                _mm_storeu_ps(&result[group], sum);
+            }
+#else
+            for (auto i = 0u; i < 16; ++i) {
+                auto sum = 0.f;
+                for (auto c = first; c < first + count; ++c)
+                    sum += (block.channels[c][i] - origin[c]) * axis[c];
+
+                result[i] = sum;
+            }
+#endif
+        }
+
+        // closest palette entry per texel, squared error summed
+        r32 fit_palette(texel_block const& block, color const* palette, ui32 palette_size,
+                        ui32 first, ui32 count, block_indices& indices) {
+#if LIBLAVA_SIMD_SSE
+            auto total = _mm_setzero_ps();
+
+            for (auto group = 0u; group < 16; group += 4) {
+                auto best = _mm_set1_ps(std::numeric_limits<r32>::max());
+                auto best_index = _mm_setzero_si128();
+
+                for (auto p = 0u; p < palette_size; ++p) {
+                    auto error = _mm_setzero_ps();
+
+                    for (auto c = first; c < first + count; ++c) {
+                        auto const delta = _mm_sub_ps(_mm_load_ps(&block.channels[c][group]), _mm_set1_ps(palette[p][c]));
+                        error = _mm_add_ps(error, _mm_mul_ps(delta, delta));
+                    }
+
+                    auto const closer = _mm_castps_si128(_mm_cmplt_ps(error, best));
+                    best = _mm_min_ps(error, best);
+                    best_index = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(to_i32(p))),
+                                              _mm_andnot_si128(closer, best_index));
+                }
+
+                total = _mm_add_ps(total, best);
+
+                alignas(16) std::array<i32, 4> lanes;
+                _mm_store_si128((__m128i*) lanes.data(), best_index);
+
+                for (auto lane = 0u; lane < 4; ++lane)
+                    indices[group + lane] = static_cast<ui8>(lanes[lane]);
+            }
+
+            alignas(16) std::array<r32, 4> sums;
+            _mm_store_ps(sums.data(), total);
+
+            return sums[0] + sums[1] + sums[2] + sums[3];
+#else
+            auto total = 0.f;
+
+            for (auto i = 0u; i < 16; ++i) {
+                auto best = std::numeric_limits<r32>::max();
+
+                for (auto p = 0u; p < palette_size; ++p) {
+                    auto error = 0.f;
+                    for (auto c = first; c < first + count; ++c) {
+                        auto const delta = block.channels[c][i] - palette[p][c];
+                        error += delta * delta;
+                    }
+
+                    if (error < best) {
+                        best = error;
+                        indices[i] = static_cast<ui8>(p);
+                    }
+                }
+
+                total += best;
+            }
+
+            return total;
+#endif
+        }
+
+        // least squares endpoints for fixed indices, weights toward end
+        bool refine_endpoints(texel_block const& block, block_indices const& indices, r32 const* weights,
+                              ui32 first, ui32 count, ui32 texels, color& start, color& end) {
+            auto aa = 0.f;
+            auto ab = 0.f;
+            auto bb = 0.f;
+
+            color ax = {};
+            color bx = {};
+
+            for (auto i = 0u; i < 16; ++i) {
+                if (!(texels & (1u << i)))
+                    continue;
+
+                auto const b = weights[indices[i]];
+                auto const a = 1.f - b;
+
+                aa += a * a;
+                ab += a * b;
+                bb += b * b;
+
+                for (auto c = first; c < first + count; ++c) {
+                    ax[c] += a * block.channels[c][i];
+                    bx[c] += b * block.channels[c][i];
+                }
+            }
+
+            auto const determinant = aa * bb - ab * ab;
+            if (std::abs(determinant) < 1e-6f)
+                return false;
+
+            start = {};
+            end = {};
+
+            for (auto c = first; c < first + count; ++c) {
+                start[c] = std::clamp((bb * ax[c] - ab * bx[c]) / determinant, 0.f, 255.f);
+                end[c] = std::clamp((aa * bx[c] - ab * ax[c]) / determinant, 0.f, 255.f);
+            }
+
+            return true;
+        }
+
+        // endpoints at both ends of the projection onto the axis
+        void axis_endpoints(texel_block const& block, ui32 first, ui32 count, ui32 texels, color& start, color& end) {
+            color mean;
+            color axis;
+            principal_axis(block, first, count, mean, axis);
+
+            std::array<r32, 16> distances;
+            project(block, mean, axis, first, count, distances);
+
+            auto low = std::numeric_limits<r32>::max();
+            auto high = -std::numeric_limits<r32>::max();
+
+            for (auto i = 0u; i < 16; ++i) {
+                if (!(texels & (1u << i)))
+                    continue;
+
+                low = std::min(low, distances[i]);
+                high = std::max(high, distances[i]);
+            }
+
+            if (low > high)
+                low = high = 0.f;
+
+            start = {};
+            end = {};
+
+            for (auto c = first; c < first + count; ++c) {
+                start[c] = std::clamp(mean[c] + axis[c] * low, 0.f, 255.f);
+                end[c] = std::clamp(mean[c] + axis[c] * high, 0.f, 255.f);
+            }
+        }
+
+        color lerp(color const& a, color const& b, r32 t) {
+            return { a[0] + (b[0] - a[0]) * t, a[1] + (b[1] - a[1]) * t,
+                     a[2] + (b[2] - a[2]) * t, a[3] + (b[3] - a[3]) * t };
+        }
+
+        void write_ui16(ui8* target, ui32 value) {
+            target[0] = static_cast<ui8>(value);
+            target[1] = static_cast<ui8>(value >> 8);
+        }
+
+        ui16 pack_565(color const& value) {
+            auto const quantize = [](r32 channel, r32 max) {
+                return to_ui32(std::clamp(std::round(channel * max / 255.f), 0.f, max));
+            };
+
+            return static_cast<ui16>((quantize(value[0], 31.f) << 11) | (quantize(value[1], 63.f) << 5) | quantize(value[2], 31.f));
+        }
+
+        color unpack_565(ui16 value) {
+            auto const r = (value >> 11) & 31u;
+            auto const g = (value >> 5) & 63u;
+            auto const b = value & 31u;
+
+            return { to_r32((r << 3) | (r >> 2)), to_r32((g << 2) | (g >> 4)), to_r32((b << 3) | (b >> 2)), 255.f };
+        }
+
+        // palette order of the indices
+        constexpr std::array<r32, 4> const bc1_weights = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+        constexpr std::array<r32, 3> const bc1_transparent_weights = { 0.f, 1.f, 0.5f };
+
+        // color0 > color1 -> 4 colors, otherwise 3 and transparent black
+        r32 fit_bc1(texel_block const& block, color const& start, color const& end, bool transparent,
+                    ui16& color0, ui16& color1, block_indices& indices) {
+            color0 = pack_565(start);
+            color1 = pack_565(end);
+
+            if (transparent ? (color0 > color1) : (color0 < color1))
+                std::swap(color0, color1);
+
+            auto const first = unpack_565(color0);
+            auto const second = unpack_565(color1);
+
+            std::array<color, 4> palette = { first, second };
+
+            if (transparent) {
+                palette[2] = lerp(first, second, 0.5f);
+            } else {
+                palette[2] = lerp(first, second, 1.f / 3.f);
+                palette[3] = lerp(first, second, 2.f / 3.f);
+            }
+
+            return fit_palette(block, palette.data(), transparent ? 3 : 4, 0, 3, indices);
+        }
+
+        void encode_bc1(texel_block const& block, bool alpha, ui8* result) {
+            auto opaque = all_texels;
+            if (alpha)
+                for (auto i = 0u; i < 16; ++i)
+                    if (block.channels[3][i] < 128.f)
+                        opaque &= ~(1u << i);
+
+            auto const transparent = opaque != all_texels;
+
+            color start;
+            color end;
+            axis_endpoints(block, 0, 3, opaque, start, end);
+
+            ui16 color0 = 0;
+            ui16 color1 = 0;
+            block_indices indices;
+            auto error = fit_bc1(block, start, end, transparent, color0, color1, indices);
+
+            // one least squares pass on the fitted indices
+            auto const weights = transparent ? bc1_transparent_weights.data() : bc1_weights.data();
+
+            if ((opaque != 0) && refine_endpoints(block, indices, weights, 0, 3, opaque, start, end)) {
+                ui16 refined0 = 0;
+                ui16 refined1 = 0;
+                block_indices refined_indices;
+
+                auto const refined_error = fit_bc1(block, start, end, transparent, refined0, refined1, refined_indices);
+                if (refined_error < error) {
+                    error = refined_error;
+                    color0 = refined0;
+                    color1 = refined1;
+                    indices = refined_indices;
+                }
+            }
+
+            ui32 bits = 0;
+            for (auto i = 0u; i < 16; ++i) {
+                auto const index = (opaque & (1u << i)) ? indices[i] : 3u;
+                bits |= index << (i * 2);
+            }
+
+            write_ui16(result, color0);
+            write_ui16(result + 2, color1);
+            write_ui16(result + 4, bits);
+            write_ui16(result + 6, bits >> 16);
+        }
+
+        // bc4 layout, 8 values between max and min
+        void encode_alpha(texel_block const& block, ui8* result) {
+            auto low = 255.f;
+            auto high = 0.f;
+
+            for (auto i = 0u; i < 16; ++i) {
+                low = std::min(low, block.channels[3][i]);
+                high = std::max(high, block.channels[3][i]);
+            }
+
+            auto const alpha0 = to_ui32(high);
+            auto const alpha1 = to_ui32(low);
+
+            result[0] = static_cast<ui8>(alpha0);
+            result[1] = static_cast<ui8>(alpha1);
+
+            ui64 bits = 0;
+
+            if (alpha0 > alpha1) {
+                std::array<color, 8> palette = {};
+                palette[0][3] = to_r32(alpha0);
+                palette[1][3] = to_r32(alpha1);
+
+                for (auto i = 2u; i < 8; ++i)
+                    palette[i][3] = to_r32(((8 - i) * alpha0 + (i - 1) * alpha1) / 7);
+
+                block_indices indices;
+                fit_palette(block, palette.data(), 8, 3, 1, indices);
+
+                for (auto i = 0u; i < 16; ++i)
+                    bits |= ui64(indices[i]) << (i * 3);
+            }
+
+            for (auto i = 0u; i < 6; ++i)
+                result[2 + i] = static_cast<ui8>(bits >> (i * 8));
+        }
+
+        void encode_bc3(texel_block const& block, ui8* result) {
+            encode_alpha(block, result);
+            encode_bc1(block, false, result + 8);
+        }
+
+        struct bit_writer {
+            explicit bit_writer(ui8* data)
+            : data(data) {}
+
+            void write(ui32 value, ui32 count) {
+                for (auto i = 0u; i < count; ++i, ++position)
+                    if ((value >> i) & 1u)
+                        data[position >> 3] |= static_cast<ui8>(1u << (position & 7));
+            }
+
+        private:
+            ui8* data = nullptr;
+            ui32 position = 0;
+        };
+
+        constexpr std::array<ui32, 16> const bc7_weights = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        struct bc7_endpoint {
+            std::array<ui32, 4> value = {}; // 7 bit
+            ui32 pbit = 0;
+
+            ui32 expand(ui32 channel) const {
+                return (value[channel] << 1) | pbit;
+            }
+        };
+
+        // closer of both p bits
+        bc7_endpoint quantize_bc7(color const& value) {
+            bc7_endpoint result;
+            auto best = std::numeric_limits<r32>::max();
+
+            for (auto pbit = 0u; pbit < 2; ++pbit) {
+                bc7_endpoint candidate;
+                candidate.pbit = pbit;
+
+                auto error = 0.f;
+                for (auto c = 0u; c < 4; ++c) {
+                    candidate.value[c] = to_ui32(std::clamp(std::round((value[c] - to_r32(pbit)) * 0.5f), 0.f, 127.f));
+
+                    auto const delta = to_r32(candidate.expand(c)) - value[c];
+                    error += delta * delta;
+                }
+
+                if (error < best) {
+                    best = error;
+                    result = candidate;
+                }
+            }
+
+            return result;
+        }
+
+        r32 fit_bc7(texel_block const& block, color const& start, color const& end,
+                    bc7_endpoint& endpoint0, bc7_endpoint& endpoint1, block_indices& indices) {
+            endpoint0 = quantize_bc7(start);
+            endpoint1 = quantize_bc7(end);
+
+            std::array<color, 16> palette;
+            for (auto i = 0u; i < 16; ++i)
+                for (auto c = 0u; c < 4; ++c)
+                    palette[i][c] = to_r32(((64 - bc7_weights[i]) * endpoint0.expand(c) + bc7_weights[i] * endpoint1.expand(c) + 32) >> 6);
+
+            return fit_palette(block, palette.data(), 16, 0, 4, indices);
+        }
+
+        // mode 6 only: one subset, rgba 7.7.7.7 with p bits, 4 bit indices
+        void encode_bc7(texel_block const& block, ui8* result) {
+            color start;
+            color end;
+            axis_endpoints(block, 0, 4, all_texels, start, end);
+
+            bc7_endpoint endpoint0;
+            bc7_endpoint endpoint1;
+            block_indices indices;
+            auto const error = fit_bc7(block, start, end, endpoint0, endpoint1, indices);
+
+            std::array<r32, 16> weights;
+            for (auto i = 0u; i < 16; ++i)
+                weights[i] = to_r32(bc7_weights[i]) / 64.f;
+
+            if (refine_endpoints(block, indices, weights.data(), 0, 4, all_texels, start, end)) {
+                bc7_endpoint refined0;
+                bc7_endpoint refined1;
+                block_indices refined_indices;
+
+                if (fit_bc7(block, start, end, refined0, refined1, refined_indices) < error) {
+                    endpoint0 = refined0;
+                    endpoint1 = refined1;
+                    indices = refined_indices;
+                }
+            }
+
+            // anchor texel index without its top bit
+            if (indices[0] >= 8) {
+                std::swap(endpoint0, endpoint1);
+                for (auto& index : indices)
+                    index = static_cast<ui8>(15 - index);
+            }
+
+            std::fill_n(result, 16, ui8(0));
+
+            bit_writer writer(result);
+            writer.write(1u << 6, 7);
+
+            for (auto c = 0u; c < 4; ++c) {
+                writer.write(endpoint0.value[c], 7);
+                writer.write(endpoint1.value[c], 7);
+            }
+
+            writer.write(endpoint0.pbit, 1);
+            writer.write(endpoint1.pbit, 1);
+
+            writer.write(indices[0], 3);
+            for (auto i = 1u; i < 16; ++i)
+                writer.write(indices[i], 4);
+        }
+
+        void encode_bc1_rgb(texel_block const& block, ui8* result) {
+            encode_bc1(block, false, result);
+        }
+
+        void encode_bc1_rgba(texel_block const& block, ui8* result) {
+            encode_bc1(block, true, result);
+        }
+
+        using encode_func = void (*)(texel_block const&, ui8*);
+
+        encode_func get_encode_func(VkFormat format) {
+            switch (format) {
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+                return encode_bc1_rgb;
+
+            case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+                return encode_bc1_rgba;
+
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+                return encode_bc3;
+
+            case VK_FORMAT_BC7_UNORM_BLOCK:
+            case VK_FORMAT_BC7_SRGB_BLOCK:
+                return encode_bc7;
+
+            default:
+                return nullptr;
+            }
+        }
+
+        // 2x2 box, odd edges clamped
+        void downsample(ui8 const* pixels, uv2 size, std::vector<char>& result) {
+            uv2 const next = { std::max(size.x >> 1, 1u), std::max(size.y >> 1, 1u) };
+            result.resize(to_size_t(next.x) * next.y * 4);
+
+            auto target = reinterpret_cast<ui8*>(result.data());
+
+            for (auto y = 0u; y < next.y; ++y) {
+                auto const row0 = pixels + to_size_t(std::min(y * 2, size.y - 1)) * size.x * 4;
+                auto const row1 = pixels + to_size_t(std::min(y * 2 + 1, size.y - 1)) * size.x * 4;
+
+                for (auto x = 0u; x < next.x; ++x) {
+                    auto const column0 = to_size_t(std::min(x * 2, size.x - 1)) * 4;
+                    auto const column1 = to_size_t(std::min(x * 2 + 1, size.x - 1)) * 4;
+
+                    for (auto c = 0u; c < 4; ++c) {
+                        auto const sum = row0[column0 + c] + row0[column1 + c] + row1[column0 + c] + row1[column1 + c];
+                        *target++ = static_cast<ui8>((sum + 2) >> 2);
+                    }
+                }
+            }
+        }
+
+    } // namespace
+
+    bool block_encoder_supported(VkFormat format) {
+        return get_encode_func(format) != nullptr;
+    }
+
+    ui32 get_encoder_block_size(VkFormat format) {
+        switch (format) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            return 8;
+
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            return 16;
+
+        default:
+            return 0;
+        }
+    }
+
+    size_t get_block_data_size(VkFormat format, uv2 size) {
+        return to_size_t(ceil_div(size.x, 4u)) * ceil_div(size.y, 4u) * get_encoder_block_size(format);
+    }
+
+    bool encode_blocks(VkFormat format, data_cptr pixels, uv2 size, data_ptr result, task_scheduler* scheduler) {
+        auto const encode = get_encode_func(format);
+        if (!encode || !pixels || !result || (size.x == 0) || (size.y == 0))
+            return false;
+
+        auto const block_size = get_encoder_block_size(format);
+        auto const blocks_x = ceil_div(size.x, 4u);
+        auto const blocks_y = ceil_div(size.y, 4u);
+
+        auto const encode_row = [&](index row) {
+            texel_block block;
+
+            for (auto column = 0u; column < blocks_x; ++column) {
+                load_block(reinterpret_cast<ui8 const*>(pixels), size, column, row, block);
+                encode(block, reinterpret_cast<ui8*>(result) + (to_size_t(row) * blocks_x + column) * block_size);
+            }
+        };
+
+        if (scheduler && (scheduler->get_worker_count() > 0) && (blocks_y > 1)) {
+            scheduler->parallel_for(0, blocks_y, encode_row);
+        } else {
+            for (auto row = 0u; row < blocks_y; ++row)
+                encode_row(row);
+        }
+
+        return true;
+    }
+
+    bool encode_texture(texture_data const& source, VkFormat format, texture_data& result, task_scheduler* scheduler) {
+        if (!block_encoder_supported(format)) {
+            log()->error("encode texture - format {} not supported", to_ui32(format));
+            return false;
+        }
+
+        if ((source.format != VK_FORMAT_R8G8B8A8_UNORM) || (source.type != texture_type::tex_2d)
+            || (source.pixels.size() < to_size_t(source.size.x) * source.size.y * 4)) {
+            log()->error("encode texture - rgba8 2d source only");
+            return false;
+        }
+
+        result = {};
+        result.size = source.size;
+        result.format = format;
+        result.type = texture_type::tex_2d;
+
+        // chain only when the source wanted it generated
+        auto const level_count = source.mip_levels_generation ? mip_level_count(source.size) : 1u;
+
+        texture::layer layer;
+        auto total_size = size_t(0);
+
+        for (auto level = 0u; level < level_count; ++level) {
+            texture::mip_level mip;
+            mip.extent = { std::max(source.size.x >> level, 1u), std::max(source.size.y >> level, 1u) };
+            mip.size = to_ui32(get_block_data_size(format, mip.extent));
+
+            layer.levels.push_back(mip);
+            total_size += mip.size;
+        }
+
+        result.pixels.resize(total_size);
+
+        auto pixels = source.pixels.data();
+        std::vector<char> current;
+        std::vector<char> next;
+
+        auto offset = size_t(0);
+
+        for (auto level = 0u; level < level_count; ++level) {
+            auto const& mip = layer.levels[level];
+
+            if (!encode_blocks(format, pixels, mip.extent, result.pixels.data() + offset, scheduler))
+                return false;
+
+            offset += mip.size;
+
+            if (level + 1 < level_count) {
+                downsample(reinterpret_cast<ui8 const*>(pixels), mip.extent, next);
+
+                std::swap(current, next);
+                pixels = current.data();
+            }
+        }
+
+        result.layers.push_back(layer);
+        return true;
+    }
+
+    bool generate_mip_chain(texture_data& data) {
+        if ((data.format != VK_FORMAT_R8G8B8A8_UNORM) || (data.type != texture_type::tex_2d)
+            || (data.pixels.size() < to_size_t(data.size.x) * data.size.y * 4))
+            return false;
+
+        auto const level_count = mip_level_count(data.size);
+
+        texture::layer layer;
+
+        texture::mip_level mip;
+        mip.extent = data.size;
+        mip.size = to_ui32(to_size_t(data.size.x) * data.size.y * 4);
+
+        data.pixels.resize(mip.size);
+        layer.levels.push_back(mip);
+
+        std::vector<char> next;
+        auto offset = size_t(0);
+
+        for (auto level = 1u; level < level_count; ++level) {
+            auto const& previous = layer.levels.back();
+            downsample(reinterpret_cast<ui8 const*>(data.pixels.data()) + offset, previous.extent, next);
+
+            offset += previous.size;
+
+            mip.extent = { std::max(data.size.x >> level, 1u), std::max(data.size.y >> level, 1u) };
+            mip.size = to_ui32(next.size());
+
+            layer.levels.push_back(mip);
+            data.pixels.insert(data.pixels.end(), next.begin(), next.end());
+        }
+
+        data.layers = { layer };
+        data.mip_levels_generation = false;
+
+        return true;
+    }
+
+} // namespace lava
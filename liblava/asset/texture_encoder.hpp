@@ -0,0 +1,32 @@
+// file      : liblava/asset/texture_encoder.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/asset/texture_loader.hpp>
+#include <liblava/util/scheduler.hpp>
+
+namespace lava {
+
+    // bc1 rgb / rgba, bc3 and bc7 (mode 6) from rgba8
+    bool block_encoder_supported(VkFormat format);
+
+    // bytes of a 4x4 block, 0 -> not written by the encoder
+    ui32 get_encoder_block_size(VkFormat format);
+
+    size_t get_block_data_size(VkFormat format, uv2 size);
+
+    // rgba8 rows without padding, edge blocks clamped
+    // block rows in parallel with a scheduler, sse when compiled for it
+    bool encode_blocks(VkFormat format, data_cptr pixels, uv2 size, data_ptr result,
+                       task_scheduler* scheduler = nullptr);
+
+    // rgba8 level 0 -> box filtered chain, every level block compressed
+    bool encode_texture(texture_data const& source, VkFormat format, texture_data& result,
+                        task_scheduler* scheduler = nullptr);
+
+    // rgba8 level 0 -> box filtered chain in place, nothing generated at stage
+    bool generate_mip_chain(texture_data& data);
+
+} // namespace lava
@@ -3,6 +3,8 @@
 // license   : MIT; see accompanying LICENSE file
 
 #include <bitmap_image.hpp>
+#include <liblava/asset/texture_cache.hpp>
+#include <liblava/asset/texture_encoder.hpp>
 #include <liblava/asset/texture_loader.hpp>
 #include <liblava/file.hpp>
 #include <selene/img/pixel/PixelTypeAliases.hpp>
@@ -36,12 +38,43 @@
 
 namespace lava {
 
-    texture::ptr create_gli_texture_2d(device_ptr device, file const& file, VkFormat format, scope_data const& temp_data) {
-        gli::texture2d tex(file.opened() ? gli::load(temp_data.ptr, temp_data.size)
-                                         : gli::load(file.get_path()));
-        assert(!tex.empty());
+    data_ptr get_pixel_target(texture_data& result, size_t size, texture_data::target_func const& target) {
+        if (target)
+            return target(result, size);
+
+        result.pixels.resize(size);
+        return result.pixels.data();
+    }
+
+    // files on disk straight through gli, archives from memory
+    gli::texture load_gli(file& file) {
+        if (file.get_type() != file_type::fs)
+            return gli::load(file.get_path());
+
+        scope_data temp_data(file.get_size());
+        if (!temp_data.ptr || file_error(file.read(temp_data.ptr)))
+            return {};
+
+        return gli::load(temp_data.ptr, temp_data.size);
+    }
+
+    // raw texels of the whole chain, one copy to the target
+    template<typename T>
+    bool write_gli_pixels(T const& tex, texture_data& result, texture_data::target_func const& target) {
+        result.size = { tex[0].extent().x, tex[0].extent().y };
+
+        auto pixels = get_pixel_target(result, tex.size(), target);
+        if (!pixels)
+            return false;
+
+        memcpy(pixels, tex.data(), tex.size());
+        return true;
+    }
+
+    bool decode_gli_texture_2d(gli::texture const& source, texture_data& result, texture_data::target_func const& target) {
+        gli::texture2d tex(source);
         if (tex.empty())
-            return nullptr;
+            return false;
 
         auto mip_levels = to_ui32(tex.levels());
 
@@ -55,19 +88,9 @@ namespace lava {
             layer.levels.push_back(level);
         }
 
-        texture::layer::list layers;
-        layers.push_back(layer);
-
-        auto texture = make_texture();
+        result.layers.push_back(layer);
 
-        uv2 size = { tex[0].extent().x, tex[0].extent().y };
-        if (!texture->create(device, size, format, layers, texture_type::tex_2d))
-            return nullptr;
-
-        if (!texture->upload(tex.data(), tex.size()))
-            return nullptr;
-
-        return texture;
+        return write_gli_pixels(tex, result, target);
     }
 
     template<typename T>
@@ -93,85 +116,147 @@ namespace lava {
         return layers;
     }
 
-    texture::ptr create_gli_texture_array(device_ptr device, file const& file, VkFormat format, scope_data const& temp_data) {
-        gli::texture2d_array tex(file.opened() ? gli::load(temp_data.ptr, temp_data.size)
-                                               : gli::load(file.get_path()));
-        assert(!tex.empty());
+    bool decode_gli_texture_array(gli::texture const& source, texture_data& result, texture_data::target_func const& target) {
+        gli::texture2d_array tex(source);
         if (tex.empty())
-            return nullptr;
+            return false;
 
-        auto layers = create_layer_list(tex, to_ui32(tex.layers()));
+        result.layers = create_layer_list(tex, to_ui32(tex.layers()));
 
-        auto texture = make_texture();
+        return write_gli_pixels(tex, result, target);
+    }
 
-        uv2 size = { tex[0].extent().x, tex[0].extent().y };
-        if (!texture->create(device, size, format, layers, texture_type::array))
-            return nullptr;
+    bool decode_gli_texture_cube_map(gli::texture const& source, texture_data& result, texture_data::target_func const& target) {
+        gli::texture_cube tex(source);
+        if (tex.empty())
+            return false;
 
-        if (!texture->upload(tex.data(), tex.size()))
-            return nullptr;
+        result.layers = create_layer_list(tex, to_ui32(tex.faces()));
 
-        return texture;
+        return write_gli_pixels(tex, result, target);
     }
 
-    texture::ptr create_gli_texture_cube_map(device_ptr device, file const& file, VkFormat format, scope_data const& temp_data) {
-        gli::texture_cube tex(file.opened() ? gli::load(temp_data.ptr, temp_data.size)
-                                            : gli::load(file.get_path()));
-        assert(!tex.empty());
-        if (tex.empty())
-            return nullptr;
+    // stbi pulls the encoded image through the file, no copy of it
+    int stbi_file_read(void* user, char* data, int size) {
+        auto const result = static_cast<file*>(user)->read_next(data, to_ui64(size));
+        return file_error(result) ? 0 : to_i32(result);
+    }
 
-        auto layers = create_layer_list(tex, to_ui32(tex.faces()));
+    void stbi_file_skip(void* user, int count) {
+        auto& file = *static_cast<lava::file*>(user);
+        file.seek(to_ui64(file.tell() + count));
+    }
 
-        auto texture = make_texture();
+    int stbi_file_eof(void* user) {
+        auto& file = *static_cast<lava::file*>(user);
+        return file.tell() >= file.get_size() ? 1 : 0;
+    }
 
-        uv2 size = { tex[0].extent().x, tex[0].extent().y };
-        if (!texture->create(device, size, format, layers, texture_type::cube_map))
-            return nullptr;
+    bool decode_stbi_texture(file& file, texture_data& result, texture_data::target_func const& target) {
+        stbi_io_callbacks const callbacks{
+            .read = stbi_file_read,
+            .skip = stbi_file_skip,
+            .eof = stbi_file_eof,
+        };
 
-        if (!texture->upload(tex.data(), tex.size()))
-            return nullptr;
+        i32 tex_width = 0, tex_height = 0;
+        auto data = stbi_load_from_callbacks(&callbacks, &file, &tex_width, &tex_height, nullptr, STBI_rgb_alpha);
+        if (!data)
+            return false;
+
+        // level 0 only in the file, chain generated at stage
+        result.size = { tex_width, tex_height };
+        result.format = VK_FORMAT_R8G8B8A8_UNORM;
+        result.type = texture_type::tex_2d;
+        result.mip_levels_generation = true;
 
-        return texture;
+        auto const tex_channels = 4;
+        auto const pixel_size = to_size_t(tex_width) * tex_height * tex_channels;
+
+        auto pixels = get_pixel_target(result, pixel_size, target);
+        if (pixels)
+            memcpy(pixels, data, pixel_size);
+
+        stbi_image_free(data);
+
+        return pixels != nullptr;
     }
 
-    texture::ptr create_stbi_texture(device_ptr device, file const& file, scope_data const& temp_data) {
-        i32 tex_width = 0, tex_height = 0;
-        stbi_uc* data = nullptr;
+    // image source -> encoded on the cpu, cache written to the pref dir when mounted
+    bool decode_encoded_texture(file_format filename, texture_data& result, task_scheduler* scheduler,
+                                texture_data::target_func const& target) {
+        i64 source_size = 0;
+        {
+            file file(str(filename.path));
+            if (!file.opened())
+                return false;
 
-        if (file.opened())
-            data = stbi_load_from_memory((stbi_uc const*) temp_data.ptr, to_i32(temp_data.size),
-                                         &tex_width, &tex_height, nullptr, STBI_rgb_alpha);
-        else
-            data = stbi_load(str(file.get_path()), &tex_width, &tex_height, nullptr, STBI_rgb_alpha);
+            source_size = file.get_size();
+        }
 
-        if (!data)
-            return nullptr;
+        auto const source_time = file_system::get_last_modified(str(filename.path));
+        auto const cache_ready = file_system::instance().ready();
 
-        auto texture = make_texture();
+        if (cache_ready) {
+            auto const cache_file = get_texture_cache_path(str(filename.path), filename.format);
 
-        uv2 size = { tex_width, tex_height };
-        if (!texture->create(device, size, VK_FORMAT_R8G8B8A8_UNORM))
-            return nullptr;
+            if (read_texture_cache(cache_file, filename.format, result, source_size, source_time, target)) {
+                log()->debug("load texture {} - cache {}", filename.path, cache_file);
+                return true;
+            }
+        }
 
-        auto const tex_channels = 4;
-        auto uploadSize = tex_width * tex_height * tex_channels * sizeof(char);
-        auto result = texture->upload(data, uploadSize);
+        texture_data source;
+        if (!decode_texture({ filename.path, VK_FORMAT_R8G8B8A8_UNORM }, source))
+            return false;
 
-        stbi_image_free(data);
+        texture_data encoded;
+        if (!encode_texture(source, filename.format, encoded, scheduler))
+            return false;
 
-        if (!result)
-            return nullptr;
+        if (cache_ready)
+            write_texture_cache(get_texture_cache_path(str(filename.path), filename.format),
+                                encoded, source_size, source_time);
+
+        if (target) {
+            auto pixels = target(encoded, encoded.pixels.size());
+            if (!pixels)
+                return false;
 
-        return texture;
+            memcpy(pixels, encoded.pixels.data(), encoded.pixels.size());
+            encoded.pixels.clear();
+        }
+
+        result = std::move(encoded);
+        return true;
+    }
+
+    // containers carry their own format, only images go through the encoder
+    bool decode_texture_source(file_format filename, texture_data& result, texture_type type, task_scheduler* scheduler,
+                               texture_data::target_func const& target) {
+        if (block_encoder_supported(filename.format) && (type == texture_type::tex_2d)
+            && !extension(str(filename.path), { "DDS", "KTX", "KMG" }))
+            return decode_encoded_texture(filename, result, scheduler, target);
+
+        return decode_texture(filename, result, type, target);
     }
 
 } // namespace lava
 
-lava::texture::ptr lava::load_texture(device_ptr device, file_format filename, texture_type type) {
-    auto supported = (filename.format == VK_FORMAT_R8G8B8A8_UNORM) || (device->get_features().textureCompressionBC && (filename.format == VK_FORMAT_BC3_UNORM_BLOCK)) || (device->get_features().textureCompressionASTC_LDR && (filename.format == VK_FORMAT_ASTC_8x8_UNORM_BLOCK)) || (device->get_features().textureCompressionETC2 && (filename.format == VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK));
-    if (!supported)
-        return nullptr;
+bool lava::texture_format_supported(device_ptr device, VkFormat format) {
+    auto const& features = device->get_features();
+
+    return (format == VK_FORMAT_R8G8B8A8_UNORM)
+           || (features.textureCompressionBC && ((format == VK_FORMAT_BC3_UNORM_BLOCK) || block_encoder_supported(format)))
+           || (features.textureCompressionASTC_LDR && (format == VK_FORMAT_ASTC_8x8_UNORM_BLOCK))
+           || (features.textureCompressionETC2 && (format == VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK));
+}
+
+bool lava::decode_texture(file_format filename, texture_data& result, texture_type type,
+                          texture_data::target_func const& target) {
+    result = {};
+    result.format = filename.format;
+    result.type = type;
 
     auto use_gli = extension(str(filename.path), { "DDS", "KTX", "KMG" });
     auto use_stbi = false;
@@ -180,40 +265,75 @@ lava::texture::ptr lava::load_texture(device_ptr device, file_format filename, t
         use_stbi = extension(str(filename.path), { "JPG", "PNG", "TGA", "BMP", "PSD", "GIF", "HDR", "PIC" });
 
     if (!use_gli && !use_stbi)
-        return nullptr;
+        return false;
 
     file file(str(filename.path));
-    scope_data temp_data(file.get_size(), false);
 
-    if (file.opened()) {
-        if (!temp_data.allocate())
-            return nullptr;
+    if (use_stbi)
+        return file.opened() && decode_stbi_texture(file, result, target);
 
-        if (file_error(file.read(temp_data.ptr)))
-            return nullptr;
+    auto const source = load_gli(file);
+    if (source.empty())
+        return false;
+
+    switch (type) {
+    case texture_type::tex_2d:
+        return decode_gli_texture_2d(source, result, target);
+
+    case texture_type::array:
+        return decode_gli_texture_array(source, result, target);
+
+    case texture_type::cube_map:
+        return decode_gli_texture_cube_map(source, result, target);
     }
 
-    if (use_gli) {
-        texture::layer::list layers;
+    return false;
+}
 
-        switch (type) {
-        case texture_type::tex_2d: {
-            return create_gli_texture_2d(device, file, filename.format, temp_data);
-        }
+lava::texture::ptr lava::create_texture(device_ptr device, texture_data const& data) {
+    if (data.pixels.empty())
+        return nullptr;
 
-        case texture_type::array: {
-            return create_gli_texture_array(device, file, filename.format, temp_data);
-        }
+    auto texture = make_texture();
 
-        case texture_type::cube_map: {
-            return create_gli_texture_cube_map(device, file, filename.format, temp_data);
-        }
-        }
-    } else {
-        return create_stbi_texture(device, file, temp_data);
-    }
+    if (!texture->create(device, data.size, data.format, data.layers, data.type, data.mip_levels_generation))
+        return nullptr;
+
+    if (!texture->upload(data.pixels.data(), data.pixels.size()))
+        return nullptr;
+
+    return texture;
+}
+
+VkFormat lava::select_texture_format(device_ptr device, bool alpha) {
+    if (!device->get_features().textureCompressionBC)
+        return VK_FORMAT_R8G8B8A8_UNORM;
+
+    return alpha ? VK_FORMAT_BC7_UNORM_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+}
+
+bool lava::load_texture_data(file_format filename, texture_data& result, texture_type type, task_scheduler* scheduler,
+                             texture_data::target_func const& target) {
+    return decode_texture_source(filename, result, type, scheduler, target);
+}
+
+lava::texture::ptr lava::load_texture(device_ptr device, file_format filename, texture_type type, task_scheduler* scheduler) {
+    if (!texture_format_supported(device, filename.format))
+        return nullptr;
+
+    texture::ptr result;
+
+    // decoded straight into the mapped upload buffer
+    texture_data data;
+    auto const decoded = decode_texture_source(filename, data, type, scheduler, [&](texture_data const& header, size_t size) -> data_ptr {
+        result = make_texture();
+        if (!result->create(device, header.size, header.format, header.layers, header.type, header.mip_levels_generation))
+            return nullptr;
+
+        return result->map_upload(size);
+    });
 
-    return nullptr;
+    return decoded ? result : nullptr;
 }
 
 lava::texture::ptr lava::create_default_texture(device_ptr device, uv2 size) {
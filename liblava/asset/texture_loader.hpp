@@ -5,10 +5,44 @@
 #pragma once
 
 #include <liblava/resource/texture.hpp>
+#include <liblava/util/scheduler.hpp>
 
 namespace lava {
 
-    texture::ptr load_texture(device_ptr device, file_format filename, texture_type type = texture_type::tex_2d);
+    // decoded on the cpu, no device needed
+    struct texture_data {
+        // header known -> memory for size bytes of pixels, nullptr fails the decode
+        using target_func = std::function<data_ptr(texture_data const&, size_t)>;
+
+        uv2 size = uv2(0);
+        VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+        texture_type type = texture_type::tex_2d;
+        texture::layer::list layers;
+        bool mip_levels_generation = false;
+
+        std::vector<char> pixels; // empty with a target
+    };
+
+    bool texture_format_supported(device_ptr device, VkFormat format);
+
+    // block compressed when the device samples bc, rgba8 otherwise
+    VkFormat select_texture_format(device_ptr device, bool alpha = true);
+
+    // any thread, target -> pixels written there instead
+    bool decode_texture(file_format filename, texture_data& result, texture_type type = texture_type::tex_2d,
+                        texture_data::target_func const& target = {});
+
+    texture::ptr create_texture(device_ptr device, texture_data const& data);
+
+    // any thread, cpu part of load_texture into pixels, see create_texture
+    // target -> pixels written there instead, e.g. into a mapped upload buffer
+    bool load_texture_data(file_format filename, texture_data& result, texture_type type = texture_type::tex_2d,
+                           task_scheduler* scheduler = nullptr, texture_data::target_func const& target = {});
+
+    // decoded into the mapped upload buffer, stage or add to staging
+    // images to an encoder format compressed once, then read from the pref dir cache
+    texture::ptr load_texture(device_ptr device, file_format filename, texture_type type = texture_type::tex_2d,
+                              task_scheduler* scheduler = nullptr);
 
     inline texture::ptr load_texture(device_ptr device, string_ref filename,
                                      VkFormat format = VK_FORMAT_R8G8B8A8_UNORM, texture_type type = texture_type::tex_2d) {
@@ -0,0 +1,278 @@
+// file      : liblava/asset/texture_stream.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#include <algorithm>
+#include <cmath>
+#include <liblava/asset/texture_encoder.hpp>
+#include <liblava/asset/texture_stream.hpp>
+
+namespace lava {
+
+    ui32 get_stream_level(uv2 size, r32 screen_extent) {
+        auto const extent = to_r32(std::max(size.x, size.y));
+        if (screen_extent >= extent)
+            return 0;
+
+        if (screen_extent <= 1.f)
+            return mip_level_count(size) - 1;
+
+        return std::min(to_ui32(std::floor(std::log2(extent / screen_extent))), mip_level_count(size) - 1);
+    }
+
+    bool texture_stream::create(device_ptr d, lava::staging& st, index fc, config const& value, task_scheduler* s) {
+        device = d;
+        staging = &st;
+        frame_count = fc;
+        settings = value;
+        scheduler = s;
+
+        return device != nullptr;
+    }
+
+    void texture_stream::destroy() {
+        if (!device)
+            return;
+
+        // caller waits for the device before
+        for (auto& texture : textures)
+            if (texture->resident)
+                texture->resident->destroy();
+
+        for (auto& item : retired_textures)
+            item.texture->destroy();
+
+        textures.clear();
+        retired_textures.clear();
+
+        resident_size = 0;
+        retired_size = 0;
+
+        device = nullptr;
+        staging = nullptr;
+        scheduler = nullptr;
+    }
+
+    streamed_texture::ptr texture_stream::add(file_format filename) {
+        // images to a block format from the pref dir cache, encoded once on the scheduler
+        texture_data data;
+        if (!load_texture_data(filename, data, texture_type::tex_2d, scheduler)) {
+            log()->error("texture stream - load {}", filename.path);
+            return nullptr;
+        }
+
+        return add(std::move(data), filename.path);
+    }
+
+    streamed_texture::ptr texture_stream::add(texture_data data, string_ref path) {
+        if (data.mip_levels_generation && !generate_mip_chain(data)) {
+            log()->error("texture stream - {} without chain", path);
+            return nullptr;
+        }
+
+        if ((data.type != texture_type::tex_2d) || (data.layers.size() != 1) || data.pixels.empty()) {
+            log()->error("texture stream - {} not a 2d texture", path);
+            return nullptr;
+        }
+
+        auto result = std::make_shared<streamed_texture>();
+        result->source = std::move(data);
+        result->path = path;
+
+        auto const& levels = result->source.layers.front().levels;
+
+        auto offset = size_t(0);
+        for (auto const& level : levels) {
+            result->level_offsets.push_back(offset);
+            offset += level.size;
+        }
+
+        if (offset > result->source.pixels.size()) {
+            log()->error("texture stream - {} levels out of data", path);
+            return nullptr;
+        }
+
+        result->source.pixels.resize(offset);
+
+        auto tail_level = to_ui32(levels.size()) - 1;
+        while ((tail_level > 0) && (std::max(levels[tail_level - 1].extent.x, levels[tail_level - 1].extent.y) <= settings.tail_extent))
+            --tail_level;
+
+        result->tail_level = tail_level;
+        result->target_level = tail_level;
+        result->requested_level = tail_level;
+
+        if (!make_resident(*result, tail_level))
+            return nullptr;
+
+        textures.push_back(result);
+        return result;
+    }
+
+    void texture_stream::remove(streamed_texture::ptr const& texture) {
+        auto const it = std::find(textures.begin(), textures.end(), texture);
+        if (it == textures.end())
+            return;
+
+        resident_size -= texture->resident_size;
+        retire(texture->resident, texture->resident_size);
+
+        texture->resident = nullptr;
+        texture->resident_size = 0;
+
+        textures.erase(it);
+    }
+
+    void texture_stream::request(streamed_texture& texture, ui32 level) {
+        texture.requested_level = std::min(texture.requested_level, level);
+        texture.request_frame = frame;
+    }
+
+    void texture_stream::update() {
+        ++frame;
+        uploaded_size = 0;
+
+        // replaced textures may still be read by frames in flight
+        while (!retired_textures.empty() && (retired_textures.front().frame + frame_count < frame)) {
+            retired_textures.front().texture->destroy();
+            retired_size -= retired_textures.front().size;
+            retired_textures.pop_front();
+        }
+
+        for (auto& texture : textures) {
+            if (texture->requested_level < texture->tail_level)
+                texture->target_level = texture->requested_level;
+            else if (texture->request_frame + settings.keep_frames < frame)
+                texture->target_level = texture->tail_level;
+
+            texture->requested_level = texture->tail_level;
+        }
+
+        // coarser first, frees memory for the finer ones once retired
+        for (auto& texture : textures)
+            if (texture->resident_level < texture->target_level)
+                make_resident(*texture, texture->target_level);
+
+        // retired bytes go away by themselves, dropping cannot free them sooner
+        while ((settings.budget > 0) && (resident_size > settings.budget) && drop_level(nullptr, frame + 1))
+            continue;
+
+        streamed_texture::list candidates;
+        for (auto& texture : textures)
+            if (texture->target_level < texture->resident_level)
+                candidates.push_back(texture);
+
+        // largest gap, then most recently requested
+        std::sort(candidates.begin(), candidates.end(), [](auto const& a, auto const& b) {
+            auto const gap_a = a->resident_level - a->target_level;
+            auto const gap_b = b->resident_level - b->target_level;
+            if (gap_a != gap_b)
+                return gap_a > gap_b;
+
+            return a->request_frame > b->request_frame;
+        });
+
+        for (auto& texture : candidates) {
+            if ((uploaded_size > 0) && (uploaded_size >= settings.upload_budget))
+                break;
+
+            auto level = texture->target_level;
+
+            if (settings.budget > 0) {
+                auto fits = [&](ui32 value) {
+                    return resident_size - texture->resident_size + get_level_size(*texture, value) <= settings.budget;
+                };
+
+                while (!fits(level) && drop_level(texture.get(), texture->request_frame))
+                    continue;
+
+                // replaced and dropped images stay alive for the frames in flight
+                auto fits_now = [&](ui32 value) {
+                    return resident_size + retired_size + get_level_size(*texture, value) <= settings.budget;
+                };
+
+                while ((level < texture->resident_level) && !fits_now(level))
+                    ++level;
+
+                if (level == texture->resident_level)
+                    continue;
+            }
+
+            make_resident(*texture, level);
+        }
+    }
+
+    size_t texture_stream::get_level_size(streamed_texture const& texture, ui32 level) const {
+        return texture.source.pixels.size() - texture.level_offsets.at(level);
+    }
+
+    bool texture_stream::make_resident(streamed_texture& texture, ui32 level) {
+        auto const& source = texture.source;
+
+        lava::texture::layer layer;
+        layer.levels.assign(source.layers.front().levels.begin() + level, source.layers.front().levels.end());
+
+        auto const size = get_level_size(texture, level);
+
+        auto resident = make_texture();
+        if (!resident->create(device, layer.levels.front().extent, source.format, { layer }, texture_type::tex_2d)) {
+            log()->error("texture stream - create {} level {}", texture.path, level);
+            return false;
+        }
+
+        auto pixels = resident->map_upload(size);
+        if (!pixels) {
+            resident->destroy();
+            return false;
+        }
+
+        memcpy(pixels, source.pixels.data() + texture.level_offsets.at(level), size);
+
+        staging->add(resident);
+
+        retire(texture.resident, texture.resident_size);
+
+        resident_size = resident_size - texture.resident_size + size;
+        uploaded_size += size;
+
+        texture.resident = resident;
+        texture.resident_level = level;
+        texture.resident_size = size;
+        ++texture.version;
+
+        return true;
+    }
+
+    bool texture_stream::drop_level(streamed_texture const* keep, ui64 before_frame) {
+        streamed_texture* oldest = nullptr;
+
+        for (auto& texture : textures) {
+            if ((texture.get() == keep) || (texture->resident_level >= texture->tail_level)
+                || (texture->request_frame >= before_frame))
+                continue;
+
+            if (!oldest || (texture->request_frame < oldest->request_frame)
+                || ((texture->request_frame == oldest->request_frame) && (texture->resident_size > oldest->resident_size)))
+                oldest = texture.get();
+        }
+
+        if (!oldest)
+            return false;
+
+        // stays there until requested finer again
+        if (!make_resident(*oldest, oldest->resident_level + 1))
+            return false;
+
+        oldest->target_level = oldest->resident_level;
+        return true;
+    }
+
+    void texture_stream::retire(texture::ptr texture, size_t size) {
+        if (!texture)
+            return;
+
+        retired_textures.push_back({ texture, size, frame });
+        retired_size += size;
+    }
+
+} // namespace lava
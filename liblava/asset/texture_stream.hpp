@@ -0,0 +1,164 @@
+// file      : liblava/asset/texture_stream.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/asset/texture_loader.hpp>
+#include <liblava/resource/staging.hpp>
+
+namespace lava {
+
+    // finest level worth sampling for an extent in pixels on screen
+    ui32 get_stream_level(uv2 size, r32 screen_extent);
+
+    // whole chain on the cpu as the source for finer levels, only levels from the resident one on the gpu
+    struct streamed_texture : no_copy_no_move {
+        using ptr = std::shared_ptr<streamed_texture>;
+        using list = std::vector<ptr>;
+
+        // replaced on every residency change, check get_version() for descriptors
+        texture::ptr const& get() const {
+            return resident;
+        }
+
+        ui32 get_version() const {
+            return version;
+        }
+
+        // 0 -> full chain
+        ui32 get_resident_level() const {
+            return resident_level;
+        }
+        ui32 get_tail_level() const {
+            return tail_level;
+        }
+        ui32 get_level_count() const {
+            return to_ui32(source.layers.front().levels.size());
+        }
+
+        uv2 get_size() const {
+            return source.size;
+        }
+
+        string const& get_path() const {
+            return path;
+        }
+
+    private:
+        friend struct texture_stream;
+
+        texture_data source;
+        std::vector<size_t> level_offsets;
+
+        string path;
+
+        texture::ptr resident;
+        ui32 resident_level = 0;
+        size_t resident_size = 0;
+        ui32 version = 0;
+
+        ui32 tail_level = 0;
+        ui32 target_level = 0;
+        ui32 requested_level = 0;
+        ui64 request_frame = 0;
+    };
+
+    struct texture_stream_config {
+        // levels up to this extent always resident
+        ui32 tail_extent = 64;
+
+        // bytes, 0 -> unlimited
+        size_t budget = 0;
+        size_t upload_budget = 16 * 1024 * 1024; // per update
+
+        // updates without a request before falling back to the tail
+        ui32 keep_frames = 60;
+    };
+
+    // mip tail resident at once, finer levels staged on demand within a vram budget
+    struct texture_stream : no_copy_no_move {
+        using config = texture_stream_config;
+
+        ~texture_stream() {
+            destroy();
+        }
+
+        // frame_count -> updates a replaced texture is kept for frames in flight
+        // scheduler -> block encoding of images not in the pref dir cache
+        bool create(device_ptr device, lava::staging& staging, index frame_count, config const& value = {},
+                    task_scheduler* scheduler = nullptr);
+        void destroy();
+
+        // tex_2d with a chain from gli, images get one generated on the cpu, see load_texture_data
+        streamed_texture::ptr add(file_format filename);
+        streamed_texture::ptr add(texture_data data, string_ref path = {});
+
+        void remove(streamed_texture::ptr const& texture);
+
+        // any number of times per frame, the finest level wins
+        void request(streamed_texture& texture, ui32 level);
+        void request_extent(streamed_texture& texture, r32 screen_extent) {
+            request(texture, get_stream_level(texture.get_size(), screen_extent));
+        }
+
+        // once per frame before staging, changes residency
+        void update();
+
+        void set_config(config const& value) {
+            settings = value;
+        }
+        config const& get_config() const {
+            return settings;
+        }
+
+        size_t get_resident_size() const {
+            return resident_size;
+        }
+
+        // replaced images not destroyed yet, counted in the budget for new uploads
+        size_t get_retired_size() const {
+            return retired_size;
+        }
+
+        streamed_texture::list const& get_textures() const {
+            return textures;
+        }
+
+    private:
+        size_t get_level_size(streamed_texture const& texture, ui32 level) const;
+
+        // new texture with levels from level on, old one retired
+        // levels already resident are uploaded again, images have a fixed level count
+        bool make_resident(streamed_texture& texture, ui32 level);
+
+        // coarsest first, one level of the least recently requested
+        // a new image with the coarser levels, memory freed once the old one is retired
+        bool drop_level(streamed_texture const* keep, ui64 before_frame);
+
+        void retire(texture::ptr texture, size_t size);
+
+        device_ptr device = nullptr;
+        lava::staging* staging = nullptr;
+        task_scheduler* scheduler = nullptr;
+
+        index frame_count = 0;
+        ui64 frame = 0;
+
+        config settings;
+
+        streamed_texture::list textures;
+        size_t resident_size = 0;
+        size_t retired_size = 0;
+        size_t uploaded_size = 0;
+
+        struct retired {
+            lava::texture::ptr texture;
+            size_t size = 0;
+            ui64 frame = 0;
+        };
+
+        std::deque<retired> retired_textures;
+    };
+
+} // namespace lava
@@ -2,42 +2,135 @@
 // copyright : Copyright (c) 2018-present, Lava Block OÜ
 // license   : MIT; see accompanying LICENSE file
 
+#include <fstream>
 #include <liblava/base/device.hpp>
 #include <liblava/base/instance.hpp>
 #include <liblava/base/physical_device.hpp>
 
 namespace lava {
 
+    namespace {
+
+        // VkPipelineCacheHeaderVersionOne
+        struct pipeline_cache_header {
+            ui32 header_size = 0;
+            ui32 header_version = 0;
+            ui32 vendor_id = 0;
+            ui32 device_id = 0;
+            ui8 cache_uuid[VK_UUID_SIZE] = {};
+        };
+
+        bool check_pipeline_cache_data(std::vector<char> const& cache_data, VkPhysicalDeviceProperties const& properties) {
+            pipeline_cache_header header;
+            if (cache_data.size() < sizeof(header))
+                return false;
+
+            memcpy(&header, cache_data.data(), sizeof(header));
+
+            if ((header.header_size < sizeof(header)) || (header.header_size > cache_data.size()))
+                return false;
+
+            if (header.header_version != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+                return false;
+
+            if ((header.vendor_id != properties.vendorID) || (header.device_id != properties.deviceID))
+                return false;
+
+            return memcmp(header.cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+        }
+
+        bool load_pipeline_cache_data(std::vector<char>& cache_data, string_ref filename) {
+            std::ifstream file(filename, std::ios::binary | std::ios::ate);
+            if (!file.is_open())
+                return false;
+
+            auto file_size = to_size_t(file.tellg());
+            if (file_size == 0)
+                return false;
+
+            cache_data.resize(file_size);
+
+            file.seekg(0, std::ios::beg);
+            file.read(cache_data.data(), file_size);
+
+            return file.good();
+        }
+
+    } // namespace
+
     bool device::create(create_param::ref param) {
         physical_device = param.physical_device;
         if (!physical_device)
             return false;
 
-        std::vector<VkDeviceQueueCreateInfo> queue_create_info_list(param.queue_info_list.size());
-
-        for (size_t i = 0, e = param.queue_info_list.size(); i != e; ++i) {
-            queue_create_info_list[i].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        std::vector<VkDeviceQueueCreateInfo> queue_create_info_list;
+        std::vector<VkQueueFlags> queue_flags_list;
 
+        for (auto& queue_info : param.queue_info_list) {
             auto index = 0u;
-            if (!physical_device->get_queue_family(index, param.queue_info_list[i].flags)) {
+
+            if (queue_info.dedicated) {
+                if (!physical_device->get_dedicated_queue_family(index, queue_info.flags)) {
+                    log()->debug("no dedicated queue family for flags {}", queue_info.flags);
+                    continue;
+                }
+            } else if (!physical_device->get_queue_family(index, queue_info.flags)) {
                 log()->error("create device queue family");
                 return false;
             }
 
-            queue_create_info_list[i].queueFamilyIndex = index;
-            queue_create_info_list[i].queueCount = param.queue_info_list[i].count();
-            queue_create_info_list[i].pQueuePriorities = param.queue_info_list[i].priorities.data();
+            auto used = false;
+            for (auto& create_info : queue_create_info_list)
+                if (create_info.queueFamilyIndex == index)
+                    used = true;
+
+            if (used) {
+                if (!queue_info.dedicated) {
+                    log()->error("create device queue family {} - already in use", index);
+                    return false;
+                }
+
+                continue;
+            }
+
+            queue_create_info_list.push_back({
+                .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+                .queueFamilyIndex = index,
+                .queueCount = queue_info.count(),
+                .pQueuePriorities = queue_info.priorities.data(),
+            });
+
+            queue_flags_list.push_back(queue_info.flags);
         }
 
+        auto extensions = param.extensions;
+        auto next = param.next;
+
+        VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timeline_semaphore_features{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR,
+            .pNext = const_cast<void*>(next),
+            .timelineSemaphore = VK_TRUE,
+        };
+
+        timeline_semaphore = param.timeline_semaphore && physical_device->supported(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+        if (timeline_semaphore) {
+            extensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+            next = &timeline_semaphore_features;
+        }
+
+        draw_indirect_count = param.draw_indirect_count && physical_device->supported(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+        if (draw_indirect_count)
+            extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
         VkDeviceCreateInfo create_info{
             .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-            .pNext = param.next,
+            .pNext = next,
             .queueCreateInfoCount = to_ui32(queue_create_info_list.size()),
             .pQueueCreateInfos = queue_create_info_list.data(),
             .enabledLayerCount = 0,
             .ppEnabledLayerNames = nullptr,
-            .enabledExtensionCount = to_ui32(param.extensions.size()),
-            .ppEnabledExtensionNames = param.extensions.data(),
+            .enabledExtensionCount = to_ui32(extensions.size()),
+            .ppEnabledExtensionNames = extensions.data(),
             .pEnabledFeatures = &param.features,
         };
 
@@ -47,6 +140,7 @@ namespace lava {
         }
 
         features = param.features;
+        pipeline_cache_file = param.pipeline_cache_file;
 
         load_table();
 
@@ -54,31 +148,36 @@ namespace lava {
         compute_queue_list.clear();
         transfer_queue_list.clear();
 
-        index_map queue_family_map;
-
         for (size_t i = 0, ei = queue_create_info_list.size(); i != ei; ++i) {
-            if (!queue_family_map.count(queue_create_info_list[i].queueFamilyIndex))
-                queue_family_map.emplace(queue_create_info_list[i].queueFamilyIndex, 0);
+            auto family = queue_create_info_list[i].queueFamilyIndex;
 
             for (size_t j = 0, ej = queue_create_info_list[i].queueCount; j != ej; ++j) {
-                auto counter = queue_family_map[queue_create_info_list[i].queueFamilyIndex];
-                queue_family_map[queue_create_info_list[i].queueFamilyIndex]++;
-
                 VkQueue queue = nullptr;
-                call().vkGetDeviceQueue(vk_device, queue_create_info_list[i].queueFamilyIndex, counter, &queue);
-
-                if (param.queue_info_list[i].flags & VK_QUEUE_GRAPHICS_BIT)
-                    graphics_queue_list.push_back({ queue, queue_create_info_list[i].queueFamilyIndex });
-                if (param.queue_info_list[i].flags & VK_QUEUE_COMPUTE_BIT)
-                    compute_queue_list.push_back({ queue, queue_create_info_list[i].queueFamilyIndex });
-                if (param.queue_info_list[i].flags & VK_QUEUE_TRANSFER_BIT)
-                    transfer_queue_list.push_back({ queue, queue_create_info_list[i].queueFamilyIndex });
+                call().vkGetDeviceQueue(vk_device, family, to_ui32(j), &queue);
+
+                if (queue_flags_list[i] & VK_QUEUE_GRAPHICS_BIT)
+                    graphics_queue_list.push_back({ queue, family });
+                if (queue_flags_list[i] & VK_QUEUE_COMPUTE_BIT)
+                    compute_queue_list.push_back({ queue, family });
+                if (queue_flags_list[i] & VK_QUEUE_TRANSFER_BIT)
+                    transfer_queue_list.push_back({ queue, family });
             }
         }
 
+        if (!create_pipeline_cache())
+            return false;
+
         return create_descriptor_pool();
     }
 
+    device::queue::ref device::get_async_transfer_queue() const {
+        for (auto& queue : transfer_queue_list)
+            if (queue.family != get_graphics_queue().family)
+                return queue;
+
+        return get_graphics_queue();
+    }
+
     void device::destroy() {
         if (!vk_device)
             return;
@@ -87,6 +186,8 @@ namespace lava {
         compute_queue_list.clear();
         transfer_queue_list.clear();
 
+        destroy_pipeline_cache();
+
         call().vkDestroyDescriptorPool(vk_device, descriptor_pool, memory::alloc());
         descriptor_pool = 0;
 
@@ -127,6 +228,83 @@ namespace lava {
         return check(call().vkCreateDescriptorPool(vk_device, &pool_info, memory::alloc(), &descriptor_pool));
     }
 
+    bool device::create_pipeline_cache() {
+        std::vector<char> cache_data;
+
+        if (!pipeline_cache_file.empty() && load_pipeline_cache_data(cache_data, pipeline_cache_file)) {
+            if (check_pipeline_cache_data(cache_data, get_properties())) {
+                log()->debug("load pipeline cache {} ({} bytes)", str(pipeline_cache_file), cache_data.size());
+            } else {
+                log()->warn("pipeline cache {} does not match device - discard", str(pipeline_cache_file));
+                cache_data.clear();
+            }
+        }
+
+        VkPipelineCacheCreateInfo create_info{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+            .initialDataSize = cache_data.size(),
+            .pInitialData = cache_data.empty() ? nullptr : cache_data.data(),
+        };
+
+        if (call().vkCreatePipelineCache(vk_device, &create_info, memory::alloc(), &pipeline_cache) == VK_SUCCESS)
+            return true;
+
+        if (cache_data.empty()) {
+            log()->error("create pipeline cache");
+            return false;
+        }
+
+        log()->warn("pipeline cache {} rejected by driver - discard", str(pipeline_cache_file));
+
+        create_info.initialDataSize = 0;
+        create_info.pInitialData = nullptr;
+
+        if (failed(call().vkCreatePipelineCache(vk_device, &create_info, memory::alloc(), &pipeline_cache))) {
+            log()->error("create pipeline cache");
+            return false;
+        }
+
+        return true;
+    }
+
+    void device::destroy_pipeline_cache() {
+        if (!pipeline_cache)
+            return;
+
+        save_pipeline_cache();
+
+        call().vkDestroyPipelineCache(vk_device, pipeline_cache, memory::alloc());
+        pipeline_cache = 0;
+    }
+
+    bool device::save_pipeline_cache() const {
+        if (!pipeline_cache || pipeline_cache_file.empty())
+            return false;
+
+        size_t cache_size = 0;
+        if (failed(call().vkGetPipelineCacheData(vk_device, pipeline_cache, &cache_size, nullptr)))
+            return false;
+
+        if (cache_size == 0)
+            return false;
+
+        std::vector<char> cache_data(cache_size);
+        if (failed(call().vkGetPipelineCacheData(vk_device, pipeline_cache, &cache_size, cache_data.data())))
+            return false;
+
+        std::ofstream file(pipeline_cache_file, std::ofstream::binary);
+        if (!file.is_open()) {
+            log()->error("save pipeline cache {}", str(pipeline_cache_file));
+            return false;
+        }
+
+        file.write(cache_data.data(), cache_size);
+
+        log()->debug("save pipeline cache {} ({} bytes)", str(pipeline_cache_file), cache_size);
+
+        return true;
+    }
+
     bool device::surface_supported(VkSurfaceKHR surface) const {
         return physical_device->surface_supported(get_graphics_queue().family, surface);
     }
@@ -159,6 +337,13 @@ namespace lava {
             return nullptr;
 
         auto param = physical_device->create_default_device_param();
+
+        if (!pipeline_cache_dir.empty()) {
+            auto const& properties = physical_device->get_properties();
+            param.pipeline_cache_file = fmt::format("{}pipeline_{:x}_{:x}.cache", str(pipeline_cache_dir),
+                                                    properties.vendorID, properties.deviceID);
+        }
+
         if (on_create_param)
             on_create_param(param);
 
@@ -26,6 +26,7 @@ namespace lava {
                 using list = std::vector<queue_info>;
 
                 VkQueueFlags flags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
+                bool dedicated = false; // family without graphics, skipped if there is none
 
                 using priority_list = std::vector<float>;
                 priority_list priorities;
@@ -46,10 +47,23 @@ namespace lava {
             VkPhysicalDeviceFeatures features{};
             void const* next = nullptr; // pNext
 
+            string pipeline_cache_file; // empty -> no persistent cache
+
+            bool timeline_semaphore = false; // VK_KHR_timeline_semaphore
+            bool draw_indirect_count = false; // VK_KHR_draw_indirect_count
+
             void set_default_queues() {
                 extensions.push_back("VK_KHR_swapchain");
                 queue_info_list.resize(1);
             }
+
+            void add_dedicated_queue(VkQueueFlags flags) {
+                queue_info info;
+                info.flags = flags;
+                info.dedicated = true;
+
+                queue_info_list.push_back(info);
+            }
         };
 
         ~device() {
@@ -88,6 +102,9 @@ namespace lava {
             return get_transfer_queue(index);
         }
 
+        // transfer queue outside the graphics family, graphics queue if there is none
+        queue::ref get_async_transfer_queue() const;
+
         queue::list const& get_graphics_queues() const {
             return graphics_queue_list;
         }
@@ -124,6 +141,18 @@ namespace lava {
             return descriptor_pool;
         }
 
+        bool timeline_semaphore_enabled() const {
+            return timeline_semaphore;
+        }
+        bool draw_indirect_count_enabled() const {
+            return draw_indirect_count;
+        }
+
+        VkPipelineCache get_pipeline_cache() const {
+            return pipeline_cache;
+        }
+        bool save_pipeline_cache() const;
+
         physical_device_cptr get_physical_device() const {
             return physical_device;
         }
@@ -148,15 +177,23 @@ namespace lava {
     private:
         bool create_descriptor_pool();
 
+        bool create_pipeline_cache();
+        void destroy_pipeline_cache();
+
         physical_device_cptr physical_device = nullptr;
 
         VkDescriptorPool descriptor_pool = 0;
 
+        VkPipelineCache pipeline_cache = 0;
+        string pipeline_cache_file;
+
         device::queue::list graphics_queue_list;
         device::queue::list compute_queue_list;
         device::queue::list transfer_queue_list;
 
         VkPhysicalDeviceFeatures features;
+        bool timeline_semaphore = false;
+        bool draw_indirect_count = false;
 
         allocator::ptr mem_allocator;
     };
@@ -177,6 +214,8 @@ namespace lava {
         using create_param_func = std::function<void(device::create_param&)>;
         create_param_func on_create_param;
 
+        string pipeline_cache_dir; // empty -> no persistent cache
+
     private:
         device::list list;
     };
@@ -48,10 +48,44 @@ namespace lava {
         return false;
     }
 
+    bool physical_device::get_dedicated_queue_family(index& index, VkQueueFlags flags) const {
+        auto found = false;
+        auto best_count = 0u;
+
+        for (size_t i = 0, e = queue_family_properties.size(); i != e; ++i) {
+            auto family_flags = queue_family_properties[i].queueFlags;
+            if (!(family_flags & flags) || (family_flags & VK_QUEUE_GRAPHICS_BIT))
+                continue;
+
+            auto count = 0u;
+            for (auto other : { VK_QUEUE_COMPUTE_BIT, VK_QUEUE_TRANSFER_BIT, VK_QUEUE_SPARSE_BINDING_BIT })
+                if ((family_flags & other) && !(flags & other))
+                    ++count;
+
+            if (!found || (count < best_count)) {
+                index = to_index(i);
+                best_count = count;
+                found = true;
+            }
+        }
+
+        return found;
+    }
+
     device::create_param physical_device::create_default_device_param() const {
         device::create_param create_param;
         create_param.physical_device = this;
         create_param.set_default_queues();
+        create_param.add_dedicated_queue(VK_QUEUE_TRANSFER_BIT);
+        create_param.timeline_semaphore = true;
+        create_param.draw_indirect_count = true;
+
+        // indirect drawing, see draw_batch
+        create_param.features.multiDrawIndirect = features.multiDrawIndirect;
+        create_param.features.drawIndirectFirstInstance = features.drawIndirectFirstInstance;
+
+        // mip chains in compute, see mip_generator
+        create_param.features.shaderStorageImageWriteWithoutFormat = features.shaderStorageImageWriteWithoutFormat;
 
         return create_param;
     }
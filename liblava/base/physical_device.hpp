@@ -19,6 +19,9 @@ namespace lava {
         bool supported(string_ref extension) const;
         bool get_queue_family(index& index, VkQueueFlags flags) const;
 
+        // no graphics, fewest other capabilities
+        bool get_dedicated_queue_family(index& index, VkQueueFlags flags) const;
+
         device::create_param create_default_device_param() const;
 
         VkPhysicalDeviceProperties const& get_properties() const {
@@ -6,7 +6,9 @@
 
 #include <liblava/block/attachment.hpp>
 #include <liblava/block/block.hpp>
+#include <liblava/block/culler.hpp>
 #include <liblava/block/descriptor.hpp>
+#include <liblava/block/mip_generator.hpp>
 #include <liblava/block/pipeline.hpp>
 #include <liblava/block/render_pass.hpp>
 #include <liblava/block/subpass.hpp>
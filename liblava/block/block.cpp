@@ -27,59 +27,124 @@ namespace lava {
     void command::destroy(device_ptr device, VkCommandPools cmd_pools) {
         for (auto i = 0u; i < buffers.size(); ++i)
             device->call().vkFreeCommandBuffers(device->get(), cmd_pools.at(i), 1, &buffers.at(i));
+
+        buffers.clear();
     }
 
-    bool block::create(lava::device_ptr d, index frame_count, index queue_family) {
+    bool block::create(lava::device_ptr d, index frame_count, index family) {
         device = d;
+        queue_family = family;
 
         current_frame = 0;
 
-        cmd_pools.resize(frame_count);
+        if (!create_pools(frame_count))
+            return false;
 
-        for (auto i = 0u; i < frame_count; ++i) {
-            VkCommandPoolCreateInfo const create_info{
-                .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-                .flags = 0,
-                .queueFamilyIndex = queue_family,
-            };
-            if (failed(device->call().vkCreateCommandPool(device->get(), &create_info, memory::alloc(), &cmd_pools.at(i)))) {
-                log()->error("create block command pool");
+        auto lane = 0u;
+        for (auto& command : commands) {
+            command.second.lane = lane++ % get_lane_count();
+
+            if (!command.second.create(device, frame_count, lane_pools.at(command.second.lane)))
                 return false;
-            }
         }
 
+        return true;
+    }
+
+    void block::destroy() {
+        // without create() no pools and no buffers to free
         for (auto& command : commands)
-            if (!command.second.create(device, frame_count, cmd_pools))
-                return false;
+            if (command.second.lane < lane_pools.size())
+                command.second.destroy(device, lane_pools.at(command.second.lane));
+
+        destroy_pools();
+        commands.clear();
+    }
+
+    bool block::create_pools(index frame_count) {
+        lane_pools.resize(lane_count);
+
+        for (auto& cmd_pools : lane_pools) {
+            cmd_pools.resize(frame_count);
+
+            for (auto i = 0u; i < frame_count; ++i) {
+                VkCommandPoolCreateInfo const create_info{
+                    .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                    .flags = 0,
+                    .queueFamilyIndex = queue_family,
+                };
+                if (failed(device->call().vkCreateCommandPool(device->get(), &create_info, memory::alloc(), &cmd_pools.at(i)))) {
+                    log()->error("create block command pool");
+                    return false;
+                }
+            }
+        }
 
         return true;
     }
 
-    void block::destroy() {
+    void block::destroy_pools() {
+        for (auto& cmd_pools : lane_pools)
+            for (auto& cmd_pool : cmd_pools)
+                if (cmd_pool)
+                    device->call().vkDestroyCommandPool(device->get(), cmd_pool, memory::alloc());
+
+        lane_pools.clear();
+    }
+
+    bool block::set_parallel(task_scheduler* s, ui32 count) {
+        scheduler = s;
+
+        if (!scheduler)
+            count = 1;
+        else if (count == 0)
+            count = scheduler->get_worker_count() + 1;
+
+        if (count == lane_count)
+            return true;
+
+        if (lane_pools.empty()) {
+            lane_count = count;
+            return true;
+        }
+
+        // command buffers belong to the pools of their lane
+        auto frame_count = get_frame_count();
+
         for (auto& command : commands)
-            command.second.destroy(device, cmd_pools);
+            command.second.destroy(device, lane_pools.at(command.second.lane));
 
-        for (auto i = 0u; i < cmd_pools.size(); ++i)
-            device->call().vkDestroyCommandPool(device->get(), cmd_pools.at(i), memory::alloc());
+        destroy_pools();
 
-        cmd_pools.clear();
-        cmd_order.clear();
-        commands.clear();
+        lane_count = count;
+
+        if (!create_pools(frame_count))
+            return false;
+
+        auto lane = 0u;
+        for (auto& command : commands) {
+            command.second.lane = lane++ % lane_count;
+
+            if (!command.second.create(device, frame_count, lane_pools.at(command.second.lane)))
+                return false;
+        }
+
+        return true;
     }
 
     id block::add_cmd(command::func func, bool active) {
         command cmd;
         cmd.on_func = func;
         cmd.active = active;
+        cmd.lane = to_index(commands.size()) % lane_count;
 
-        if (device && !cmd_pools.empty())
-            if (!cmd.create(device, get_frame_count(), cmd_pools))
+        if (device && !lane_pools.empty())
+            if (!cmd.create(device, get_frame_count(), lane_pools.at(cmd.lane)))
                 return undef_id;
 
         auto result = cmd.get_id();
 
         commands.emplace(result, std::move(cmd));
-        cmd_order.push_back(&commands.at(result));
 
         return result;
     }
@@ -89,42 +154,72 @@ namespace lava {
             return;
 
         auto& command = commands.at(cmd);
-        command.destroy(device, cmd_pools);
-
-        remove(cmd_order, &command);
+        if (command.lane < lane_pools.size())
+            command.destroy(device, lane_pools.at(command.lane));
 
         commands.erase(cmd);
     }
 
-    bool block::process(index frame) {
-        current_frame = frame;
+    bool block::record(command& cmd, index frame) {
+        auto& cmd_buf = cmd.buffers.at(frame);
+
+        VkCommandBufferBeginInfo const begin_info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
+        if (failed(device->call().vkBeginCommandBuffer(cmd_buf, &begin_info)))
+            return false;
+
+        if (cmd.on_func)
+            cmd.on_func(cmd_buf);
 
-        if (failed(device->call().vkResetCommandPool(device->get(), cmd_pools.at(frame), 0))) {
+        return !failed(device->call().vkEndCommandBuffer(cmd_buf));
+    }
+
+    bool block::record_lane(index lane, index frame) {
+        if (failed(device->call().vkResetCommandPool(device->get(), lane_pools.at(lane).at(frame), 0))) {
             log()->error("block reset command pool");
             return false;
         }
 
-        for (auto& command : cmd_order) {
-            if (!command->active)
+        for (auto& cmd : commands) {
+            auto& command = cmd.second;
+            if (!command.active || (command.lane != lane))
                 continue;
 
-            auto& cmd_buf = command->buffers.at(frame);
-
-            VkCommandBufferBeginInfo const begin_info{
-                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-                .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
-            };
-            if (failed(device->call().vkBeginCommandBuffer(cmd_buf, &begin_info)))
+            if (!record(command, frame))
                 return false;
+        }
+
+        return true;
+    }
 
-            if (command->on_func)
-                command->on_func(cmd_buf);
+    bool block::process(index frame) {
+        current_frame = frame;
 
-            if (failed(device->call().vkEndCommandBuffer(cmd_buf)))
-                return false;
+        auto count = get_lane_count();
+
+        if (!scheduler || (count < 2)) {
+            for (auto lane = 0u; lane < count; ++lane)
+                if (!record_lane(lane, frame))
+                    return false;
+
+            return true;
         }
 
-        return true;
+        // pools are externally synchronized - one task per lane
+        std::vector<c8> results(count, false);
+        task_group group;
+
+        for (auto lane = 1u; lane < count; ++lane)
+            scheduler->submit([&, lane]() { results.at(lane) = record_lane(lane, frame); }, &group);
+
+        results.front() = record_lane(0, frame);
+
+        scheduler->wait(group);
+
+        // submission order stays the order of addition, see get_buffers()
+        return std::all_of(results.begin(), results.end(), [](c8 result) { return result; });
     }
 
     bool block::activated(id::ref command) {
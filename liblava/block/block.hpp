@@ -5,11 +5,12 @@
 #pragma once
 
 #include <liblava/base/device.hpp>
+#include <liblava/util/scheduler.hpp>
 
 namespace lava {
 
     struct command : id_obj {
-        using map = std::map<id, command>;
+        using map = slot_map<command>;
         using list = std::vector<command*>;
 
         VkCommandBuffers buffers = {};
@@ -19,6 +20,8 @@ namespace lava {
 
         bool active = true;
 
+        index lane = 0; // recorded with the pools of this lane
+
         bool create(device_ptr device, index frame_count, VkCommandPools command_pools);
         void destroy(device_ptr device, VkCommandPools command_pools);
     };
@@ -35,8 +38,16 @@ namespace lava {
         bool create(device_ptr device, index frame_count, index queue_family);
         void destroy();
 
+        // lanes record concurrently, each with its own pool per frame
+        // commands of different lanes must not share state while recording
+        // lane_count 0 -> workers + 1, nullptr -> sequential
+        bool set_parallel(task_scheduler* scheduler, ui32 lane_count = 0);
+
         auto get_frame_count() const {
-            return to_index(cmd_pools.size());
+            return lane_pools.empty() ? 0 : to_index(lane_pools.front().size());
+        }
+        auto get_lane_count() const {
+            return to_index(lane_pools.size());
         }
 
         id add_cmd(command::func func, bool active = true);
@@ -64,19 +75,17 @@ namespace lava {
         auto get_buffers() {
             VkCommandBuffers result;
 
-            for (auto& cmd : cmd_order)
-                if (cmd->active)
-                    result.push_back(cmd->buffers.at(current_frame));
+            for (auto& cmd : commands)
+                if (cmd.second.active)
+                    result.push_back(cmd.second.buffers.at(current_frame));
 
             return result;
         }
 
+        // in order of addition
         auto const& get_commands() const {
             return commands;
         }
-        auto const& get_cmd_order() const {
-            return cmd_order;
-        }
 
         bool activated(id::ref command);
         bool set_active(id::ref command, bool active = true);
@@ -86,13 +95,24 @@ namespace lava {
         }
 
     private:
+        bool create_pools(index frame_count);
+        void destroy_pools();
+
+        bool record(command& cmd, index frame);
+        bool record_lane(index lane, index frame);
+
         device_ptr device = nullptr;
 
         index current_frame = 0;
-        VkCommandPools cmd_pools = {};
+        index queue_family = 0;
+
+        // [lane][frame]
+        std::vector<VkCommandPools> lane_pools;
+        ui32 lane_count = 1;
+
+        task_scheduler* scheduler = nullptr;
 
         command::map commands;
-        command::list cmd_order;
     };
 
     inline block::ptr make_block() {
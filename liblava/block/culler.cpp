@@ -0,0 +1,434 @@
+// file      : liblava/block/culler.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#include <liblava/block/culler.hpp>
+
+namespace lava {
+
+    // generated from res/tool/cull/cull.comp at build time
+    static ui32 cull_comp_shader[] = {
+#include "cull.comp.u32"
+    };
+
+    namespace {
+
+        constexpr ui32 const cull_group_size = 64;
+        constexpr ui32 const cull_binding_count = 5;
+
+        // same test as cull.comp
+        bool sphere_visible(frustum const& frustum, mat4 const& transform, v4 const& sphere) {
+            auto const center = v3(transform * v4(v3(sphere), 1.f));
+            auto const scale = glm::max(glm::length(v3(transform[0])),
+                                        glm::max(glm::length(v3(transform[1])), glm::length(v3(transform[2]))));
+
+            return frustum.intersects(center, sphere.w * scale);
+        }
+
+    } // namespace
+
+    bool instance_culler::create(geometry_pool::ptr p, index frame_count, data const& shader, ui32 instance_capacity) {
+        pool = p;
+        if (!pool || !pool->get_device() || (frame_count == 0))
+            return false;
+
+        device = pool->get_device();
+
+        multi_draw = device->get_features().multiDrawIndirect;
+        first_instance = device->get_features().drawIndirectFirstInstance;
+        max_draw_count = multi_draw ? std::max(1u, device->get_properties().limits.maxDrawIndirectCount) : 1;
+
+        auto spirv = shader;
+        if (!spirv.ptr)
+            spirv = { cull_comp_shader, sizeof(cull_comp_shader) };
+
+        gpu_support = first_instance && create_pipeline(spirv);
+        if (!gpu_support)
+            log()->debug("instance culler - cpu");
+
+        frames.resize(frame_count);
+
+        for (auto& frame : frames) {
+            if (gpu_support)
+                frame.descriptor_set = descriptor->allocate();
+
+            if (!reserve(frame, instance_capacity, 16))
+                return false;
+        }
+
+        return true;
+    }
+
+    void instance_culler::destroy() {
+        for (auto& frame : frames)
+            if (frame.descriptor_set)
+                descriptor->free(frame.descriptor_set);
+
+        frames.clear();
+        items.clear();
+
+        if (pipeline) {
+            pipeline->destroy();
+            pipeline = nullptr;
+        }
+
+        if (layout) {
+            layout->destroy();
+            layout = nullptr;
+        }
+
+        if (descriptor) {
+            descriptor->destroy();
+            descriptor = nullptr;
+        }
+
+        gpu_support = false;
+
+        pool = nullptr;
+        device = nullptr;
+    }
+
+    bool instance_culler::create_pipeline(data const& shader) {
+        descriptor = make_descriptor();
+
+        for (auto binding = 0u; binding < cull_binding_count; ++binding)
+            descriptor->add_binding(binding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+
+        if (!descriptor->create(device)) {
+            log()->error("create instance culler descriptor");
+            return false;
+        }
+
+        layout = make_pipeline_layout();
+        layout->add(descriptor);
+        layout->add(VkPushConstantRange{ VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(cull_push_constants) });
+
+        if (!layout->create(device)) {
+            log()->error("create instance culler pipeline layout");
+            return false;
+        }
+
+        pipeline = make_compute_pipeline(device);
+        pipeline->set_layout(layout);
+
+        if (!pipeline->set_shader_stage(shader, VK_SHADER_STAGE_COMPUTE_BIT) || !pipeline->create()) {
+            log()->error("create instance culler pipeline");
+            return false;
+        }
+
+        return true;
+    }
+
+    bool instance_culler::reserve(frame_data& frame, ui32 instance_count, ui32 geometry_count) {
+        auto create_buffer = [&](buffer::ptr& buffer, size_t size, VkBufferUsageFlags usage,
+                                 VmaMemoryUsage memory_usage = VMA_MEMORY_USAGE_CPU_TO_GPU) {
+            buffer = make_buffer();
+            if (!buffer->create(device, nullptr, size, usage, true, memory_usage)) {
+                log()->error("create instance culler buffer");
+                return false;
+            }
+
+            return true;
+        };
+
+        auto changed = false;
+
+        // frame index reuse -> its last submit is done
+        if (!frame.instance_buffer || (instance_count > frame.capacity)) {
+            auto capacity = std::max(frame.capacity, 64u);
+            while (capacity < instance_count)
+                capacity *= 2;
+
+            if (!create_buffer(frame.instance_buffer, sizeof(draw_instance) * capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT))
+                return false;
+
+            if (!create_buffer(frame.object_buffer, sizeof(cull_object) * capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT))
+                return false;
+
+            if (!create_buffer(frame.draw_buffer, sizeof(draw_instance) * capacity,
+                               VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT))
+                return false;
+
+            frame.capacity = capacity;
+            changed = true;
+        }
+
+        if (!frame.geometry_buffer || (geometry_count > frame.geometry_capacity)) {
+            auto capacity = std::max(frame.geometry_capacity, 16u);
+            while (capacity < geometry_count)
+                capacity *= 2;
+
+            if (!create_buffer(frame.geometry_buffer, sizeof(VkDrawIndexedIndirectCommand) * capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT))
+                return false;
+
+            if (!create_buffer(frame.command_buffer, sizeof(VkDrawIndexedIndirectCommand) * capacity,
+                               VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT))
+                return false;
+
+            frame.geometry_capacity = capacity;
+            changed = true;
+        }
+
+        if (!frame.count_buffer) {
+            if (!create_buffer(frame.count_buffer, sizeof(ui32),
+                               VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                               VMA_MEMORY_USAGE_GPU_TO_CPU))
+                return false;
+
+            changed = true;
+        }
+
+        if (changed && frame.descriptor_set)
+            write_descriptor_set(frame);
+
+        return true;
+    }
+
+    void instance_culler::write_descriptor_set(frame_data const& frame) const {
+        std::array<buffer::ptr, cull_binding_count> const buffers = {
+            frame.instance_buffer,
+            frame.object_buffer,
+            frame.draw_buffer,
+            frame.command_buffer,
+            frame.count_buffer,
+        };
+
+        std::array<VkWriteDescriptorSet, cull_binding_count> writes;
+        for (auto binding = 0u; binding < cull_binding_count; ++binding)
+            writes[binding] = {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = frame.descriptor_set,
+                .dstBinding = binding,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = buffers[binding]->get_descriptor(),
+            };
+
+        device->vkUpdateDescriptorSets(writes);
+    }
+
+    bool instance_culler::update(index frame, mat4 const& view_projection) {
+        if (!pool || (frame >= frames.size()))
+            return false;
+
+        auto& data = frames[frame];
+        data.commands.clear();
+        data.visible_count = 0;
+
+        frustum const view_frustum(view_projection);
+        auto const cpu = !gpu();
+
+        geometry_slots.clear();
+        geometry_commands.clear();
+        geometry_spheres.clear();
+        item_slots.clear();
+
+        // instances per geometry, counted in instanceCount first
+        for (auto const& item : items) {
+            auto slot = no_index;
+
+            auto it = geometry_slots.find(item.geometry);
+            if (it != geometry_slots.end()) {
+                slot = it->second;
+            } else if (auto range = pool->get(item.geometry)) {
+                slot = to_ui32(geometry_commands.size());
+                geometry_slots.emplace(item.geometry, slot);
+
+                geometry_commands.push_back({
+                    .indexCount = range->index_count,
+                    .instanceCount = 0,
+                    .firstIndex = range->first_index,
+                    .vertexOffset = to_i32(range->first_vertex),
+                    .firstInstance = 0,
+                });
+
+                geometry_spheres.push_back(v4(range->center, range->radius));
+            }
+
+            // no_index -> removed from the pool
+            item_slots.push_back(slot);
+
+            if (slot != no_index)
+                ++geometry_commands[slot].instanceCount;
+        }
+
+        // prefix sum -> instance range per geometry, filled up to instanceCount
+        auto instance_count = 0u;
+        for (auto& command : geometry_commands) {
+            command.firstInstance = instance_count;
+            instance_count += command.instanceCount;
+            command.instanceCount = 0;
+        }
+
+        auto const geometry_count = to_ui32(geometry_commands.size());
+        if (!reserve(data, instance_count, geometry_count))
+            return false;
+
+        auto instances = (draw_instance*) data.instance_buffer->get_mapped_data();
+        auto objects = (cull_object*) data.object_buffer->get_mapped_data();
+        auto visible = (draw_instance*) data.draw_buffer->get_mapped_data();
+        auto object_count = 0u;
+
+        for (auto i = 0u; i < items.size(); ++i) {
+            auto const slot = item_slots[i];
+            if (slot == no_index)
+                continue;
+
+            auto const& item = items[i];
+
+            if (!cpu) {
+                instances[object_count].transform = item.transform;
+                objects[object_count] = { geometry_spheres[slot], slot };
+
+                ++object_count;
+                continue;
+            }
+
+            if (!sphere_visible(view_frustum, item.transform, geometry_spheres[slot]))
+                continue;
+
+            auto& command = geometry_commands[slot];
+            visible[command.firstInstance + command.instanceCount].transform = item.transform;
+            ++command.instanceCount;
+        }
+
+        if (cpu) {
+            for (auto const& command : geometry_commands)
+                if (command.instanceCount > 0) {
+                    data.commands.push_back(command);
+                    data.visible_count += command.instanceCount;
+                }
+
+            auto commands = (VkDrawIndexedIndirectCommand*) data.command_buffer->get_mapped_data();
+            memcpy(commands, data.commands.data(), sizeof(VkDrawIndexedIndirectCommand) * data.commands.size());
+
+            // no drawIndirectFirstInstance -> draw buffer bound at the offset per command
+            if (!first_instance)
+                for (auto c = 0u; c < data.commands.size(); ++c)
+                    commands[c].firstInstance = 0;
+
+            data.command_buffer->flush(0, sizeof(VkDrawIndexedIndirectCommand) * data.commands.size());
+            data.draw_buffer->flush(0, sizeof(draw_instance) * instance_count);
+        } else {
+            // copied to the command buffer on dispatch, instanceCount grows in the shader
+            memcpy(data.geometry_buffer->get_mapped_data(), geometry_commands.data(),
+                   sizeof(VkDrawIndexedIndirectCommand) * geometry_count);
+
+            data.instance_buffer->flush(0, sizeof(draw_instance) * object_count);
+            data.object_buffer->flush(0, sizeof(cull_object) * object_count);
+            data.geometry_buffer->flush(0, sizeof(VkDrawIndexedIndirectCommand) * geometry_count);
+        }
+
+        data.instance_count = instance_count;
+        data.geometry_count = geometry_count;
+
+        data.push_constants.planes = view_frustum.planes;
+        data.push_constants.object_count = object_count;
+
+        return true;
+    }
+
+    void instance_culler::dispatch(VkCommandBuffer cmd_buf, index frame) const {
+        if (!gpu() || (frame >= frames.size()))
+            return;
+
+        auto const& data = frames[frame];
+
+        if (data.geometry_count > 0) {
+            VkBufferCopy const region{
+                .size = sizeof(VkDrawIndexedIndirectCommand) * data.geometry_count,
+            };
+
+            device->call().vkCmdCopyBuffer(cmd_buf, data.geometry_buffer->get(), data.command_buffer->get(), 1, &region);
+        }
+
+        device->call().vkCmdFillBuffer(cmd_buf, data.count_buffer->get(), 0, sizeof(ui32), 0);
+
+        VkMemoryBarrier const fill_barrier{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        };
+
+        device->call().vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                                            1, &fill_barrier, 0, nullptr, 0, nullptr);
+
+        if (data.push_constants.object_count > 0) {
+            pipeline->bind(cmd_buf);
+            layout->bind(cmd_buf, data.descriptor_set, {}, VK_PIPELINE_BIND_POINT_COMPUTE);
+
+            device->call().vkCmdPushConstants(cmd_buf, layout->get(), VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                                              sizeof(cull_push_constants), &data.push_constants);
+
+            device->call().vkCmdDispatch(cmd_buf, ceil_div(data.push_constants.object_count, cull_group_size), 1, 1);
+        }
+
+        VkMemoryBarrier const cull_barrier{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_HOST_READ_BIT,
+        };
+
+        device->call().vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0,
+                                            1, &cull_barrier, 0, nullptr, 0, nullptr);
+    }
+
+    void instance_culler::draw(VkCommandBuffer cmd_buf, index frame) const {
+        if (!pool || (frame >= frames.size()))
+            return;
+
+        auto const& data = frames[frame];
+        if (data.instance_count == 0)
+            return;
+
+        auto const cpu = !gpu();
+        auto const command_count = get_command_count(frame);
+        if (command_count == 0)
+            return;
+
+        auto const draw_buffer = data.draw_buffer->get();
+        auto const command_buffer = data.command_buffer->get();
+        auto const stride = to_ui32(sizeof(VkDrawIndexedIndirectCommand));
+
+        pool->bind(cmd_buf);
+
+        if (cpu && !first_instance) {
+            for (auto c = 0u; c < command_count; ++c) {
+                VkDeviceSize const offset = sizeof(draw_instance) * data.commands[c].firstInstance;
+                vkCmdBindVertexBuffers(cmd_buf, 1, 1, &draw_buffer, &offset);
+
+                vkCmdDrawIndexedIndirect(cmd_buf, command_buffer, stride * c, 1, stride);
+            }
+
+            return;
+        }
+
+        VkDeviceSize const offset = 0;
+        vkCmdBindVertexBuffers(cmd_buf, 1, 1, &draw_buffer, &offset);
+
+        for (auto first = 0u; first < command_count; first += max_draw_count)
+            vkCmdDrawIndexedIndirect(cmd_buf, command_buffer, stride * first, std::min(max_draw_count, command_count - first), stride);
+    }
+
+    ui32 instance_culler::get_visible_count(index frame) const {
+        if (frame >= frames.size())
+            return 0;
+
+        auto const& data = frames[frame];
+        if (!gpu())
+            return data.visible_count;
+
+        data.count_buffer->invalidate(0, sizeof(ui32));
+        return *(ui32 const*) data.count_buffer->get_mapped_data();
+    }
+
+    ui32 instance_culler::get_command_count(index frame) const {
+        if (frame >= frames.size())
+            return 0;
+
+        auto const& data = frames[frame];
+        return gpu() ? data.geometry_count : to_ui32(data.commands.size());
+    }
+
+} // namespace lava
@@ -0,0 +1,139 @@
+// file      : liblava/block/culler.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/block/pipeline.hpp>
+#include <liblava/resource/draw_batch.hpp>
+
+namespace lava {
+
+    // std430, see res/tool/cull/cull.comp
+    struct cull_object {
+        v4 sphere = v4(0.f); // object space
+        ui32 command = 0;    // geometry slot
+        ui32 padding[3] = {};
+    };
+
+    struct cull_push_constants {
+        std::array<v4, frustum::count> planes = {};
+        ui32 object_count = 0;
+    };
+
+    // instance visibility in a compute pass, cpu culling otherwise
+    // visible instances compacted per geometry -> one indirect command per geometry
+    struct instance_culler : id_obj {
+        using ptr = std::shared_ptr<instance_culler>;
+
+        ~instance_culler() {
+            destroy();
+        }
+
+        // shader -> spir-v of cull.comp, empty -> built in
+        bool create(geometry_pool::ptr pool, index frame_count, data const& shader = {}, ui32 instance_capacity = 1024);
+        void destroy();
+
+        // compute pipeline and first instance
+        bool gpu_supported() const {
+            return gpu_support;
+        }
+
+        void set_gpu_active(bool value = true) {
+            gpu_active = value;
+        }
+        bool gpu() const {
+            return gpu_support && gpu_active;
+        }
+
+        void clear() {
+            items.clear();
+        }
+        void add(id::ref geometry, mat4 const& transform) {
+            items.push_back({ geometry, transform });
+        }
+
+        // uploads instances, culls right away on the cpu
+        bool update(index frame, mat4 const& view_projection);
+
+        // outside a render pass, compute pass on the gpu
+        void dispatch(VkCommandBuffer cmd_buf, index frame) const;
+
+        // instance input as draw_batch
+        void draw(VkCommandBuffer cmd_buf, index frame) const;
+
+        ui32 get_instance_count(index frame) const {
+            return frame < frames.size() ? frames[frame].instance_count : 0;
+        }
+
+        // gpu -> once the frame is done
+        ui32 get_visible_count(index frame) const;
+
+        // gpu -> every geometry, cpu -> geometries with visible instances
+        ui32 get_command_count(index frame) const;
+
+        geometry_pool::ptr get_pool() {
+            return pool;
+        }
+
+    private:
+        struct item {
+            id geometry;
+            mat4 transform;
+        };
+
+        struct frame_data {
+            buffer::ptr instance_buffer;
+            buffer::ptr object_buffer;
+            buffer::ptr draw_buffer;
+            buffer::ptr geometry_buffer;
+            buffer::ptr command_buffer;
+            buffer::ptr count_buffer;
+
+            ui32 capacity = 0;
+            ui32 geometry_capacity = 0;
+
+            VkDescriptorSet descriptor_set = 0;
+
+            cull_push_constants push_constants;
+            ui32 instance_count = 0;
+            ui32 geometry_count = 0;
+
+            // cpu
+            std::vector<VkDrawIndexedIndirectCommand> commands;
+            ui32 visible_count = 0;
+        };
+
+        bool create_pipeline(data const& shader);
+
+        bool reserve(frame_data& frame, ui32 instance_count, ui32 geometry_count);
+        void write_descriptor_set(frame_data const& frame) const;
+
+        device_ptr device = nullptr;
+        geometry_pool::ptr pool;
+
+        lava::descriptor::ptr descriptor;
+        pipeline_layout::ptr layout;
+        compute_pipeline::ptr pipeline;
+
+        std::vector<item> items;
+        std::vector<index> item_slots;
+        std::vector<frame_data> frames;
+
+        std::map<id, index> geometry_slots;
+        std::vector<VkDrawIndexedIndirectCommand> geometry_commands;
+        std::vector<v4> geometry_spheres;
+
+        bool gpu_support = false;
+        bool gpu_active = true;
+
+        bool multi_draw = false;
+        bool first_instance = false;
+        ui32 max_draw_count = 1;
+    };
+
+    inline instance_culler::ptr make_instance_culler() {
+        return std::make_shared<instance_culler>();
+    }
+
+} // namespace lava
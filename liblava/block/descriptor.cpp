@@ -76,11 +76,14 @@ namespace lava {
     VkDescriptorSets descriptor::allocate_sets(ui32 size) {
         VkDescriptorSets result(size);
 
+        // one layout per set
+        VkDescriptorSetLayouts const layouts(size, layout);
+
         VkDescriptorSetAllocateInfo const alloc_info{
             .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
             .descriptorPool = device->get_descriptor_pool(),
             .descriptorSetCount = size,
-            .pSetLayouts = &layout,
+            .pSetLayouts = layouts.data(),
         };
 
         if (failed(device->call().vkAllocateDescriptorSets(device->get(), &alloc_info, result.data())))
@@ -0,0 +1,265 @@
+// file      : liblava/block/mip_generator.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#include <liblava/block/mip_generator.hpp>
+#include <liblava/resource/format.hpp>
+
+namespace lava {
+
+    // generated from res/tool/mip/mip.comp at build time
+    static ui32 mip_comp_shader[] = {
+#include "mip.comp.u32"
+    };
+
+    namespace {
+
+        constexpr ui32 const mip_group_size = 8;
+
+    } // namespace
+
+    bool mip_generator::create(device_ptr d, index frame_count, data const& shader) {
+        device = d;
+        if (!device || (frame_count == 0))
+            return false;
+
+        auto spirv = shader;
+        if (!spirv.ptr)
+            spirv = { mip_comp_shader, sizeof(mip_comp_shader) };
+
+        if (!device->get_features().shaderStorageImageWriteWithoutFormat) {
+            log()->debug("mip generator - blit only");
+            return false;
+        }
+
+        // texel fetch only
+        VkSamplerCreateInfo const sampler_info{
+            .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+            .magFilter = VK_FILTER_NEAREST,
+            .minFilter = VK_FILTER_NEAREST,
+            .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+            .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+            .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+            .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+            .maxLod = 0.f,
+        };
+
+        if (!device->vkCreateSampler(&sampler_info, &sampler)) {
+            log()->error("create mip generator sampler");
+            return false;
+        }
+
+        if (!create_pipeline(spirv))
+            return false;
+
+        frames.resize(frame_count);
+        return true;
+    }
+
+    bool mip_generator::create_pipeline(data const& shader) {
+        descriptor = make_descriptor();
+        descriptor->add_binding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT);
+        descriptor->add_binding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT);
+
+        if (!descriptor->create(device)) {
+            log()->error("create mip generator descriptor");
+            return false;
+        }
+
+        layout = make_pipeline_layout();
+        layout->add(descriptor);
+
+        if (!layout->create(device)) {
+            log()->error("create mip generator pipeline layout");
+            return false;
+        }
+
+        pipeline = make_compute_pipeline(device);
+        pipeline->set_layout(layout);
+
+        if (!pipeline->set_shader_stage(shader, VK_SHADER_STAGE_COMPUTE_BIT) || !pipeline->create()) {
+            log()->error("create mip generator pipeline");
+            pipeline = nullptr;
+            return false;
+        }
+
+        return true;
+    }
+
+    void mip_generator::destroy() {
+        for (auto frame = 0u; frame < frames.size(); ++frame)
+            reclaim(frame);
+
+        frames.clear();
+
+        if (pipeline) {
+            pipeline->destroy();
+            pipeline = nullptr;
+        }
+
+        if (layout) {
+            layout->destroy();
+            layout = nullptr;
+        }
+
+        if (descriptor) {
+            descriptor->destroy();
+            descriptor = nullptr;
+        }
+
+        if (sampler) {
+            device->vkDestroySampler(sampler);
+            sampler = 0;
+        }
+
+        device = nullptr;
+    }
+
+    bool mip_generator::supported(VkFormat format) const {
+        return pipeline && format_storage_supported(device->get_vk_physical_device(), format);
+    }
+
+    bool mip_generator::supported(texture& target) {
+        auto image = target.get_image();
+
+        return image && supported(image->get_format()) && (image->get_info().usage & VK_IMAGE_USAGE_STORAGE_BIT);
+    }
+
+    void mip_generator::reclaim(index frame) {
+        if (frame >= frames.size())
+            return;
+
+        auto& data = frames[frame];
+
+        if (!data.descriptor_sets.empty())
+            descriptor->free(data.descriptor_sets);
+
+        for (auto view : data.views)
+            device->vkDestroyImageView(view);
+
+        data.descriptor_sets.clear();
+        data.views.clear();
+    }
+
+    bool mip_generator::generate(VkCommandBuffer cmd_buf, texture& target, index frame) {
+        if ((frame >= frames.size()) || !target.mip_levels_generation())
+            return false;
+
+        if (!supported(target))
+            return false;
+
+        auto image = target.get_image();
+
+        auto& data = frames[frame];
+
+        auto const level_count = target.get_level_count();
+        auto const layer_count = target.get_layer_count();
+
+        auto const first_view = data.views.size();
+
+        for (auto level = 0u; level < level_count; ++level) {
+            VkImageViewCreateInfo const view_info{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                .image = image->get(),
+                .viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY,
+                .format = image->get_format(),
+                .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, layer_count },
+            };
+
+            VkImageView view = 0;
+            if (!device->vkCreateImageView(&view_info, &view)) {
+                log()->error("create mip generator image view");
+                return false;
+            }
+
+            data.views.push_back(view);
+        }
+
+        // level - 1 -> level
+        auto const descriptor_sets = descriptor->allocate(level_count - 1);
+        if (descriptor_sets.size() != level_count - 1) {
+            log()->error("allocate mip generator descriptor sets");
+            return false;
+        }
+
+        data.descriptor_sets.insert(data.descriptor_sets.end(), descriptor_sets.begin(), descriptor_sets.end());
+
+        for (auto level = 1u; level < level_count; ++level) {
+            VkDescriptorImageInfo const source_info{
+                .sampler = sampler,
+                .imageView = data.views[first_view + level - 1],
+                .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+            };
+
+            VkDescriptorImageInfo const target_info{
+                .imageView = data.views[first_view + level],
+                .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+            };
+
+            std::array<VkWriteDescriptorSet, 2> const writes = {
+                VkWriteDescriptorSet{
+                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                    .dstSet = descriptor_sets[level - 1],
+                    .dstBinding = 0,
+                    .descriptorCount = 1,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                    .pImageInfo = &source_info,
+                },
+                VkWriteDescriptorSet{
+                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                    .dstSet = descriptor_sets[level - 1],
+                    .dstBinding = 1,
+                    .descriptorCount = 1,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                    .pImageInfo = &target_info,
+                },
+            };
+
+            device->vkUpdateDescriptorSets(writes);
+        }
+
+        // level 0 written by the copy, general for sampled and storage access
+        auto barrier = image_memory_barrier(image->get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.subresourceRange = target.get_subresource_range();
+
+        device->call().vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                                            0, nullptr, 0, nullptr, 1, &barrier);
+
+        pipeline->bind(cmd_buf);
+
+        auto const size = image->get_size();
+
+        barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.subresourceRange.levelCount = 1;
+
+        for (auto level = 1u; level < level_count; ++level) {
+            layout->bind(cmd_buf, descriptor_sets[level - 1], {}, VK_PIPELINE_BIND_POINT_COMPUTE);
+
+            auto const width = std::max(size.x >> level, 1u);
+            auto const height = std::max(size.y >> level, 1u);
+
+            device->call().vkCmdDispatch(cmd_buf, ceil_div(width, mip_group_size), ceil_div(height, mip_group_size), layer_count);
+
+            // source of the next level
+            barrier.subresourceRange.baseMipLevel = level;
+
+            device->call().vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                                                0, nullptr, 0, nullptr, 1, &barrier);
+        }
+
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.subresourceRange = target.get_subresource_range();
+
+        device->call().vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                                            0, nullptr, 0, nullptr, 1, &barrier);
+
+        return true;
+    }
+
+} // namespace lava
@@ -0,0 +1,71 @@
+// file      : liblava/block/mip_generator.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/block/pipeline.hpp>
+#include <liblava/resource/texture.hpp>
+
+namespace lava {
+
+    // mip chains in a compute pass, for texture formats without blit support
+    struct mip_generator : id_obj {
+        using ptr = std::shared_ptr<mip_generator>;
+
+        ~mip_generator() {
+            destroy();
+        }
+
+        // shader -> spir-v of mip.comp, empty -> built in
+        bool create(device_ptr device, index frame_count, data const& shader = {});
+        void destroy();
+
+        // storage image format, written without format in the shader
+        bool supported(VkFormat format) const;
+
+        // format and storage usage of the texture image
+        bool supported(texture& target);
+
+        // frame index reuse -> its last submit is done
+        void reclaim(index frame);
+
+        // as texture::generate_mips, level views kept until reclaim
+        bool generate(VkCommandBuffer cmd_buf, texture& target, index frame);
+
+        // for staging::set_mip_func
+        texture::mip_func get_func() {
+            return [&](VkCommandBuffer cmd_buf, texture& target, index frame) {
+                return generate(cmd_buf, target, frame);
+            };
+        }
+        texture::mip_check get_check() {
+            return [&](texture& target) {
+                return supported(target);
+            };
+        }
+
+    private:
+        struct frame_data {
+            std::vector<VkImageView> views;
+            VkDescriptorSets descriptor_sets;
+        };
+
+        bool create_pipeline(data const& shader);
+
+        device_ptr device = nullptr;
+
+        lava::descriptor::ptr descriptor;
+        pipeline_layout::ptr layout;
+        compute_pipeline::ptr pipeline;
+
+        VkSampler sampler = 0;
+
+        std::vector<frame_data> frames;
+    };
+
+    inline mip_generator::ptr make_mip_generator() {
+        return std::make_shared<mip_generator>();
+    }
+
+} // namespace lava
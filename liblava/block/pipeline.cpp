@@ -38,8 +38,11 @@ namespace lava {
         vkCmdBindDescriptorSets(cmd_buf, bind_point, layout, 0, to_ui32(descriptor_sets.size()), descriptor_sets.data(), to_ui32(offsets.size()), offsets.data());
     }
 
-    pipeline::pipeline(device_ptr device_, VkPipelineCache pipeline_cache)
-    : device(device_), pipeline_cache(pipeline_cache) {}
+    pipeline::pipeline(device_ptr device_, VkPipelineCache pipeline_cache_)
+    : device(device_), pipeline_cache(pipeline_cache_) {
+        if (!pipeline_cache && device)
+            pipeline_cache = device->get_pipeline_cache();
+    }
 
     pipeline::~pipeline() {
         pipeline_cache = 0;
@@ -47,10 +50,15 @@ namespace lava {
     }
 
     bool pipeline::create() {
+        // cached secondary command buffers refer to the old vk pipeline
+        invalidate();
+
         return create_internal();
     }
 
     void pipeline::destroy() {
+        invalidate();
+
         destroy_internal();
 
         if (vk_pipeline) {
@@ -72,7 +72,7 @@ namespace lava {
         using process_func = std::function<void(VkCommandBuffer)>;
         process_func on_process;
 
-        explicit pipeline(device_ptr device, VkPipelineCache pipeline_cache = 0);
+        explicit pipeline(device_ptr device, VkPipelineCache pipeline_cache = 0); // 0 -> device cache
         ~pipeline() override;
 
         bool create();
@@ -102,6 +102,22 @@ namespace lava {
             return vk_pipeline != 0;
         }
 
+        // secondary command buffers of a reusable pipeline are recorded again only after invalidate(), create() or destroy()
+        void set_reusable(bool value = true) {
+            reusable_active = value;
+            invalidate();
+        }
+        bool reusable() const {
+            return reusable_active;
+        }
+
+        void invalidate() {
+            ++version;
+        }
+        ui32 get_version() const {
+            return version;
+        }
+
         VkPipeline get() const {
             return vk_pipeline;
         }
@@ -109,6 +125,10 @@ namespace lava {
             return device;
         }
 
+        VkPipelineCache get_pipeline_cache() const {
+            return pipeline_cache;
+        }
+
         pipeline_layout::ptr get_layout() const {
             return layout;
         }
@@ -159,6 +179,9 @@ namespace lava {
     private:
         bool active = true;
         bool auto_bind_active = true;
+
+        bool reusable_active = false;
+        ui32 version = 0;
     };
 
     pipeline::shader_stage::ptr make_pipeline_shader_stage(VkShaderStageFlagBits stage);
@@ -220,6 +243,13 @@ namespace lava {
         void set_vertex_input_attribute(VkVertexInputAttributeDescription const& attribute);
         void set_vertex_input_attributes(VkVertexInputAttributeDescriptions const& attributes);
 
+        // binding and attributes of a vertex_format
+        template<typename Format>
+        void set_vertex_input(ui32 binding = 0, ui32 first_location = 0) {
+            set_vertex_input_binding(Format::get_binding(binding));
+            set_vertex_input_attributes(Format::get_attributes(binding, first_location));
+        }
+
         void set_depth_test_and_write(bool test_enable = true, bool write_enable = true);
         void set_depth_compare_op(VkCompareOp compare_op);
 
@@ -78,7 +78,9 @@ namespace lava {
             .pClearValues = clear_values.data(),
         };
 
-        device->call().vkCmdBeginRenderPass(cmd_buf, &info, VK_SUBPASS_CONTENTS_INLINE);
+        auto contents = subpasses.empty() ? VK_SUBPASS_CONTENTS_INLINE : subpasses.front()->get_contents();
+
+        device->call().vkCmdBeginRenderPass(cmd_buf, &info, contents);
     }
 
     void render_pass::end(VkCommandBuffer cmd_buf) {
@@ -88,18 +90,29 @@ namespace lava {
     void render_pass::process(VkCommandBuffer cmd_buf, index frame) {
         begin(cmd_buf, frame);
 
-        ui32 count = 0;
+        for (auto i = 0u; i < subpasses.size(); ++i) {
+            auto& subpass = subpasses.at(i);
 
-        for (auto& subpass : subpasses) {
-            if (count > 0)
-                device->call().vkCmdNextSubpass(cmd_buf, VK_SUBPASS_CONTENTS_INLINE);
+            // every subpass is entered, inheritance needs its index
+            if (i > 0)
+                device->call().vkCmdNextSubpass(cmd_buf, subpass->get_contents());
 
             if (!subpass->activated())
                 continue;
 
-            subpass->process(cmd_buf, area.get_size());
+            if (!subpass->secondary()) {
+                subpass->process(cmd_buf, area.get_size());
+                continue;
+            }
 
-            ++count;
+            VkCommandBufferInheritanceInfo const inheritance{
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+                .renderPass = vk_render_pass,
+                .subpass = i,
+                .framebuffer = framebuffers[frame],
+            };
+
+            subpass->process_secondary(cmd_buf, area.get_size(), inheritance, frame);
         }
 
         end(cmd_buf);
@@ -151,6 +164,10 @@ namespace lava {
             ++count;
         }
 
+        // framebuffer handles may be reused
+        for (auto& subpass : subpasses)
+            subpass->invalidate();
+
         return true;
     }
 
@@ -2,6 +2,7 @@
 // copyright : Copyright (c) 2018-present, Lava Block OÜ
 // license   : MIT; see accompanying LICENSE file
 
+#include <liblava/base/device.hpp>
 #include <liblava/block/subpass.hpp>
 
 namespace lava {
@@ -21,9 +22,15 @@ namespace lava {
 
     void subpass::destroy() {
         clear_pipelines();
+        reset_secondary();
     }
 
     void subpass::clear_pipelines() {
+        for (auto& rec : recordings)
+            release(rec.second);
+
+        recordings.clear();
+
         for (auto& pipeline : pipelines)
             pipeline->destroy();
 
@@ -31,6 +38,12 @@ namespace lava {
     }
 
     void subpass::remove(graphics_pipeline::ptr pipeline) {
+        auto rec = recordings.find(pipeline->get_id());
+        if (rec != recordings.end()) {
+            release(rec->second);
+            recordings.erase(rec);
+        }
+
         lava::remove(pipelines, std::move(pipeline));
     }
 
@@ -126,6 +139,19 @@ namespace lava {
         description.pPreserveAttachments = preserve_attachments.data();
     }
 
+    void subpass::process(VkCommandBuffer cmd_buf, graphics_pipeline& pipeline, uv2 size) {
+        if (pipeline.auto_bind())
+            pipeline.bind(cmd_buf);
+
+        if (pipeline.auto_sizing())
+            pipeline.set_viewport_and_scissor(cmd_buf, size);
+
+        if (pipeline.auto_line_width())
+            pipeline.set_line_width(cmd_buf);
+
+        pipeline.on_process(cmd_buf);
+    }
+
     void subpass::process(VkCommandBuffer cmd_buf, uv2 size) {
         for (auto& pipeline : pipelines) {
             if (!pipeline->activated())
@@ -134,17 +160,199 @@ namespace lava {
             if (!pipeline->on_process)
                 continue;
 
-            if (pipeline->auto_bind())
-                pipeline->bind(cmd_buf);
+            process(cmd_buf, *pipeline, size);
+        }
+    }
+
+    bool subpass::set_secondary(device_ptr d, task_scheduler* s, ui32 lane_count) {
+        reset_secondary();
+
+        device = d;
+        scheduler = s;
+
+        if (!scheduler)
+            lane_count = 1;
+        else if (lane_count == 0)
+            lane_count = scheduler->get_worker_count() + 1;
+
+        lane_pools.resize(lane_count);
+        return true;
+    }
+
+    void subpass::reset_secondary() {
+        for (auto& rec : recordings)
+            release(rec.second);
+
+        recordings.clear();
+
+        for (auto& cmd_pools : lane_pools)
+            for (auto& cmd_pool : cmd_pools)
+                device->call().vkDestroyCommandPool(device->get(), cmd_pool, memory::alloc());
+
+        lane_pools.clear();
+
+        scheduler = nullptr;
+        device = nullptr;
+    }
+
+    void subpass::invalidate() {
+        for (auto& rec : recordings)
+            for (auto& state : rec.second.states)
+                state.valid = false;
+    }
+
+    bool subpass::prepare(recording& rec, index frame) {
+        auto& cmd_pools = lane_pools.at(rec.lane);
+
+        while (cmd_pools.size() <= frame) {
+            // buffers of one pool are recorded again at different times
+            VkCommandPoolCreateInfo const create_info{
+                .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+                .queueFamilyIndex = device->graphics_queue().family,
+            };
+
+            VkCommandPool cmd_pool = 0;
+            if (failed(device->call().vkCreateCommandPool(device->get(), &create_info, memory::alloc(), &cmd_pool))) {
+                log()->error("create subpass command pool");
+                return false;
+            }
+
+            cmd_pools.push_back(cmd_pool);
+        }
+
+        while (rec.buffers.size() <= frame) {
+            VkCommandBufferAllocateInfo const allocate_info{
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .commandPool = cmd_pools.at(rec.buffers.size()),
+                .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+                .commandBufferCount = 1,
+            };
+
+            VkCommandBuffer cmd_buf = 0;
+            if (failed(device->call().vkAllocateCommandBuffers(device->get(), &allocate_info, &cmd_buf))) {
+                log()->error("create subpass secondary command buffer");
+                return false;
+            }
+
+            rec.buffers.push_back(cmd_buf);
+        }
+
+        if (rec.states.size() <= frame)
+            rec.states.resize(frame + 1);
+
+        return true;
+    }
+
+    void subpass::release(recording& rec) {
+        auto& cmd_pools = lane_pools.at(rec.lane);
+
+        for (auto i = 0u; i < rec.buffers.size(); ++i)
+            device->call().vkFreeCommandBuffers(device->get(), cmd_pools.at(i), 1, &rec.buffers.at(i));
+
+        rec.buffers.clear();
+        rec.states.clear();
+    }
+
+    bool subpass::record(graphics_pipeline& pipeline, recording& rec, uv2 size,
+                         VkCommandBufferInheritanceInfo const& inheritance, index frame) {
+        auto cmd_buf = rec.buffers.at(frame);
+
+        VkCommandBufferBeginInfo const begin_info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+            .pInheritanceInfo = &inheritance,
+        };
+        if (failed(device->call().vkBeginCommandBuffer(cmd_buf, &begin_info)))
+            return false;
+
+        process(cmd_buf, pipeline, size);
+
+        if (failed(device->call().vkEndCommandBuffer(cmd_buf)))
+            return false;
+
+        auto& state = rec.states.at(frame);
+        state.valid = pipeline.reusable();
+        state.version = pipeline.get_version();
+        state.framebuffer = inheritance.framebuffer;
+        state.size = size;
+
+        return true;
+    }
+
+    bool subpass::process_secondary(VkCommandBuffer cmd_buf, uv2 size,
+                                    VkCommandBufferInheritanceInfo const& inheritance, index frame) {
+        auto lane_count = to_ui32(lane_pools.size());
+
+        VkCommandBuffers execute_buffers;
+
+        // [lane] -> pipelines to record
+        std::vector<std::vector<std::pair<graphics_pipeline*, recording*>>> lanes(lane_count);
+
+        for (auto& pipeline : pipelines) {
+            if (!pipeline->activated())
+                continue;
+
+            if (!pipeline->on_process)
+                continue;
+
+            auto [it, inserted] = recordings.try_emplace(pipeline->get_id());
+            auto& rec = it->second;
+            if (inserted)
+                rec.lane = to_index(recordings.size() - 1) % lane_count;
 
-            if (pipeline->auto_sizing())
-                pipeline->set_viewport_and_scissor(cmd_buf, size);
+            if (!prepare(rec, frame))
+                return false;
 
-            if (pipeline->auto_line_width())
-                pipeline->set_line_width(cmd_buf);
+            auto const& state = rec.states.at(frame);
+            auto reuse = state.valid
+                         && (state.version == pipeline->get_version())
+                         && (state.framebuffer == inheritance.framebuffer)
+                         && (state.size == size);
 
-            pipeline->on_process(cmd_buf);
+            if (!reuse)
+                lanes.at(rec.lane).emplace_back(pipeline.get(), &rec);
+
+            execute_buffers.push_back(rec.buffers.at(frame));
         }
+
+        auto record_lane = [&](index lane) {
+            for (auto& [pipeline, rec] : lanes.at(lane))
+                if (!record(*pipeline, *rec, size, inheritance, frame))
+                    return false;
+
+            return true;
+        };
+
+        auto result = true;
+
+        if (!scheduler || (lane_count < 2)) {
+            for (auto lane = 0u; lane < lane_count; ++lane)
+                result &= record_lane(lane);
+        } else {
+            std::vector<c8> results(lane_count, true);
+            task_group group;
+
+            for (auto lane = 1u; lane < lane_count; ++lane)
+                if (!lanes.at(lane).empty())
+                    scheduler->submit([&, lane]() { results.at(lane) = record_lane(lane); }, &group);
+
+            results.front() = record_lane(0);
+
+            scheduler->wait(group);
+
+            result = std::all_of(results.begin(), results.end(), [](c8 value) { return value; });
+        }
+
+        if (!result) {
+            log()->error("record subpass secondary command buffers");
+            return false;
+        }
+
+        if (!execute_buffers.empty())
+            device->call().vkCmdExecuteCommands(cmd_buf, to_ui32(execute_buffers.size()), execute_buffers.data());
+
+        return true;
     }
 
     subpass::ptr make_subpass(VkPipelineBindPoint pipeline_bind_point) {
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <liblava/block/pipeline.hpp>
+#include <liblava/util/scheduler.hpp>
 
 namespace lava {
 
@@ -30,6 +31,24 @@ namespace lava {
 
         void process(VkCommandBuffer cmd_buf, uv2 size);
 
+        // each pipeline records into its own secondary command buffer per frame
+        // scheduler -> lanes record in parallel, lane_count 0 -> workers + 1
+        bool set_secondary(device_ptr device, task_scheduler* scheduler = nullptr, ui32 lane_count = 0);
+        void reset_secondary();
+
+        bool secondary() const {
+            return !lane_pools.empty();
+        }
+        VkSubpassContents get_contents() const {
+            return secondary() ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+        }
+
+        // records outdated buffers and executes all of them
+        bool process_secondary(VkCommandBuffer cmd_buf, uv2 size, VkCommandBufferInheritanceInfo const& inheritance, index frame);
+
+        // all cached secondary command buffers recorded again
+        void invalidate();
+
         VkSubpassDescription get_description() const {
             return description;
         }
@@ -74,6 +93,36 @@ namespace lava {
         index_list preserve_attachments;
 
         graphics_pipeline::list pipelines;
+
+        struct recording {
+            using map = std::map<id, recording>;
+
+            index lane = 0;
+            VkCommandBuffers buffers;
+
+            struct state {
+                bool valid = false;
+                ui32 version = 0;
+                VkFramebuffer framebuffer = 0;
+                uv2 size = {};
+            };
+            std::vector<state> states;
+        };
+
+        static void process(VkCommandBuffer cmd_buf, graphics_pipeline& pipeline, uv2 size);
+
+        bool prepare(recording& rec, index frame);
+        void release(recording& rec);
+
+        bool record(graphics_pipeline& pipeline, recording& rec, uv2 size,
+                    VkCommandBufferInheritanceInfo const& inheritance, index frame);
+
+        device_ptr device = nullptr;
+        task_scheduler* scheduler = nullptr;
+
+        // [lane][frame], grown on demand
+        std::vector<VkCommandPools> lane_pools;
+        recording::map recordings;
     };
 
     subpass::ptr make_subpass(VkPipelineBindPoint pipeline_bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS);
@@ -8,6 +8,7 @@
 #include <liblava/core/def.hpp>
 #include <liblava/core/id.hpp>
 #include <liblava/core/math.hpp>
+#include <liblava/core/simd.hpp>
 #include <liblava/core/time.hpp>
 #include <liblava/core/types.hpp>
 #include <liblava/core/version.hpp>
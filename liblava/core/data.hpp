@@ -120,6 +120,25 @@ namespace lava {
         }
     };
 
+    // fnv-1a over 8 byte words, not stable across endianness
+    inline ui64 hash64(data_cptr data, size_t size, ui64 seed = 0xcbf29ce484222325ull) {
+        auto const prime = 0x100000001b3ull;
+        auto result = seed;
+
+        auto const words = size / sizeof(ui64);
+        for (auto i = 0u; i < words; ++i) {
+            ui64 word = 0;
+            memcpy(&word, data + i * sizeof(ui64), sizeof(ui64));
+
+            result = (result ^ word) * prime;
+        }
+
+        for (auto i = words * sizeof(ui64); i < size; ++i)
+            result = (result ^ static_cast<ui8>(data[i])) * prime;
+
+        return result;
+    }
+
     inline size_t next_pow_2(size_t x) {
         x--;
         x |= x >> 1;
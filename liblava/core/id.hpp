@@ -4,12 +4,16 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <deque>
 #include <liblava/core/types.hpp>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <set>
+#include <stdexcept>
+#include <unordered_map>
 
 namespace lava {
 
@@ -83,12 +87,35 @@ namespace lava {
             if (!reuse_ids)
                 return { ++next_id };
 
-            return get_next_locked();
+            if (this != &global())
+                return get_next_locked();
+
+            auto& cache = local_cache();
+            if (cache.free_ids.empty())
+                acquire_locked(cache.free_ids, cache_batch);
+
+            if (cache.free_ids.empty())
+                return { ++next_id };
+
+            auto next_id = cache.free_ids.back();
+            cache.free_ids.pop_back();
+            return { next_id.value, next_id.version + 1 };
         }
 
         void reuse(id::ref id) {
-            if (reuse_ids)
+            if (!reuse_ids)
+                return;
+
+            if (this != &global()) {
                 reuse_locked(id);
+                return;
+            }
+
+            auto& cache = local_cache();
+            cache.free_ids.push_back(id);
+
+            if (cache.free_ids.size() >= 2 * cache_batch)
+                release_locked(cache.free_ids, cache_batch);
         }
 
         void set_reuse(bool state) {
@@ -107,6 +134,23 @@ namespace lava {
         }
 
     private:
+        // per thread free ids of global(), exchanged with the shared pool in batches
+        struct id_cache {
+            ~id_cache() {
+                if (!free_ids.empty())
+                    ids::global().release_locked(free_ids, free_ids.size());
+            }
+
+            id::list free_ids;
+        };
+
+        static id_cache& local_cache() {
+            thread_local id_cache cache;
+            return cache;
+        }
+
+        static constexpr size_t const cache_batch = 64;
+
         id get_next_locked() {
             std::unique_lock<std::mutex> lock(queue_mutex);
             if (free_ids.empty())
@@ -122,6 +166,21 @@ namespace lava {
             free_ids.push_back(id);
         }
 
+        void acquire_locked(id::list& list, size_t count) {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            count = std::min(count, free_ids.size());
+
+            // oldest first, popped from the back
+            list.insert(list.end(), std::make_reverse_iterator(free_ids.begin() + count), std::make_reverse_iterator(free_ids.begin()));
+            free_ids.erase(free_ids.begin(), free_ids.begin() + count);
+        }
+
+        void release_locked(id::list& list, size_t count) {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            free_ids.insert(free_ids.end(), list.begin(), list.begin() + count);
+            list.erase(list.begin(), list.begin() + count);
+        }
+
         std::atomic<type> next_id = { undef };
         std::mutex queue_mutex;
 
@@ -129,15 +188,196 @@ namespace lava {
         std::deque<id> free_ids;
     };
 
+    // contiguous values in insertion order, O(1) lookup by id value
+    // erase leaves a hole, holes are compacted once they outnumber the values
     template<typename T>
-    inline id add_id_map(T const& object, std::map<id, T>& map) {
+    struct slot_map {
+        using value_type = std::pair<id, T>;
+        using list = std::vector<std::optional<value_type>>;
+
+        template<typename Value, typename Base>
+        struct basic_iterator {
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::remove_const_t<Value>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = Value*;
+            using reference = Value&;
+
+            basic_iterator() = default;
+            basic_iterator(Base current, Base last)
+            : current(current), last(last) {
+                skip();
+            }
+
+            reference operator*() const {
+                return **current;
+            }
+            pointer operator->() const {
+                return &**current;
+            }
+
+            basic_iterator& operator++() {
+                ++current;
+                skip();
+                return *this;
+            }
+            basic_iterator operator++(int) {
+                auto result = *this;
+                ++*this;
+                return result;
+            }
+
+            bool operator==(basic_iterator const& other) const {
+                return current == other.current;
+            }
+
+        private:
+            void skip() {
+                while ((current != last) && !current->has_value())
+                    ++current;
+            }
+
+            Base current;
+            Base last;
+        };
+
+        using iterator = basic_iterator<value_type, typename list::iterator>;
+        using const_iterator = basic_iterator<value_type const, typename list::const_iterator>;
+
+        bool emplace(id::ref key, T value) {
+            if (!key.valid())
+                return false;
+
+            if (key.value >= slots.size())
+                slots.resize(key.value + 1, no_index);
+            else if (slots[key.value] != no_index)
+                return false;
+
+            slots[key.value] = to_index(values.size());
+            values.emplace_back(std::in_place, key, std::move(value));
+            return true;
+        }
+
+        // invalidates iterators
+        bool erase(id::ref key) {
+            auto pos = find_index(key);
+            if (pos == no_index)
+                return false;
+
+            values[pos].reset();
+            slots[key.value] = no_index;
+            ++holes;
+
+            if (holes * 2 > values.size())
+                compact();
+
+            return true;
+        }
+
+        size_t count(id::ref key) const {
+            return find_index(key) != no_index ? 1 : 0;
+        }
+
+        T* find(id::ref key) {
+            auto pos = find_index(key);
+            return pos != no_index ? &values[pos]->second : nullptr;
+        }
+        T const* find(id::ref key) const {
+            auto pos = find_index(key);
+            return pos != no_index ? &values[pos]->second : nullptr;
+        }
+
+        T& at(id::ref key) {
+            auto pos = find_index(key);
+            if (pos == no_index)
+                throw std::out_of_range("slot_map::at");
+
+            return values[pos]->second;
+        }
+        T const& at(id::ref key) const {
+            auto pos = find_index(key);
+            if (pos == no_index)
+                throw std::out_of_range("slot_map::at");
+
+            return values[pos]->second;
+        }
+
+        void clear() {
+            slots.clear();
+            values.clear();
+            holes = 0;
+        }
+
+        void reserve(size_t size) {
+            values.reserve(size);
+        }
+
+        size_t size() const {
+            return values.size() - holes;
+        }
+        bool empty() const {
+            return size() == 0;
+        }
+
+        iterator begin() {
+            return { values.begin(), values.end() };
+        }
+        iterator end() {
+            return { values.end(), values.end() };
+        }
+        const_iterator begin() const {
+            return { values.begin(), values.end() };
+        }
+        const_iterator end() const {
+            return { values.end(), values.end() };
+        }
+
+    private:
+        index find_index(id::ref key) const {
+            if (!key.valid() || (key.value >= slots.size()))
+                return no_index;
+
+            auto const pos = slots[key.value];
+            if ((pos == no_index) || (values[pos]->first != key))
+                return no_index;
+
+            return pos;
+        }
+
+        // order kept, positions of the moved values rewritten
+        void compact() {
+            auto write = 0u;
+            for (auto read = 0u; read < values.size(); ++read) {
+                if (!values[read])
+                    continue;
+
+                if (write != read) {
+                    values[write] = std::move(values[read]);
+                    slots[values[write]->first.value] = write;
+                }
+
+                ++write;
+            }
+
+            values.resize(write);
+            holes = 0;
+        }
+
+        // id value -> position in values, no_index -> none
+        std::vector<index> slots;
+        list values;
+        size_t holes = 0;
+    };
+
+    template<typename T, typename Map>
+    inline id add_id_map(T const& object, Map& map) {
         auto next = ids::next();
         map.emplace(next, std::move(object));
         return next;
     }
 
-    template<typename T>
-    inline bool remove_id_map(id::ref object, std::map<id, T>& map) {
+    template<typename Map>
+    inline bool remove_id_map(id::ref object, Map& map) {
         if (!map.count(object))
             return false;
 
@@ -149,13 +389,53 @@ namespace lava {
 
     template<typename T>
     struct id_listeners {
-        id add(typename T::func const& listener) {
-            return add_id_map(listener, list);
+        using func = typename T::func;
+
+        // while calling -> added after the call
+        id add(func const& listener) {
+            if (calling == 0)
+                return add_id_map(listener, list);
+
+            auto next = ids::next();
+            added.emplace_back(next, listener);
+            return next;
         }
 
+        // while calling -> not called any more, erased after the call
         void remove(id& id) {
-            if (remove_id_map(id, list))
+            if (calling == 0) {
+                if (remove_id_map(id, list))
+                    id.invalidate();
+
+                return;
+            }
+
+            if (list.count(id) || std::any_of(added.begin(), added.end(), [&](auto const& item) { return item.first == id; })) {
+                removed.push_back(id);
                 id.invalidate();
+            }
+        }
+
+        // in order of addition until one returns true, listeners may add or remove listeners
+        template<typename... Args>
+        bool call(Args&&... args) {
+            ++calling;
+
+            auto handled = false;
+            for (auto& [listener_id, listener] : list) {
+                if (!removed.empty() && (std::find(removed.begin(), removed.end(), listener_id) != removed.end()))
+                    continue;
+
+                if (listener(args...)) {
+                    handled = true;
+                    break;
+                }
+            }
+
+            if ((--calling == 0) && (!added.empty() || !removed.empty()))
+                apply();
+
+            return handled;
         }
 
         typename T::listeners const& get_list() const {
@@ -163,14 +443,52 @@ namespace lava {
         }
 
     private:
+        void apply() {
+            auto pending = std::move(added);
+            added.clear();
+
+            for (auto& [listener_id, listener] : pending)
+                list.emplace(listener_id, std::move(listener));
+
+            for (auto& listener_id : removed)
+                remove_id_map(listener_id, list);
+
+            removed.clear();
+        }
+
         typename T::listeners list = {};
+
+        ui32 calling = 0;
+        std::vector<std::pair<id, func>> added;
+        id::list removed;
     };
 
     struct id_obj : interface {
         id_obj()
         : obj_id(ids::next()) {}
         ~id_obj() {
-            ids::free(obj_id);
+            if (obj_id.valid())
+                ids::free(obj_id);
+        }
+
+        // a copy would free the same id twice
+        id_obj(id_obj const&) = delete;
+        id_obj& operator=(id_obj const&) = delete;
+
+        // moved-from objects give up their id
+        id_obj(id_obj&& other) noexcept
+        : obj_id(other.obj_id) {
+            other.obj_id.invalidate();
+        }
+        id_obj& operator=(id_obj&& other) noexcept {
+            if (this != &other) {
+                if (obj_id.valid())
+                    ids::free(obj_id);
+
+                obj_id = other.obj_id;
+                other.obj_id.invalidate();
+            }
+            return *this;
         }
 
         id::ref get_id() const {
@@ -184,9 +502,9 @@ namespace lava {
     template<typename T, typename Meta>
     struct id_registry {
         using ptr = std::shared_ptr<T>;
-        using map = std::map<id, ptr>;
+        using map = slot_map<ptr>;
 
-        using meta_map = std::map<id, Meta>;
+        using meta_map = slot_map<Meta>;
 
         id create(Meta info = {}) {
             auto object = std::make_shared<T>();
@@ -205,10 +523,10 @@ namespace lava {
         }
 
         ptr get(id::ref object) const {
-            return objects.at(object).get();
+            return objects.at(object);
         }
         Meta get_meta(id::ref object) const {
-            return meta.at(object).get();
+            return meta.at(object);
         }
 
         map const& get_all() const {
@@ -220,6 +538,7 @@ namespace lava {
 
         void remove(id::ref object) {
             objects.erase(object);
+            meta.erase(object);
         }
 
     private:
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <liblava/core/types.hpp>
 
 #define GLM_FORCE_RADIANS
@@ -76,6 +77,85 @@ namespace lava {
         iv2 right_bottom = iv2();
     };
 
+    // planes point inside, depth zero to one
+    struct frustum {
+        enum side : ui32 {
+            left = 0,
+            right,
+            bottom,
+            top,
+            front, // near
+            back,  // far
+            count
+        };
+
+        frustum() = default;
+
+        // view_projection * model -> planes in model space
+        explicit frustum(mat4 const& matrix) {
+            auto const row = [&](i32 i) { return v4(matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]); };
+
+            planes[left] = row(3) + row(0);
+            planes[right] = row(3) - row(0);
+            planes[bottom] = row(3) + row(1);
+            planes[top] = row(3) - row(1);
+            planes[front] = row(2);
+            planes[back] = row(3) - row(2);
+
+            for (auto& plane : planes)
+                plane /= glm::length(v3(plane));
+        }
+
+        bool contains(v3 const& point) const {
+            return intersects(point, 0.f);
+        }
+
+        bool intersects(v3 const& center, r32 radius) const {
+            for (auto const& plane : planes)
+                if (glm::dot(v3(plane), center) + plane.w < -radius)
+                    return false;
+
+            return true;
+        }
+
+        // box corner furthest along each plane normal
+        bool intersects(v3 const& min, v3 const& max) const {
+            for (auto const& plane : planes) {
+                v3 const corner(plane.x >= 0.f ? max.x : min.x, plane.y >= 0.f ? max.y : min.y, plane.z >= 0.f ? max.z : min.z);
+                if (glm::dot(v3(plane), corner) + plane.w < 0.f)
+                    return false;
+            }
+
+            return true;
+        }
+
+        bool contains(v3 const& min, v3 const& max) const {
+            for (auto const& plane : planes) {
+                v3 const corner(plane.x >= 0.f ? min.x : max.x, plane.y >= 0.f ? min.y : max.y, plane.z >= 0.f ? min.z : max.z);
+                if (glm::dot(v3(plane), corner) + plane.w < 0.f)
+                    return false;
+            }
+
+            return true;
+        }
+
+        std::array<v4, count> planes = {};
+    };
+
+    struct ray {
+        ray() = default;
+
+        ray(v3 const& origin, v3 const& direction)
+        : origin(origin), direction(direction) {}
+
+        v3 at(r32 distance) const {
+            return origin + direction * distance;
+        }
+
+        v3 origin = v3(0.f);
+        v3 direction = v3(0.f, 0.f, -1.f); // normalized
+    };
+
     template<typename T>
     inline T ceil_div(T x, T y) {
         return (x + y - 1) / y;
@@ -0,0 +1,24 @@
+// file      : liblava/core/simd.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+// 0 -> scalar code paths only
+#ifndef LIBLAVA_SIMD
+#    define LIBLAVA_SIMD 1
+#endif
+
+#if LIBLAVA_SIMD && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)))
+#    define LIBLAVA_SIMD_SSE 1
+#    include <immintrin.h>
+#else
+#    define LIBLAVA_SIMD_SSE 0
+#endif
+
+// cmake LIBLAVA_AVX2 -> built for it
+#if LIBLAVA_SIMD_SSE && defined(__AVX__)
+#    define LIBLAVA_SIMD_AVX 1
+#else
+#    define LIBLAVA_SIMD_AVX 0
+#endif
@@ -8,3 +8,4 @@
 #include <liblava/file/file_system.hpp>
 #include <liblava/file/file_utils.hpp>
 #include <liblava/file/json_file.hpp>
+#include <liblava/file/mapped_file.hpp>
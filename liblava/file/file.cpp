@@ -39,8 +39,12 @@ namespace lava {
                     type = file_type::f_stream;
             } else {
                 i_stream = std::ifstream(path, std::ios::binary | std::ios::ate);
-                if (i_stream.is_open())
+                if (i_stream.is_open()) {
                     type = file_type::f_stream;
+
+                    stream_size = to_i64(i_stream.tellg());
+                    i_stream.seekg(0, std::ios::beg);
+                }
             }
         }
 
@@ -78,7 +82,7 @@ namespace lava {
             if (write_mode)
                 return to_i64(o_stream.tellp());
             else
-                return to_i64(i_stream.tellg());
+                return stream_size;
         }
 
         return file_error_result;
@@ -99,6 +103,53 @@ namespace lava {
         return file_error_result;
     }
 
+    i64 file::read_next(data_ptr data, ui64 size) {
+        if (write_mode)
+            return file_error_result;
+
+        if (type == file_type::fs) {
+            return PHYSFS_readBytes(fs_file, data, size);
+        } else if (type == file_type::f_stream) {
+            i_stream.read(data, size);
+
+            auto const count = to_i64(i_stream.gcount());
+            if (!i_stream)
+                i_stream.clear(); // short read at the end
+
+            return count;
+        }
+
+        return file_error_result;
+    }
+
+    bool file::seek(ui64 offset) {
+        if (type == file_type::fs) {
+            return PHYSFS_seek(fs_file, offset) != 0;
+        } else if (type == file_type::f_stream) {
+            if (write_mode)
+                o_stream.seekp(offset, std::ios::beg);
+            else
+                i_stream.seekg(offset, std::ios::beg);
+
+            return true;
+        }
+
+        return false;
+    }
+
+    i64 file::tell() const {
+        if (type == file_type::fs) {
+            return PHYSFS_tell(fs_file);
+        } else if (type == file_type::f_stream) {
+            if (write_mode)
+                return to_i64(o_stream.tellp());
+            else
+                return to_i64(i_stream.tellg());
+        }
+
+        return file_error_result;
+    }
+
     i64 file::write(data_cptr data, ui64 size) {
         if (!write_mode)
             return file_error_result;
@@ -39,6 +39,12 @@ namespace lava {
         }
         i64 read(data_ptr data, ui64 size);
 
+        // from the current position, bytes read
+        i64 read_next(data_ptr data, ui64 size);
+
+        bool seek(ui64 offset);
+        i64 tell() const;
+
         i64 write(data_cptr data, ui64 size);
 
         bool writable() const {
@@ -57,6 +63,7 @@ namespace lava {
         bool write_mode = false;
 
         name path = nullptr;
+        i64 stream_size = 0;
 
         PHYSFS_File* fs_file = nullptr;
         mutable std::ifstream i_stream;
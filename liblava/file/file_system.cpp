@@ -51,6 +51,19 @@ namespace lava {
         return PHYSFS_getRealDir(file);
     }
 
+    i64 file_system::get_last_modified(name file) {
+        PHYSFS_Stat stat;
+        if (PHYSFS_stat(file, &stat) != 0)
+            return stat.modtime;
+
+        std::error_code error;
+        auto time = fs::last_write_time(file, error);
+        if (error)
+            return 0;
+
+        return time.time_since_epoch().count();
+    }
+
     string_list file_system::enumerate_files(name path) {
         string_list result;
 
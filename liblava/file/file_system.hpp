@@ -28,6 +28,7 @@ namespace lava {
         static bool mount(name base_dir_path);
         static bool exists(name file);
         static name get_real_dir(name file);
+        static i64 get_last_modified(name file); // 0 -> unknown
         static string_list enumerate_files(name path);
 
         bool initialize(name argv_0, name org, name app, name ext);
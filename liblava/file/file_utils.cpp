@@ -2,10 +2,18 @@
 // copyright : Copyright (c) 2018-present, Lava Block OÜ
 // license   : MIT; see accompanying LICENSE file
 
+#include <atomic>
 #include <liblava/file/file.hpp>
 #include <liblava/file/file_system.hpp>
 #include <liblava/file/file_utils.hpp>
 #include <liblava/util/log.hpp>
+#include <thread>
+
+#ifdef _WIN32
+#    include <process.h>
+#else
+#    include <unistd.h>
+#endif
 
 bool lava::read_file(std::vector<char>& out, name filename) {
     std::ifstream file(filename, std::ios::ate | std::ios::binary);
@@ -79,6 +87,19 @@ bool lava::remove_existing_path(string& target, string_ref path) {
     return false;
 }
 
+lava::string lava::get_temp_filename(string_ref filename) {
+    static std::atomic<ui32> counter = { 0 };
+
+#ifdef _WIN32
+    auto const process = _getpid();
+#else
+    auto const process = getpid();
+#endif
+
+    return fmt::format("{}.{}.{:x}.{}.tmp", filename, process,
+                       std::hash<std::thread::id>()(std::this_thread::get_id()), counter.fetch_add(1));
+}
+
 bool lava::load_file_data(string_ref filename, data& target) {
     file file(str(filename));
     if (!file.opened())
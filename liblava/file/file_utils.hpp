@@ -5,6 +5,7 @@
 #pragma once
 
 #include <liblava/core/data.hpp>
+#include <streambuf>
 
 namespace lava {
 
@@ -20,6 +21,9 @@ namespace lava {
 
     bool remove_existing_path(string& target, string_ref path);
 
+    // next to filename, unique per process, thread and call - written aside, then renamed
+    string get_temp_filename(string_ref filename);
+
     bool load_file_data(string_ref filename, data& target);
 
     struct file_data : scope_data {
@@ -28,6 +32,13 @@ namespace lava {
         }
     };
 
+    // read-only view for std::istream, data must outlive it
+    struct data_stream_buffer : std::streambuf {
+        explicit data_stream_buffer(data const& source) {
+            setg(source.ptr, source.ptr, source.ptr + source.size);
+        }
+    };
+
     struct file_remover : no_copy_no_move {
         explicit file_remover(name filename = "")
         : filename(filename) {}
@@ -0,0 +1,101 @@
+// file      : liblava/file/mapped_file.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#include <liblava/file/mapped_file.hpp>
+
+#ifdef _WIN32
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#    endif
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+namespace lava {
+
+    bool mapped_file::open(string_ref path) {
+        close();
+
+#ifdef _WIN32
+        auto file = CreateFileA(str(path), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size) || (file_size.QuadPart == 0)) {
+            CloseHandle(file);
+            return false;
+        }
+
+        auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) {
+            CloseHandle(file);
+            return false;
+        }
+
+        auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!view) {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        file_handle = file;
+        mapping_handle = mapping;
+
+        ptr = static_cast<data_cptr>(view);
+        size = to_size_t(file_size.QuadPart);
+#else
+        auto file = ::open(str(path), O_RDONLY);
+        if (file < 0)
+            return false;
+
+        struct stat file_stat;
+        if ((fstat(file, &file_stat) != 0) || (file_stat.st_size == 0)) {
+            ::close(file);
+            return false;
+        }
+
+        auto view = mmap(nullptr, to_size_t(file_stat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+        // mapping keeps the file referenced
+        ::close(file);
+
+        if (view == MAP_FAILED)
+            return false;
+
+        ptr = static_cast<data_cptr>(view);
+        size = to_size_t(file_stat.st_size);
+
+        madvise(view, size, MADV_SEQUENTIAL);
+#endif
+
+        return true;
+    }
+
+    void mapped_file::close() {
+        if (!ptr)
+            return;
+
+#ifdef _WIN32
+        UnmapViewOfFile(ptr);
+        CloseHandle(mapping_handle);
+        CloseHandle(file_handle);
+
+        mapping_handle = nullptr;
+        file_handle = nullptr;
+#else
+        munmap(const_cast<data_ptr>(ptr), size);
+#endif
+
+        ptr = nullptr;
+        size = 0;
+    }
+
+} // namespace lava
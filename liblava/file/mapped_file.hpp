@@ -0,0 +1,45 @@
+// file      : liblava/file/mapped_file.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/core/data.hpp>
+
+namespace lava {
+
+    // read-only mapping of a file on disk, archives of file_system not supported
+    struct mapped_file : no_copy_no_move {
+        explicit mapped_file(string_ref path = {}) {
+            if (!path.empty())
+                open(path);
+        }
+        ~mapped_file() {
+            close();
+        }
+
+        bool open(string_ref path);
+        void close();
+
+        bool opened() const {
+            return ptr != nullptr;
+        }
+
+        data_cptr get() const {
+            return ptr;
+        }
+        size_t get_size() const {
+            return size;
+        }
+
+    private:
+        data_cptr ptr = nullptr;
+        size_t size = 0;
+
+#ifdef _WIN32
+        void* file_handle = nullptr;
+        void* mapping_handle = nullptr;
+#endif
+    };
+
+} // namespace lava
@@ -12,17 +12,11 @@ namespace lava {
 
     template<typename T>
     void _handle_events(input_events<T>& events, input_callback::func<T> input_callback) {
-        for (auto& event : events) {
-            auto handled = false;
-
-            for (auto& listener : events.listeners.get_list()) {
-                if (listener.second(event)) {
-                    handled = true;
-                    break;
-                }
-            }
+        if (events.empty())
+            return;
 
-            if (handled)
+        for (auto& event : events) {
+            if (events.listeners.call(event))
                 continue;
 
             if (input_callback)
@@ -173,7 +173,7 @@ namespace lava {
     struct key_event {
         using ref = key_event const&;
         using func = std::function<bool(ref)>;
-        using listeners = std::map<id, func>;
+        using listeners = slot_map<func>;
         using list = std::vector<key_event>;
 
         id sender;
@@ -211,7 +211,7 @@ namespace lava {
     struct scroll_event {
         using ref = scroll_event const&;
         using func = std::function<bool(ref)>;
-        using listeners = std::map<id, func>;
+        using listeners = slot_map<func>;
         using list = std::vector<scroll_event>;
 
         id sender;
@@ -227,7 +227,7 @@ namespace lava {
     struct mouse_move_event {
         using ref = mouse_move_event const&;
         using func = std::function<bool(ref)>;
-        using listeners = std::map<id, func>;
+        using listeners = slot_map<func>;
         using list = std::vector<mouse_move_event>;
 
         id sender;
@@ -255,7 +255,7 @@ namespace lava {
     struct mouse_button_event {
         using ref = mouse_button_event const&;
         using func = std::function<bool(ref)>;
-        using listeners = std::map<id, func>;
+        using listeners = slot_map<func>;
         using list = std::vector<mouse_button_event>;
 
         id sender;
@@ -276,7 +276,7 @@ namespace lava {
     struct path_drop_event {
         using ref = path_drop_event const&;
         using func = std::function<bool(ref)>;
-        using listeners = std::map<id, func>;
+        using listeners = slot_map<func>;
         using list = std::vector<path_drop_event>;
 
         id sender;
@@ -287,7 +287,7 @@ namespace lava {
     struct mouse_active_event {
         using ref = mouse_active_event const&;
         using func = std::function<bool(ref)>;
-        using listeners = std::map<id, func>;
+        using listeners = slot_map<func>;
         using list = std::vector<mouse_active_event>;
 
         id sender;
@@ -122,16 +122,37 @@ namespace lava {
     bool renderer::end_frame(VkCommandBuffers const& cmd_buffers) {
         assert(!cmd_buffers.empty());
 
-        std::array<VkSemaphore, 1> const wait_semaphores = { image_acquired_semaphores[current_sync] };
+        VkSemaphores wait_semaphores = { image_acquired_semaphores[current_sync] };
         std::array<VkSemaphore, 1> const sync_present_semaphores = { render_complete_semaphores[current_sync] };
 
-        VkPipelineStageFlags const wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        std::vector<VkPipelineStageFlags> wait_stages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+        std::vector<ui64> wait_values = { 0 };
+
+        wait_semaphores.insert(wait_semaphores.end(), extra_wait_semaphores.begin(), extra_wait_semaphores.end());
+        wait_stages.insert(wait_stages.end(), extra_wait_stages.begin(), extra_wait_stages.end());
+        wait_values.insert(wait_values.end(), extra_wait_values.begin(), extra_wait_values.end());
+
+        extra_wait_semaphores.clear();
+        extra_wait_stages.clear();
+        extra_wait_values.clear();
+
+        auto timeline = false;
+        for (auto value : wait_values)
+            if (value > 0)
+                timeline = true;
+
+        VkTimelineSemaphoreSubmitInfoKHR const timeline_info{
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR,
+            .waitSemaphoreValueCount = to_ui32(wait_values.size()),
+            .pWaitSemaphoreValues = wait_values.data(),
+        };
 
         VkSubmitInfo const submit_info{
             .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext = timeline ? &timeline_info : nullptr,
             .waitSemaphoreCount = to_ui32(wait_semaphores.size()),
             .pWaitSemaphores = wait_semaphores.data(),
-            .pWaitDstStageMask = &wait_stage,
+            .pWaitDstStageMask = wait_stages.data(),
             .commandBufferCount = to_ui32(cmd_buffers.size()),
             .pCommandBuffers = cmd_buffers.data(),
             .signalSemaphoreCount = to_ui32(sync_present_semaphores.size()),
@@ -141,8 +162,22 @@ namespace lava {
         std::array<VkSubmitInfo, 1> const submit_infos = { submit_info };
         VkFence current_fence = fences[current_sync];
 
-        if (!device->vkQueueSubmit(queue.vk_queue, to_ui32(submit_infos.size()), submit_infos.data(), current_fence))
+        if (!device->vkQueueSubmit(queue.vk_queue, to_ui32(submit_infos.size()), submit_infos.data(), current_fence)) {
+            // binary waits stay signaled otherwise, next signal of them would be invalid
+            // fence signaled as well, begin_frame waits for it
+            VkSubmitInfo const wait_info{
+                .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                .pNext = timeline ? &timeline_info : nullptr,
+                .waitSemaphoreCount = to_ui32(wait_semaphores.size()),
+                .pWaitSemaphores = wait_semaphores.data(),
+                .pWaitDstStageMask = wait_stages.data(),
+            };
+
+            if (!device->vkQueueSubmit(queue.vk_queue, 1, &wait_info, current_fence))
+                log()->error("renderer - consume wait semaphores");
+
             return false;
+        }
 
         std::array<VkSwapchainKHR, 1> const swapchains = { target->get() };
         std::array<ui32, 1> const indices = { frame_index };
@@ -27,6 +27,13 @@ namespace lava {
             return frame_index;
         }
 
+        // next end_frame only, value > 0 -> timeline semaphore
+        void add_wait_semaphore(VkSemaphore semaphore, VkPipelineStageFlags stage, ui64 value = 0) {
+            extra_wait_semaphores.push_back(semaphore);
+            extra_wait_stages.push_back(stage);
+            extra_wait_values.push_back(value);
+        }
+
         using destroy_func = std::function<void()>;
         destroy_func on_destroy;
 
@@ -46,6 +53,10 @@ namespace lava {
         VkFences fences_in_use = {};
         VkSemaphores image_acquired_semaphores = {};
         VkSemaphores render_complete_semaphores = {};
+
+        VkSemaphores extra_wait_semaphores = {};
+        std::vector<VkPipelineStageFlags> extra_wait_stages;
+        std::vector<ui64> extra_wait_values;
     };
 
 } // namespace lava
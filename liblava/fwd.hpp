@@ -13,7 +13,15 @@ namespace lava {
     struct gui;
 
     // liblava/asset.hpp
+    struct texture_data;
+    struct load_status;
+    struct asset_loader;
+    struct asset_budget;
+    struct asset_manager;
     struct scope_image;
+    struct mesh_cache_header;
+    struct streamed_texture;
+    struct texture_stream;
 
     // liblava/base.hpp
     struct target_callback;
@@ -30,7 +38,11 @@ namespace lava {
     struct attachment;
     struct command;
     struct block;
+    struct cull_object;
+    struct cull_push_constants;
+    struct instance_culler;
     struct descriptor;
+    struct mip_generator;
     struct pipeline_layout;
     struct pipeline;
     struct graphics_pipeline;
@@ -47,6 +59,8 @@ namespace lava {
     struct ids;
     struct id_obj;
     struct rect;
+    struct frustum;
+    struct ray;
     struct timer;
     struct run_time;
     struct no_copy_no_move;
@@ -61,6 +75,7 @@ namespace lava {
     struct file_data;
     struct file_callback;
     struct json_file;
+    struct mapped_file;
 
     // liblava/frame.hpp
     struct frame_config;
@@ -84,11 +99,24 @@ namespace lava {
 
     // liblava/resource.hpp
     struct buffer;
+    struct bvh;
+    struct mesh_bvh;
     struct image;
     struct vertex;
     struct mesh_data;
     struct mesh;
     struct mesh_meta;
+    struct mesh_bounds;
+    struct mesh_lod;
+    struct meshlet;
+    struct meshlet_bounds;
+    struct meshlet_data;
+    struct range_allocator;
+    struct geometry_pool;
+    struct draw_instance;
+    struct draw_batch;
+    struct vertex_cache_stats;
+    struct vertex_quantization;
     struct file_format;
     struct texture;
     struct staging;
@@ -100,5 +128,7 @@ namespace lava {
     struct telegram;
     struct dispatcher;
     struct thread_pool;
+    struct task_group;
+    struct task_scheduler;
 
 } // namespace lava
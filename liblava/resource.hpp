@@ -5,7 +5,16 @@
 #pragma once
 
 #include <liblava/resource/buffer.hpp>
+#include <liblava/resource/bvh.hpp>
+#include <liblava/resource/draw_batch.hpp>
 #include <liblava/resource/format.hpp>
+#include <liblava/resource/geometry_pool.hpp>
 #include <liblava/resource/image.hpp>
 #include <liblava/resource/mesh.hpp>
+#include <liblava/resource/mesh_lod.hpp>
+#include <liblava/resource/mesh_optimizer.hpp>
+#include <liblava/resource/meshlet.hpp>
+#include <liblava/resource/staging.hpp>
 #include <liblava/resource/texture.hpp>
+#include <liblava/resource/vertex_format.hpp>
+#include <liblava/resource/vertex_kernels.hpp>
@@ -109,4 +109,8 @@ namespace lava {
         vmaFlushAllocation(device->alloc(), allocation, offset, size);
     }
 
+    void buffer::invalidate(VkDeviceSize offset, VkDeviceSize size) {
+        vmaInvalidateAllocation(device->alloc(), allocation, offset, size);
+    }
+
 } // namespace lava
@@ -57,6 +57,9 @@ namespace lava {
 
         void flush(VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
 
+        // before reading gpu writes from a mapped buffer
+        void invalidate(VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
         VmaAllocation const& get_allocation() const {
             return allocation;
         }
@@ -0,0 +1,443 @@
+// file      : liblava/resource/bvh.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <liblava/core/simd.hpp>
+#include <liblava/resource/bvh.hpp>
+#include <numeric>
+
+namespace lava {
+
+    namespace {
+
+        static_assert(sizeof(bvh::node) == 32, "node must fit two sse loads");
+        static_assert(offsetof(bvh::node, first) == sizeof(v3), "first must follow min");
+        static_assert(offsetof(bvh::node, max) == 16, "max must start the second half");
+
+        constexpr ui32 bin_count = 16;
+
+        struct bin {
+            bvh::box bounds;
+            ui32 count = 0;
+        };
+
+    } // namespace
+
+    bvh::box bvh::box::transform(mat4 const& matrix) const {
+        if (!valid())
+            return *this;
+
+        box result;
+        result.min = v3(matrix[3]);
+        result.max = result.min;
+
+        // per axis extremes of each column, affine only
+        for (auto c = 0; c < 3; ++c) {
+            auto const a = v3(matrix[c]) * min[c];
+            auto const b = v3(matrix[c]) * max[c];
+
+            result.min += glm::min(a, b);
+            result.max += glm::max(a, b);
+        }
+
+        return result;
+    }
+
+    bool bvh::build(box::list const& primitive_boxes, ui32 max_leaf_size) {
+        clear();
+
+        if (primitive_boxes.empty())
+            return false;
+
+        boxes = primitive_boxes;
+        max_leaf_size = std::max(max_leaf_size, 1u);
+
+        auto const primitive_count = to_ui32(boxes.size());
+
+        primitives.resize(primitive_count);
+        std::iota(primitives.begin(), primitives.end(), 0);
+
+        std::vector<v3> centers(primitive_count);
+        for (auto i = 0u; i < primitive_count; ++i)
+            centers[i] = boxes[i].center();
+
+        nodes.reserve(2 * primitive_count - 1);
+        nodes.emplace_back();
+
+        struct task {
+            index node;
+            ui32 first;
+            ui32 count;
+            ui32 depth;
+        };
+
+        std::vector<task> tasks;
+        tasks.push_back({ 0, 0, primitive_count, 1 });
+
+        while (!tasks.empty()) {
+            auto const current = tasks.back();
+            tasks.pop_back();
+
+            auto const begin = primitives.begin() + current.first;
+            auto const end = begin + current.count;
+
+            box bounds;
+            box center_bounds;
+
+            for (auto it = begin; it != end; ++it) {
+                bounds.grow(boxes[*it]);
+                center_bounds.grow(centers[*it]);
+            }
+
+            nodes[current.node].min = bounds.min;
+            nodes[current.node].max = bounds.max;
+
+            auto split = current.first;
+
+            if ((current.count > max_leaf_size) && (current.depth < max_depth)) {
+                auto best_axis = -1;
+                auto best_bin = 0u;
+                auto best_cost = std::numeric_limits<r32>::max();
+
+                auto const bin_index = [&](index primitive, int axis) {
+                    auto const extent = center_bounds.max[axis] - center_bounds.min[axis];
+                    auto const offset = (centers[primitive][axis] - center_bounds.min[axis]) * (bin_count / extent);
+
+                    return std::min(bin_count - 1, to_ui32(offset));
+                };
+
+                for (auto axis = 0; axis < 3; ++axis) {
+                    if (center_bounds.max[axis] <= center_bounds.min[axis])
+                        continue;
+
+                    std::array<bin, bin_count> bins;
+
+                    for (auto it = begin; it != end; ++it) {
+                        auto& target = bins[bin_index(*it, axis)];
+                        target.bounds.grow(boxes[*it]);
+                        ++target.count;
+                    }
+
+                    // sweep from the left, then score every plane from the right
+                    std::array<r32, bin_count - 1> left_costs;
+                    std::array<ui32, bin_count - 1> left_counts;
+
+                    box left;
+                    auto left_count = 0u;
+
+                    for (auto i = 0u; i < bin_count - 1; ++i) {
+                        left.grow(bins[i].bounds);
+                        left_count += bins[i].count;
+
+                        left_costs[i] = to_r32(left_count) * left.area();
+                        left_counts[i] = left_count;
+                    }
+
+                    box right;
+                    auto right_count = 0u;
+
+                    for (auto i = bin_count - 1; i > 0; --i) {
+                        right.grow(bins[i].bounds);
+                        right_count += bins[i].count;
+
+                        if ((left_counts[i - 1] == 0) || (right_count == 0))
+                            continue;
+
+                        auto const cost = left_costs[i - 1] + to_r32(right_count) * right.area();
+                        if (cost < best_cost) {
+                            best_cost = cost;
+                            best_axis = axis;
+                            best_bin = i;
+                        }
+                    }
+                }
+
+                if (best_axis >= 0) {
+                    auto const middle = std::partition(begin, end, [&](index primitive) {
+                        return bin_index(primitive, best_axis) < best_bin;
+                    });
+
+                    split = to_ui32(middle - primitives.begin());
+                }
+
+                // equal centers -> halve in any order
+                if ((split == current.first) || (split == current.first + current.count))
+                    split = current.first + current.count / 2;
+            }
+
+            if (split == current.first) {
+                nodes[current.node].first = current.first;
+                nodes[current.node].count = current.count;
+                continue;
+            }
+
+            auto const left = to_ui32(nodes.size());
+
+            nodes[current.node].first = left;
+            nodes[current.node].count = 0;
+
+            nodes.emplace_back();
+            nodes.emplace_back();
+
+            tasks.push_back({ left + 1, split, current.first + current.count - split, current.depth + 1 });
+            tasks.push_back({ left, current.first, split - current.first, current.depth + 1 });
+        }
+
+        return true;
+    }
+
+    void bvh::clear() {
+        nodes.clear();
+        primitives.clear();
+        boxes.clear();
+    }
+
+    bool bvh::refit(box::list const& primitive_boxes) {
+        if (empty() || (primitive_boxes.size() != boxes.size()))
+            return false;
+
+        boxes = primitive_boxes;
+
+        // children always follow their parent
+        for (auto i = to_ui32(nodes.size()); i-- > 0;) {
+            auto& current = nodes[i];
+
+            box bounds;
+
+            if (current.leaf()) {
+                for (auto p = current.first; p < current.first + current.count; ++p)
+                    bounds.grow(boxes[primitives[p]]);
+            } else {
+                for (auto c = current.first; c < current.first + 2; ++c)
+                    bounds.grow(box{ nodes[c].min, nodes[c].max });
+            }
+
+            current.min = bounds.min;
+            current.max = bounds.max;
+        }
+
+        return true;
+    }
+
+    void bvh::query(frustum const& frustum, index_list& result) const {
+        result.clear();
+
+        if (empty())
+            return;
+
+        struct entry {
+            index node;
+            bool inside;
+        };
+
+        std::array<entry, max_depth * 2> stack;
+        auto size = 0u;
+
+        stack[size++] = { 0, false };
+
+        while (size > 0) {
+            auto const current = stack[--size];
+            auto const& node = nodes[current.node];
+
+            // fully inside -> no more plane tests below
+            auto inside = current.inside;
+            if (!inside) {
+                if (!frustum.intersects(node.min, node.max))
+                    continue;
+
+                inside = frustum.contains(node.min, node.max);
+            }
+
+            if (node.leaf()) {
+                for (auto i = node.first; i < node.first + node.count; ++i) {
+                    auto const primitive = primitives[i];
+
+                    if (inside || frustum.intersects(boxes[primitive].min, boxes[primitive].max))
+                        result.push_back(primitive);
+                }
+
+                continue;
+            }
+
+            stack[size++] = { node.first + 1, inside };
+            stack[size++] = { node.first, inside };
+        }
+    }
+
+    bvh::hit bvh::intersect(ray const& ray, r32 max_distance) const {
+        auto const data = prepare(ray);
+
+        return intersect(
+            ray,
+            [&](index primitive, auto const&, r32 distance) {
+                node const leaf{ boxes[primitive].min, 0, boxes[primitive].max, 1 };
+                return slab(leaf, data, distance);
+            },
+            max_distance);
+    }
+
+    bvh::ray_data bvh::prepare(ray const& ray) {
+        ray_data result;
+
+        for (auto i = 0; i < 3; ++i) {
+            result.origin[i] = ray.origin[i];
+
+            // finite -> no 0 * inf in the slab test
+            auto const direction = ray.direction[i];
+            result.inv_direction[i] = std::abs(direction) > std::numeric_limits<r32>::epsilon()
+                                          ? 1.f / direction
+                                          : std::copysign(std::numeric_limits<r32>::max(), direction);
+        }
+
+        result.origin[3] = 0.f;
+        result.inv_direction[3] = 0.f;
+
+        return result;
+    }
+
+    r32 bvh::slab(node const& node, ray_data const& ray, r32 max_distance) {
+#if LIBLAVA_SIMD_SSE
+        // lane 3 holds first / count, left out of the reduction
+        auto const origin = _mm_load_ps(ray.origin.data());
+        auto const inv_direction = _mm_load_ps(ray.inv_direction.data());
+
+        auto const t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&node.min.x), origin), inv_direction);
+        auto const t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&node.max.x), origin), inv_direction);
+
+        auto const t_min = _mm_min_ps(t1, t2);
+        auto const t_max = _mm_max_ps(t1, t2);
+
+        auto const enter = _mm_max_ss(_mm_max_ss(t_min, _mm_shuffle_ps(t_min, t_min, _MM_SHUFFLE(1, 1, 1, 1))),
+                                      _mm_max_ss(_mm_shuffle_ps(t_min, t_min, _MM_SHUFFLE(2, 2, 2, 2)), _mm_setzero_ps()));
+        auto const exit = _mm_min_ss(_mm_min_ss(t_max, _mm_shuffle_ps(t_max, t_max, _MM_SHUFFLE(1, 1, 1, 1))),
+                                     _mm_min_ss(_mm_shuffle_ps(t_max, t_max, _MM_SHUFFLE(2, 2, 2, 2)), _mm_set_ss(max_distance)));
+
+        auto const result = _mm_cvtss_f32(enter);
+        return result <= _mm_cvtss_f32(exit) ? result : -1.f;
+#else
+        auto t_enter = 0.f;
+        auto t_exit = max_distance;
+
+        for (auto i = 0; i < 3; ++i) {
+            auto const t1 = (node.min[i] - ray.origin[i]) * ray.inv_direction[i];
+            auto const t2 = (node.max[i] - ray.origin[i]) * ray.inv_direction[i];
+
+            t_enter = std::max(t_enter, std::min(t1, t2));
+            t_exit = std::min(t_exit, std::max(t1, t2));
+        }
+
+        return t_enter <= t_exit ? t_enter : -1.f;
+#endif
+    }
+
+    bool mesh_bvh::gather(mesh_data const& data, bvh::box::list& boxes) {
+        auto const& vertices = data.vertices;
+
+        auto const index_count = data.indices.empty() ? to_ui32(vertices.size()) : to_ui32(data.indices.size());
+        auto const triangle_count = index_count / 3;
+
+        corners.resize(to_size_t(triangle_count) * 3);
+        boxes.resize(triangle_count);
+
+        for (auto t = 0u; t < triangle_count; ++t) {
+            bvh::box bounds;
+
+            for (auto c = 0u; c < 3; ++c) {
+                auto const i = t * 3 + c;
+                auto const vertex_index = data.indices.empty() ? i : data.indices[i];
+
+                if (vertex_index >= vertices.size()) {
+                    log()->error("mesh bvh - index {} out of range", vertex_index);
+                    return false;
+                }
+
+                corners[i] = vertices[vertex_index].position;
+                bounds.grow(corners[i]);
+            }
+
+            boxes[t] = bounds;
+        }
+
+        return triangle_count > 0;
+    }
+
+    bool mesh_bvh::build(mesh_data const& data, ui32 max_leaf_size) {
+        clear();
+
+        bvh::box::list boxes;
+        if (!gather(data, boxes)) {
+            clear();
+            return false;
+        }
+
+        return tree.build(boxes, max_leaf_size);
+    }
+
+    void mesh_bvh::clear() {
+        tree.clear();
+        corners.clear();
+    }
+
+    bool mesh_bvh::refit(mesh_data const& data) {
+        auto const triangle_count = get_triangle_count();
+
+        bvh::box::list boxes;
+        if (!gather(data, boxes) || (boxes.size() != triangle_count)) {
+            clear();
+            return false;
+        }
+
+        return tree.refit(boxes);
+    }
+
+    mesh_bvh::hit mesh_bvh::intersect(ray const& ray, r32 max_distance) const {
+        hit result;
+        result.distance = max_distance;
+
+        auto const tree_hit = tree.intersect(
+            ray,
+            [&](index triangle, auto const& r, r32 distance) {
+                // möller trumbore, both sides
+                auto const& a = corners[triangle * 3];
+                auto const edge_1 = corners[triangle * 3 + 1] - a;
+                auto const edge_2 = corners[triangle * 3 + 2] - a;
+
+                auto const p = glm::cross(r.direction, edge_2);
+                auto const det = glm::dot(edge_1, p);
+                if (std::abs(det) < 1e-12f)
+                    return -1.f;
+
+                auto const inv_det = 1.f / det;
+
+                auto const s = r.origin - a;
+                auto const u = glm::dot(s, p) * inv_det;
+                if ((u < 0.f) || (u > 1.f))
+                    return -1.f;
+
+                auto const q = glm::cross(s, edge_1);
+                auto const v = glm::dot(r.direction, q) * inv_det;
+                if ((v < 0.f) || (u + v > 1.f))
+                    return -1.f;
+
+                auto const t = glm::dot(edge_2, q) * inv_det;
+                if ((t < 0.f) || (t >= distance))
+                    return -1.f;
+
+                result.barycentric = v2(u, v);
+                return t;
+            },
+            max_distance);
+
+        result.triangle = tree_hit.primitive;
+        result.distance = tree_hit.distance;
+
+        if (!result.valid())
+            result.barycentric = v2(0.f);
+
+        return result;
+    }
+
+} // namespace lava
@@ -0,0 +1,239 @@
+// file      : liblava/resource/bvh.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <array>
+#include <liblava/resource/mesh.hpp>
+#include <limits>
+#include <type_traits>
+
+namespace lava {
+
+    // bounding volume hierarchy over boxes, binned sah build
+    struct bvh {
+        struct box {
+            using list = std::vector<box>;
+
+            v3 min = v3(std::numeric_limits<r32>::max());
+            v3 max = v3(-std::numeric_limits<r32>::max());
+
+            void grow(v3 const& point) {
+                min = glm::min(min, point);
+                max = glm::max(max, point);
+            }
+            void grow(box const& other) {
+                min = glm::min(min, other.min);
+                max = glm::max(max, other.max);
+            }
+
+            bool valid() const {
+                return (min.x <= max.x) && (min.y <= max.y) && (min.z <= max.z);
+            }
+
+            v3 center() const {
+                return (min + max) * 0.5f;
+            }
+
+            // half surface
+            r32 area() const {
+                if (!valid())
+                    return 0.f;
+
+                auto const size = max - min;
+                return size.x * size.y + size.y * size.z + size.z * size.x;
+            }
+
+            // box around the transformed box
+            box transform(mat4 const& matrix) const;
+        };
+
+        // count 0 -> inner node, children at first and first + 1
+        struct node {
+            v3 min = v3(0.f);
+            ui32 first = 0;
+            v3 max = v3(0.f);
+            ui32 count = 0;
+
+            bool leaf() const {
+                return count > 0;
+            }
+        };
+
+        struct hit {
+            index primitive = no_index;
+            r32 distance = std::numeric_limits<r32>::max();
+
+            bool valid() const {
+                return primitive != no_index;
+            }
+        };
+
+        // primitive index -> position in boxes
+        bool build(box::list const& boxes, ui32 max_leaf_size = 4);
+        void clear();
+
+        // same primitives moved, keeps the tree -> rebuild after large motion
+        bool refit(box::list const& boxes);
+
+        // primitives whose box is in the frustum
+        void query(frustum const& frustum, index_list& result) const;
+
+        // nearest primitive box
+        hit intersect(ray const& ray, r32 max_distance = std::numeric_limits<r32>::max()) const;
+
+        // test(primitive, ray, max_distance) -> distance, negative on miss
+        template<typename Test>
+        requires std::is_invocable_r_v<r32, Test, index, ray const&, r32>
+        hit intersect(ray const& ray, Test&& test, r32 max_distance = std::numeric_limits<r32>::max()) const;
+
+        bool empty() const {
+            return nodes.empty();
+        }
+
+        box get_bounds() const {
+            return empty() ? box{} : box{ nodes.front().min, nodes.front().max };
+        }
+
+        ui32 get_primitive_count() const {
+            return to_ui32(boxes.size());
+        }
+
+        std::vector<node> const& get_nodes() const {
+            return nodes;
+        }
+        box::list const& get_boxes() const {
+            return boxes;
+        }
+
+        // limits the traversal stack
+        static constexpr ui32 max_depth = 64;
+
+    private:
+        // w 0, sse loads
+        struct ray_data {
+            alignas(16) std::array<r32, 4> origin;
+            alignas(16) std::array<r32, 4> inv_direction;
+        };
+
+        static ray_data prepare(ray const& ray);
+
+        // entry distance, negative on miss
+        static r32 slab(node const& node, ray_data const& ray, r32 max_distance);
+
+        std::vector<node> nodes;
+        index_list primitives;
+        box::list boxes;
+    };
+
+    template<typename Test>
+    requires std::is_invocable_r_v<r32, Test, index, ray const&, r32>
+    inline bvh::hit bvh::intersect(ray const& ray, Test&& test, r32 max_distance) const {
+        hit result;
+        result.distance = max_distance;
+
+        if (empty())
+            return result;
+
+        auto const data = prepare(ray);
+
+        struct entry {
+            index node;
+            r32 distance;
+        };
+
+        std::array<entry, max_depth * 2> stack;
+        auto size = 0u;
+
+        auto const root = slab(nodes.front(), data, result.distance);
+        if (root >= 0.f)
+            stack[size++] = { 0, root };
+
+        while (size > 0) {
+            auto const current = stack[--size];
+
+            // closer hit since push
+            if (current.distance > result.distance)
+                continue;
+
+            auto const& node = nodes[current.node];
+
+            if (node.leaf()) {
+                for (auto i = node.first; i < node.first + node.count; ++i) {
+                    auto const primitive = primitives[i];
+
+                    auto const hit_distance = test(primitive, ray, result.distance);
+                    if ((hit_distance >= 0.f) && (hit_distance < result.distance)) {
+                        result.distance = hit_distance;
+                        result.primitive = primitive;
+                    }
+                }
+
+                continue;
+            }
+
+            auto const left = slab(nodes[node.first], data, result.distance);
+            auto const right = slab(nodes[node.first + 1], data, result.distance);
+
+            // nearer child on top
+            if ((left >= 0.f) && (right >= 0.f)) {
+                if (left <= right) {
+                    stack[size++] = { node.first + 1, right };
+                    stack[size++] = { node.first, left };
+                } else {
+                    stack[size++] = { node.first, left };
+                    stack[size++] = { node.first + 1, right };
+                }
+            } else if (left >= 0.f) {
+                stack[size++] = { node.first, left };
+            } else if (right >= 0.f) {
+                stack[size++] = { node.first + 1, right };
+            }
+        }
+
+        return result;
+    }
+
+    // triangles of mesh data, indices or sequential vertices
+    struct mesh_bvh {
+        struct hit {
+            index triangle = no_index;
+            r32 distance = std::numeric_limits<r32>::max();
+
+            // weights of the second and third corner
+            v2 barycentric = v2(0.f);
+
+            bool valid() const {
+                return triangle != no_index;
+            }
+        };
+
+        bool build(mesh_data const& data, ui32 max_leaf_size = 4);
+        void clear();
+
+        // vertices moved, same triangles
+        bool refit(mesh_data const& data);
+
+        void query(frustum const& frustum, index_list& triangles) const {
+            tree.query(frustum, triangles);
+        }
+
+        hit intersect(ray const& ray, r32 max_distance = std::numeric_limits<r32>::max()) const;
+
+        ui32 get_triangle_count() const {
+            return to_ui32(corners.size() / 3);
+        }
+
+        bvh const& get_tree() const {
+            return tree;
+        }
+
+    private:
+        bool gather(mesh_data const& data, bvh::box::list& boxes);
+
+        bvh tree;
+        std::vector<v3> corners; // 3 per triangle
+    };
+
+} // namespace lava
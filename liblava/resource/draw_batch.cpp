@@ -0,0 +1,170 @@
+// file      : liblava/resource/draw_batch.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#include <algorithm>
+#include <liblava/resource/draw_batch.hpp>
+
+namespace lava {
+
+    bool draw_batch::create(geometry_pool::ptr p, index frame_count, ui32 instance_capacity) {
+        pool = p;
+        if (!pool || !pool->get_device() || (frame_count == 0))
+            return false;
+
+        auto device = pool->get_device();
+
+        multi_draw = device->get_features().multiDrawIndirect;
+        first_instance = device->get_features().drawIndirectFirstInstance;
+        max_draw_count = multi_draw ? std::max(1u, device->get_properties().limits.maxDrawIndirectCount) : 1;
+
+        frames.resize(frame_count);
+
+        for (auto& frame : frames)
+            if (!reserve(frame, instance_capacity))
+                return false;
+
+        return true;
+    }
+
+    void draw_batch::destroy() {
+        frames.clear();
+        items.clear();
+        order.clear();
+
+        pool = nullptr;
+    }
+
+    bool draw_batch::reserve(frame_data& frame, ui32 instance_count) {
+        if (frame.instance_buffer && (instance_count <= frame.capacity))
+            return true;
+
+        auto capacity = std::max(frame.capacity, 64u);
+        while (capacity < instance_count)
+            capacity *= 2;
+
+        // frame index reuse -> its last submit is done
+        frame.instance_buffer = make_buffer();
+        if (!frame.instance_buffer->create_mapped(pool->get_device(), nullptr, sizeof(draw_instance) * capacity,
+                                                  VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)) {
+            log()->error("create draw batch instance buffer");
+            return false;
+        }
+
+        // at most one command per instance
+        frame.command_buffer = make_buffer();
+        if (!frame.command_buffer->create_mapped(pool->get_device(), nullptr, sizeof(VkDrawIndexedIndirectCommand) * capacity,
+                                                 VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)) {
+            log()->error("create draw batch command buffer");
+            return false;
+        }
+
+        frame.capacity = capacity;
+        return true;
+    }
+
+    bool draw_batch::update(index frame) {
+        if (!pool || (frame >= frames.size()))
+            return false;
+
+        auto& data = frames[frame];
+        data.commands.clear();
+
+        if (items.empty())
+            return true;
+
+        if (!reserve(data, to_ui32(items.size())))
+            return false;
+
+        order.resize(items.size());
+        for (auto i = 0u; i < order.size(); ++i)
+            order[i] = i;
+
+        std::sort(order.begin(), order.end(), [&](index a, index b) { return items[a].geometry < items[b].geometry; });
+
+        auto instances = (draw_instance*) data.instance_buffer->get_mapped_data();
+        auto instance_count = 0u;
+
+        for (auto i = 0u; i < order.size();) {
+            auto const& geometry = items[order[i]].geometry;
+
+            auto end = i + 1;
+            while ((end < order.size()) && (items[order[end]].geometry == geometry))
+                ++end;
+
+            if (auto range = pool->get(geometry)) {
+                data.commands.push_back({
+                    .indexCount = range->index_count,
+                    .instanceCount = end - i,
+                    .firstIndex = range->first_index,
+                    .vertexOffset = to_i32(range->first_vertex),
+                    .firstInstance = instance_count,
+                });
+
+                for (auto k = i; k < end; ++k)
+                    instances[instance_count++].transform = items[order[k]].transform;
+            }
+
+            i = end;
+        }
+
+        auto commands = (VkDrawIndexedIndirectCommand*) data.command_buffer->get_mapped_data();
+        memcpy(commands, data.commands.data(), sizeof(VkDrawIndexedIndirectCommand) * data.commands.size());
+
+        // no drawIndirectFirstInstance -> instance buffer bound at the offset per command
+        if (!first_instance)
+            for (auto c = 0u; c < data.commands.size(); ++c)
+                commands[c].firstInstance = 0;
+
+        data.instance_buffer->flush(0, sizeof(draw_instance) * instance_count);
+        data.command_buffer->flush(0, sizeof(VkDrawIndexedIndirectCommand) * data.commands.size());
+
+        return true;
+    }
+
+    void draw_batch::draw(VkCommandBuffer cmd_buf, index frame) const {
+        if (!pool || (frame >= frames.size()))
+            return;
+
+        auto const& data = frames[frame];
+        if (data.commands.empty())
+            return;
+
+        pool->bind(cmd_buf);
+
+        auto const instance_buffer = data.instance_buffer->get();
+        auto const command_buffer = data.command_buffer->get();
+        auto const stride = to_ui32(sizeof(VkDrawIndexedIndirectCommand));
+        auto const command_count = to_ui32(data.commands.size());
+
+        if (!first_instance) {
+            for (auto c = 0u; c < command_count; ++c) {
+                VkDeviceSize const offset = sizeof(draw_instance) * data.commands[c].firstInstance;
+                vkCmdBindVertexBuffers(cmd_buf, 1, 1, &instance_buffer, &offset);
+
+                vkCmdDrawIndexedIndirect(cmd_buf, command_buffer, stride * c, 1, stride);
+            }
+
+            return;
+        }
+
+        VkDeviceSize const offset = 0;
+        vkCmdBindVertexBuffers(cmd_buf, 1, 1, &instance_buffer, &offset);
+
+        for (auto first = 0u; first < command_count; first += max_draw_count)
+            vkCmdDrawIndexedIndirect(cmd_buf, command_buffer, stride * first, std::min(max_draw_count, command_count - first), stride);
+    }
+
+    VkVertexInputBindingDescription draw_batch::get_instance_binding(ui32 binding) {
+        return { binding, sizeof(draw_instance), VK_VERTEX_INPUT_RATE_INSTANCE };
+    }
+
+    VkVertexInputAttributeDescriptions draw_batch::get_instance_attributes(ui32 binding, ui32 first_location) {
+        VkVertexInputAttributeDescriptions result;
+        for (auto i = 0u; i < 4; ++i)
+            result.push_back({ first_location + i, binding, VK_FORMAT_R32G32B32A32_SFLOAT, to_ui32(sizeof(v4) * i) });
+
+        return result;
+    }
+
+} // namespace lava
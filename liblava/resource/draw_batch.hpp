@@ -0,0 +1,88 @@
+// file      : liblava/resource/draw_batch.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/resource/geometry_pool.hpp>
+
+namespace lava {
+
+    // vertex input rate instance
+    struct draw_instance {
+        mat4 transform;
+    };
+
+    // (geometry, transform) list -> instances and indexed indirect commands
+    struct draw_batch : id_obj {
+        using ptr = std::shared_ptr<draw_batch>;
+
+        ~draw_batch() {
+            destroy();
+        }
+
+        // buffers per frame in flight, grow on update
+        bool create(geometry_pool::ptr pool, index frame_count, ui32 instance_capacity = 1024);
+        void destroy();
+
+        void clear() {
+            items.clear();
+        }
+        void add(id::ref geometry, mat4 const& transform) {
+            items.push_back({ geometry, transform });
+        }
+
+        // one command per geometry, removed geometries are skipped
+        bool update(index frame);
+
+        // binds pool and instances, a single call with multiDrawIndirect
+        void draw(VkCommandBuffer cmd_buf, index frame) const;
+
+        ui32 get_instance_count() const {
+            return to_ui32(items.size());
+        }
+        ui32 get_command_count(index frame) const {
+            return frame < frames.size() ? to_ui32(frames[frame].commands.size()) : 0;
+        }
+
+        geometry_pool::ptr get_pool() {
+            return pool;
+        }
+
+        static VkVertexInputBindingDescription get_instance_binding(ui32 binding = 1);
+
+        // transform columns in four locations
+        static VkVertexInputAttributeDescriptions get_instance_attributes(ui32 binding = 1, ui32 first_location = 4);
+
+    private:
+        struct item {
+            id geometry;
+            mat4 transform;
+        };
+
+        struct frame_data {
+            buffer::ptr instance_buffer;
+            buffer::ptr command_buffer;
+            ui32 capacity = 0;
+
+            std::vector<VkDrawIndexedIndirectCommand> commands;
+        };
+
+        bool reserve(frame_data& frame, ui32 instance_count);
+
+        geometry_pool::ptr pool;
+
+        std::vector<item> items;
+        std::vector<frame_data> frames;
+        index_list order;
+
+        bool multi_draw = false;
+        bool first_instance = false;
+        ui32 max_draw_count = 1;
+    };
+
+    inline draw_batch::ptr make_draw_batch() {
+        return std::make_shared<draw_batch>();
+    }
+
+} // namespace lava
@@ -336,6 +336,21 @@ bool lava::get_supported_depth_format(VkPhysicalDevice physical_device, VkFormat
     return false;
 }
 
+bool lava::format_blit_supported(VkPhysicalDevice physical_device, VkFormat format) {
+    VkFormatProperties format_props;
+    vkGetPhysicalDeviceFormatProperties(physical_device, format, &format_props);
+
+    auto const features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (format_props.optimalTilingFeatures & features) == features;
+}
+
+bool lava::format_storage_supported(VkPhysicalDevice physical_device, VkFormat format) {
+    VkFormatProperties format_props;
+    vkGetPhysicalDeviceFormatProperties(physical_device, format, &format_props);
+
+    return format_props.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT;
+}
+
 VkImageMemoryBarrier lava::image_memory_barrier(VkImage image, VkImageLayout old_layout, VkImageLayout new_layout) {
     return {
         .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
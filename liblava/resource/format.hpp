@@ -26,6 +26,11 @@ namespace lava {
 
     bool get_supported_depth_format(VkPhysicalDevice physical_device, VkFormat* depth_format);
 
+    // vkCmdBlitImage with linear filter, optimal tiling
+    bool format_blit_supported(VkPhysicalDevice physical_device, VkFormat format);
+
+    bool format_storage_supported(VkPhysicalDevice physical_device, VkFormat format);
+
     VkImageMemoryBarrier image_memory_barrier(VkImage image, VkImageLayout old_layout, VkImageLayout new_layout);
 
     void set_image_layout(device_ptr device, VkCommandBuffer cmd_buffer, VkImage image, VkImageLayout old_image_layout,
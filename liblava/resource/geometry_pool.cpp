@@ -0,0 +1,217 @@
+// file      : liblava/resource/geometry_pool.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#include <liblava/resource/geometry_pool.hpp>
+#include <liblava/resource/vertex_kernels.hpp>
+
+namespace lava {
+
+    void range_allocator::reset(ui32 c) {
+        capacity = c;
+        used = 0;
+
+        free_ranges.clear();
+        if (capacity > 0)
+            free_ranges.emplace(0, capacity);
+    }
+
+    index range_allocator::alloc(ui32 count) {
+        if (count == 0)
+            return no_index;
+
+        for (auto it = free_ranges.begin(); it != free_ranges.end(); ++it) {
+            if (it->second < count)
+                continue;
+
+            auto const offset = it->first;
+            auto const rest = it->second - count;
+
+            free_ranges.erase(it);
+            if (rest > 0)
+                free_ranges.emplace(offset + count, rest);
+
+            used += count;
+            return offset;
+        }
+
+        return no_index;
+    }
+
+    void range_allocator::free(index offset, ui32 count) {
+        if (count == 0)
+            return;
+
+        auto start = offset;
+        auto size = count;
+
+        auto next = free_ranges.lower_bound(offset);
+
+        if (next != free_ranges.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset) {
+                start = prev->first;
+                size += prev->second;
+                free_ranges.erase(prev);
+            }
+        }
+
+        if ((next != free_ranges.end()) && (offset + count == next->first)) {
+            size += next->second;
+            free_ranges.erase(next);
+        }
+
+        free_ranges.emplace(start, size);
+        used -= count;
+    }
+
+    bool geometry_pool::create(device_ptr d, ui32 vertex_capacity, ui32 index_capacity, lava::staging* st) {
+        device = d;
+        staging = st;
+
+        auto create_buffer = [&](buffer::ptr& target, size_t size, VkBufferUsageFlags usage) {
+            target = make_buffer();
+
+            if (staging)
+                return target->create(device, nullptr, size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+
+            return target->create_mapped(device, nullptr, size, usage);
+        };
+
+        if (!create_buffer(vertex_buffer, to_size_t(vertex_capacity) * vertex_stride, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)) {
+            log()->error("create geometry pool vertex buffer");
+            return false;
+        }
+
+        if (!create_buffer(index_buffer, sizeof(ui32) * index_capacity, VK_BUFFER_USAGE_INDEX_BUFFER_BIT)) {
+            log()->error("create geometry pool index buffer");
+            return false;
+        }
+
+        vertex_allocator.reset(vertex_capacity);
+        index_allocator.reset(index_capacity);
+
+        return true;
+    }
+
+    void geometry_pool::destroy() {
+        for (auto& [geometry, range] : ranges)
+            ids::free(geometry);
+
+        ranges.clear();
+
+        vertex_allocator.reset(0);
+        index_allocator.reset(0);
+
+        vertex_buffer = nullptr;
+        index_buffer = nullptr;
+
+        device = nullptr;
+        staging = nullptr;
+    }
+
+    id geometry_pool::add(mesh_data const& data) {
+        if (!vertex_buffer || data.vertices.empty())
+            return undef_id;
+
+        auto const vertex_count = to_ui32(data.vertices.size());
+        auto const index_count = data.indices.empty() ? vertex_count : to_ui32(data.indices.size());
+
+        auto const first_vertex = vertex_allocator.alloc(vertex_count);
+        if (first_vertex == no_index) {
+            log()->error("geometry pool - no room for {} vertices", vertex_count);
+            return undef_id;
+        }
+
+        auto const first_index = index_allocator.alloc(index_count);
+        if (first_index == no_index) {
+            vertex_allocator.free(first_vertex, vertex_count);
+
+            log()->error("geometry pool - no room for {} indices", index_count);
+            return undef_id;
+        }
+
+        auto const vertex_offset = to_size_t(first_vertex) * vertex_stride;
+        auto const vertex_size = to_size_t(vertex_count) * vertex_stride;
+
+        std::vector<char> packed;
+        if (pack) {
+            vertex_quantization quantization;
+            pack(data.vertices, packed, quantization);
+        }
+
+        index_list sequential;
+        if (data.indices.empty()) {
+            sequential.resize(index_count);
+            for (auto i = 0u; i < index_count; ++i)
+                sequential[i] = i;
+        }
+
+        auto const& indices = data.indices.empty() ? sequential : data.indices;
+
+        if (!write(vertex_buffer, vertex_offset, pack ? (void const*) packed.data() : data.vertices.data(), vertex_size)
+            || !write(index_buffer, sizeof(ui32) * first_index, indices.data(), sizeof(ui32) * index_count)) {
+            vertex_allocator.free(first_vertex, vertex_count);
+            index_allocator.free(first_index, index_count);
+
+            log()->error("geometry pool - upload {} vertices", vertex_count);
+            return undef_id;
+        }
+
+        auto const bounds = compute_bounds(data.vertices);
+
+        auto const result = ids::next();
+        ranges.emplace(result, range{ first_vertex, vertex_count, first_index, index_count, bounds.center, bounds.radius });
+
+        return result;
+    }
+
+    bool geometry_pool::write(buffer::ptr const& target, size_t offset, void const* data, size_t size) {
+        if (staging)
+            return staging->add(target, data, size, offset);
+
+        memcpy((data_ptr) target->get_mapped_data() + offset, data, size);
+        target->flush(offset, size);
+
+        return true;
+    }
+
+    bool geometry_pool::remove(id::ref geometry) {
+        auto it = ranges.find(geometry);
+        if (it == ranges.end())
+            return false;
+
+        vertex_allocator.free(it->second.first_vertex, it->second.vertex_count);
+        index_allocator.free(it->second.first_index, it->second.index_count);
+
+        ids::free(it->first);
+        ranges.erase(it);
+
+        return true;
+    }
+
+    geometry_pool::range const* geometry_pool::get(id::ref geometry) const {
+        auto it = ranges.find(geometry);
+        return it != ranges.end() ? &it->second : nullptr;
+    }
+
+    void geometry_pool::bind(VkCommandBuffer cmd_buf) const {
+        if (!vertex_buffer || !vertex_buffer->valid() || !index_buffer || !index_buffer->valid())
+            return;
+
+        std::array<VkDeviceSize, 1> const buffer_offsets = { 0 };
+        std::array<VkBuffer, 1> const buffers = { vertex_buffer->get() };
+
+        vkCmdBindVertexBuffers(cmd_buf, 0, to_ui32(buffers.size()), buffers.data(), buffer_offsets.data());
+        vkCmdBindIndexBuffer(cmd_buf, index_buffer->get(), 0, VK_INDEX_TYPE_UINT32);
+    }
+
+    void geometry_pool::draw(VkCommandBuffer cmd_buf, id::ref geometry, ui32 instance_count, ui32 first_instance) const {
+        auto range = get(geometry);
+        if (!range)
+            return;
+
+        vkCmdDrawIndexed(cmd_buf, range->index_count, instance_count, range->first_index, to_i32(range->first_vertex), first_instance);
+    }
+
+} // namespace lava
@@ -0,0 +1,141 @@
+// file      : liblava/resource/geometry_pool.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/resource/staging.hpp>
+
+namespace lava {
+
+    // first fit in a fixed capacity, neighbours merge on free
+    struct range_allocator {
+        void reset(ui32 capacity);
+
+        // no_index -> no range large enough
+        index alloc(ui32 count);
+        void free(index offset, ui32 count);
+
+        ui32 get_capacity() const {
+            return capacity;
+        }
+        ui32 get_used() const {
+            return used;
+        }
+
+    private:
+        std::map<index, ui32> free_ranges; // offset -> count
+
+        ui32 capacity = 0;
+        ui32 used = 0;
+    };
+
+    // many meshes in one vertex and one index buffer, drawn with vertex offset
+    struct geometry_pool : id_obj {
+        using ptr = std::shared_ptr<geometry_pool>;
+
+        struct range {
+            index first_vertex = 0;
+            ui32 vertex_count = 0;
+            index first_index = 0;
+            ui32 index_count = 0;
+
+            // object space bounding sphere
+            v3 center = v3(0.f);
+            r32 radius = 0.f;
+        };
+
+        ~geometry_pool() {
+            destroy();
+        }
+
+        // before create, per mesh quantization does not fit one buffer
+        template<typename Format>
+        void set_format() {
+            static_assert(!Format::quantized, "geometry pool needs an unquantized vertex format");
+            set_format(Format::stride, &Format::pack);
+        }
+        void set_format(ui32 stride, mesh::pack_func func) {
+            vertex_stride = stride;
+            pack = func;
+        }
+
+        // capacities in vertices and indices
+        // staging -> device local, added geometry uploaded with it
+        // staging nullptr -> host visible, read over the bus on discrete gpus
+        bool create(device_ptr device, ui32 vertex_capacity, ui32 index_capacity, lava::staging* staging = nullptr);
+        void destroy();
+
+        // invalid id -> pool full, data without indices gets a sequential list
+        // with staging drawable once it staged
+        id add(mesh_data const& data);
+        id add(mesh::ptr mesh) {
+            return add(mesh->get_data());
+        }
+
+        // only once no frame in flight draws it
+        bool remove(id::ref geometry);
+
+        range const* get(id::ref geometry) const;
+
+        bool contains(id::ref geometry) const {
+            return ranges.count(geometry);
+        }
+
+        void bind(VkCommandBuffer cmd_buf) const;
+        void draw(VkCommandBuffer cmd_buf, id::ref geometry, ui32 instance_count = 1, ui32 first_instance = 0) const;
+
+        void bind_draw(VkCommandBuffer cmd_buf, id::ref geometry) const {
+            bind(cmd_buf);
+            draw(cmd_buf, geometry);
+        }
+
+        device_ptr get_device() {
+            return device;
+        }
+
+        ui32 get_vertex_stride() const {
+            return vertex_stride;
+        }
+
+        ui32 get_geometry_count() const {
+            return to_ui32(ranges.size());
+        }
+
+        range_allocator const& get_vertex_allocator() const {
+            return vertex_allocator;
+        }
+        range_allocator const& get_index_allocator() const {
+            return index_allocator;
+        }
+
+        buffer::ptr get_vertex_buffer() {
+            return vertex_buffer;
+        }
+        buffer::ptr get_index_buffer() {
+            return index_buffer;
+        }
+
+    private:
+        bool write(buffer::ptr const& target, size_t offset, void const* data, size_t size);
+
+        device_ptr device = nullptr;
+        lava::staging* staging = nullptr;
+
+        ui32 vertex_stride = sizeof(vertex);
+        mesh::pack_func pack = nullptr;
+
+        buffer::ptr vertex_buffer;
+        buffer::ptr index_buffer;
+
+        range_allocator vertex_allocator;
+        range_allocator index_allocator;
+
+        std::map<id, range> ranges;
+    };
+
+    inline geometry_pool::ptr make_geometry_pool() {
+        return std::make_shared<geometry_pool>();
+    }
+
+} // namespace lava
@@ -51,15 +51,21 @@ namespace lava {
 
         info.extent = { size.x, size.y, 1 };
 
+        if (mip_levels_generation)
+            set_level_count(mip_level_count(size));
+
         if (!vk_image) {
             VmaAllocationCreateInfo create_info{
                 .usage = memory_usage,
             };
 
-            if (failed(vmaCreateImage(device->alloc(), &info, &create_info, &vk_image, &allocation, nullptr))) {
+            VmaAllocationInfo allocation_info = {};
+            if (failed(vmaCreateImage(device->alloc(), &info, &create_info, &vk_image, &allocation, &allocation_info))) {
                 log()->error("create image");
                 return false;
             }
+
+            memory_size = allocation_info.size;
         }
 
         view_info.image = vk_image;
@@ -81,6 +87,7 @@ namespace lava {
             vmaDestroyImage(device->alloc(), vk_image, allocation);
             vk_image = 0;
             allocation = nullptr;
+            memory_size = 0;
         }
 
         device = nullptr;
@@ -8,6 +8,15 @@
 
 namespace lava {
 
+    // levels of a full mip chain
+    inline ui32 mip_level_count(uv2 size) {
+        auto result = 1u;
+        for (auto extent = std::max(size.x, size.y); extent > 1; extent /= 2)
+            ++result;
+
+        return result;
+    }
+
     struct image : id_obj {
         using ptr = std::shared_ptr<image>;
         using map = std::map<id, ptr>;
@@ -15,6 +24,7 @@ namespace lava {
 
         explicit image(VkFormat format, VkImage vk_image = 0);
 
+        // mip_levels_generation -> full chain down to 1x1
         bool create(device_ptr device, uv2 size, VmaMemoryUsage memory_usage = VMA_MEMORY_USAGE_GPU_ONLY, bool mip_levels_generation = false);
         void destroy(bool view_only = false);
         void destroy_view() {
@@ -38,6 +48,11 @@ namespace lava {
         VkImage get() const {
             return vk_image;
         }
+
+        // 0 -> swapchain or external image
+        VkDeviceSize get_memory_size() const {
+            return memory_size;
+        }
         VkImageView get_view() const {
             return view;
         }
@@ -92,6 +107,7 @@ namespace lava {
         VkImageCreateInfo info;
 
         VmaAllocation allocation = nullptr;
+        VkDeviceSize memory_size = 0;
 
         VkImageView view = 0;
 
@@ -3,9 +3,54 @@
 // license   : MIT; see accompanying LICENSE file
 
 #include <liblava/resource/mesh.hpp>
+#include <liblava/resource/vertex_kernels.hpp>
+#include <unordered_map>
 
 namespace lava {
 
+    void mesh_data::move(v3 position) {
+        translate_vertices(vertices, position);
+    }
+
+    void mesh_data::scale(r32 factor) {
+        scale_vertices(vertices, factor);
+    }
+
+    void mesh_data::transform(mat4 const& matrix) {
+        transform_vertices(vertices, matrix);
+    }
+
+    size_t mesh_data::weld() {
+        auto const vertex_count = vertices.size();
+
+        vertex::list unique_vertices;
+        unique_vertices.reserve(vertex_count);
+
+        std::unordered_map<vertex, ui32> unique_indices;
+        unique_indices.reserve(vertex_count);
+
+        index_list remap(vertex_count);
+
+        for (auto i = 0u; i < vertex_count; ++i) {
+            auto [it, inserted] = unique_indices.try_emplace(vertices[i], to_ui32(unique_vertices.size()));
+            if (inserted)
+                unique_vertices.push_back(vertices[i]);
+
+            remap[i] = it->second;
+        }
+
+        if (indices.empty()) {
+            indices = std::move(remap);
+        } else {
+            for (auto& index : indices)
+                index = remap.at(index);
+        }
+
+        vertices = std::move(unique_vertices);
+
+        return vertex_count - vertices.size();
+    }
+
     void mesh::add_data(mesh_data const& value) {
         auto index_base = to_ui32(data.vertices.size());
 
@@ -20,10 +65,17 @@ namespace lava {
         mapped = m;
         memory_usage = mu;
 
+        // gpu only -> filled by staging
+        auto host_visible = memory_usage != VMA_MEMORY_USAGE_GPU_ONLY;
+
+        if (pack)
+            pack(data.vertices, packed_vertices, quantization);
+
         if (!data.vertices.empty()) {
             vertex_buffer = make_buffer();
 
-            if (!vertex_buffer->create(device, data.vertices.data(), sizeof(vertex) * data.vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, mapped, memory_usage)) {
+            if (!vertex_buffer->create(device, host_visible ? get_vertex_data() : nullptr, get_vertex_data_size(),
+                                       VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, mapped, memory_usage)) {
                 log()->error("create mesh vertex buffer");
                 return false;
             }
@@ -32,7 +84,8 @@ namespace lava {
         if (!data.indices.empty()) {
             index_buffer = make_buffer();
 
-            if (!index_buffer->create(device, data.indices.data(), sizeof(ui32) * data.indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, mapped, memory_usage)) {
+            if (!index_buffer->create(device, host_visible ? data.indices.data() : nullptr, sizeof(ui32) * data.indices.size(),
+                                      VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, mapped, memory_usage)) {
                 log()->error("create mesh index buffer");
                 return false;
             }
@@ -157,7 +210,7 @@ lava::mesh::ptr lava::create_mesh(device_ptr device, mesh_type type) {
             20,
         };
 
-        if (!cube->create(device))
+        if (device && !cube->create(device))
             return nullptr;
 
         return cube;
@@ -170,7 +223,7 @@ lava::mesh::ptr lava::create_mesh(device_ptr device, mesh_type type) {
         triangle->get_vertices().push_back({ { -1.f, 1.f, 0.f }, { 1.f, 1.f, 1.f, 1.f }, { 0.f, 1.f }, { 0.f, 0.f, 1.f } });
         triangle->get_vertices().push_back({ { 0.f, -1.f, 0.f }, { 1.f, 1.f, 1.f, 1.f }, { 0.5f, 0.f }, { 0.f, 0.f, 1.f } });
 
-        if (!triangle->create(device))
+        if (device && !triangle->create(device))
             return nullptr;
 
         return triangle;
@@ -188,7 +241,7 @@ lava::mesh::ptr lava::create_mesh(device_ptr device, mesh_type type) {
 
         quad->get_indices() = { 0, 1, 2, 2, 3, 0 };
 
-        if (!quad->create(device))
+        if (device && !quad->create(device))
             return nullptr;
 
         return quad;
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <cstring>
 #include <liblava/resource/buffer.hpp>
 
 namespace lava {
@@ -21,19 +22,23 @@ namespace lava {
         }
     };
 
+    // position = offset + scale * packed
+    struct vertex_quantization {
+        v3 offset = v3(0.f);
+        v3 scale = v3(1.f);
+    };
+
     struct mesh_data {
         vertex::list vertices;
         index_list indices;
 
-        void move(v3 position) {
-            for (auto& vertex : vertices)
-                vertex.position += position;
-        }
+        // see vertex_kernels
+        void move(v3 position);
+        void scale(r32 factor);
+        void transform(mat4 const& matrix);
 
-        void scale(r32 factor) {
-            for (auto& vertex : vertices)
-                vertex.position *= factor;
-        }
+        // merges equal vertices, returns number of removed vertices
+        size_t weld();
     };
 
     struct mesh : id_obj {
@@ -94,6 +99,33 @@ namespace lava {
 
         bool reload();
 
+        using pack_func = void (*)(vertex::list const&, std::vector<char>&, vertex_quantization&);
+
+        // vertex buffer in a vertex_format, packed on create
+        template<typename Format>
+        void set_format() {
+            set_format(Format::stride, &Format::pack);
+        }
+        void set_format(ui32 stride, pack_func func) {
+            vertex_stride = stride;
+            pack = func;
+        }
+
+        ui32 get_vertex_stride() const {
+            return vertex_stride;
+        }
+        vertex_quantization const& get_quantization() const {
+            return quantization;
+        }
+
+        // content of the vertex buffer
+        data_cptr get_vertex_data() const {
+            return pack ? packed_vertices.data() : (data_cptr) data.vertices.data();
+        }
+        size_t get_vertex_data_size() const {
+            return pack ? packed_vertices.size() : sizeof(vertex) * data.vertices.size();
+        }
+
         buffer::ptr get_vertex_buffer() {
             return vertex_buffer;
         }
@@ -111,13 +143,21 @@ namespace lava {
 
         bool mapped = false;
         VmaMemoryUsage memory_usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+
+        ui32 vertex_stride = sizeof(vertex);
+        pack_func pack = nullptr;
+
+        std::vector<char> packed_vertices;
+        vertex_quantization quantization;
     };
 
     inline mesh::ptr make_mesh() {
         return std::make_shared<mesh>();
     }
 
-    mesh::ptr load_mesh(device_ptr device, name filename);
+    // optimize -> vertex cache, overdraw and fetch order, see optimize_mesh, vertices reordered
+    // device nullptr -> mesh data only, not created
+    mesh::ptr load_mesh(device_ptr device, name filename, bool optimize = false);
 
     enum class mesh_type : type {
         none = 0,
@@ -126,6 +166,7 @@ namespace lava {
         quad
     };
 
+    // device nullptr -> mesh data only
     mesh::ptr create_mesh(device_ptr device, mesh_type type);
 
     struct mesh_meta {
@@ -136,3 +177,31 @@ namespace lava {
     using mesh_registry = id_registry<mesh, mesh_meta>;
 
 } // namespace lava
+
+template<>
+struct std::hash<lava::vertex> {
+    size_t operator()(lava::vertex const& vertex) const noexcept {
+        size_t result = 0;
+
+        auto combine = [&](lava::r32 value) {
+            // -0 == 0
+            value += 0.f;
+
+            lava::ui32 bits = 0;
+            std::memcpy(&bits, &value, sizeof(bits));
+
+            result ^= std::hash<lava::ui32>()(bits) + 0x9e3779b9 + (result << 6) + (result >> 2);
+        };
+
+        for (auto i = 0; i < 3; ++i)
+            combine(vertex.position[i]);
+        for (auto i = 0; i < 4; ++i)
+            combine(vertex.color[i]);
+        for (auto i = 0; i < 2; ++i)
+            combine(vertex.uv[i]);
+        for (auto i = 0; i < 3; ++i)
+            combine(vertex.normal[i]);
+
+        return result;
+    }
+};
@@ -0,0 +1,568 @@
+// file      : liblava/resource/mesh_lod.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#include <algorithm>
+#include <functional>
+#include <liblava/resource/mesh_lod.hpp>
+#include <liblava/resource/mesh_optimizer.hpp>
+#include <unordered_map>
+
+namespace lava {
+
+    namespace {
+
+        struct quadric {
+            r64 a00 = 0.0, a11 = 0.0, a22 = 0.0;
+            r64 a01 = 0.0, a02 = 0.0, a12 = 0.0;
+            r64 b0 = 0.0, b1 = 0.0, b2 = 0.0;
+            r64 c = 0.0;
+            r64 weight = 0.0;
+
+            // plane n.p + d = 0, n normalized
+            void add_plane(v3 n, r32 d, r32 w) {
+                a00 += w * n.x * n.x;
+                a11 += w * n.y * n.y;
+                a22 += w * n.z * n.z;
+                a01 += w * n.x * n.y;
+                a02 += w * n.x * n.z;
+                a12 += w * n.y * n.z;
+                b0 += w * n.x * d;
+                b1 += w * n.y * d;
+                b2 += w * n.z * d;
+                c += w * d * d;
+                weight += w;
+            }
+
+            quadric& operator+=(quadric const& other) {
+                a00 += other.a00;
+                a11 += other.a11;
+                a22 += other.a22;
+                a01 += other.a01;
+                a02 += other.a02;
+                a12 += other.a12;
+                b0 += other.b0;
+                b1 += other.b1;
+                b2 += other.b2;
+                c += other.c;
+                weight += other.weight;
+                return *this;
+            }
+
+            // mean squared distance to the planes
+            r64 error(v3 p) const {
+                r64 const x = p.x, y = p.y, z = p.z;
+
+                auto result = a00 * x * x + a11 * y * y + a22 * z * z
+                              + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                              + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+
+                return weight > 0.0 ? std::max(result, 0.0) / weight : 0.0;
+            }
+        };
+
+        struct collapse {
+            index source = 0;
+            index target = 0;
+            r64 cost = 0.0;
+        };
+
+        // per welded edge, seam -> both sides use other vertices
+        struct edge_use {
+            ui32 count = 0;
+            ui64 vertices = 0;
+            bool seam = false;
+        };
+
+        ui64 edge_key(index a, index b) {
+            if (a > b)
+                std::swap(a, b);
+
+            return (ui64(a) << 32) | b;
+        }
+
+        v3 face_normal(v3 const& p0, v3 const& p1, v3 const& p2) {
+            return glm::cross(p1 - p0, p2 - p0);
+        }
+
+        // vertices sharing a position -> one representative, all of them in a ring by next_wedge
+        index_list group_positions(vertex::list const& vertices, index_list& next_wedge) {
+            auto const vertex_count = vertices.size();
+
+            index_list order(vertex_count);
+            for (auto i = 0u; i < vertex_count; ++i)
+                order[i] = i;
+
+            std::sort(order.begin(), order.end(), [&](index a, index b) {
+                auto const& pa = vertices[a].position;
+                auto const& pb = vertices[b].position;
+                return std::tie(pa.x, pa.y, pa.z) < std::tie(pb.x, pb.y, pb.z);
+            });
+
+            index_list result(vertex_count);
+            next_wedge.resize(vertex_count);
+
+            for (auto i = 0u; i < vertex_count;) {
+                auto j = i;
+                while ((j < vertex_count) && (vertices[order[j]].position == vertices[order[i]].position)) {
+                    result[order[j]] = order[i];
+                    ++j;
+                }
+
+                for (auto k = i; k < j; ++k)
+                    next_wedge[order[k]] = order[k + 1 < j ? k + 1 : i];
+
+                i = j;
+            }
+
+            return result;
+        }
+
+    } // namespace
+
+    index_list simplify_mesh(index_list const& indices, vertex::list const& vertices, size_t target_index_count,
+                             r32 target_error, r32* result_error) {
+        auto const vertex_count = vertices.size();
+
+        if (result_error)
+            *result_error = 0.f;
+
+        index_list result = indices;
+        if ((result.size() % 3 != 0) || (result.size() <= target_index_count))
+            return result;
+
+        for (auto index : result)
+            if (index >= vertex_count)
+                return result;
+
+        // collapses run on welded positions, vertices of a position follow along
+        index_list next_wedge;
+        auto const position_group = group_positions(vertices, next_wedge);
+
+        std::unordered_map<ui64, edge_use> edges;
+        edges.reserve(result.size());
+
+        auto find_edges = [&]() {
+            edges.clear();
+
+            for (auto i = 0u; i < result.size(); i += 3) {
+                for (auto e = 0u; e < 3; ++e) {
+                    auto const a = result[i + e];
+                    auto const b = result[i + (e + 1) % 3];
+
+                    auto& edge = edges[edge_key(position_group[a], position_group[b])];
+                    if (edge.count++ == 0)
+                        edge.vertices = edge_key(a, b);
+                    else if (edge.vertices != edge_key(a, b))
+                        edge.seam = true;
+                }
+            }
+        };
+
+        find_edges();
+
+        std::vector<quadric> quadrics(vertex_count);
+        for (auto i = 0u; i < result.size(); i += 3) {
+            auto const& p0 = vertices[result[i]].position;
+            auto const& p1 = vertices[result[i + 1]].position;
+            auto const& p2 = vertices[result[i + 2]].position;
+
+            auto normal = face_normal(p0, p1, p2);
+            auto const area = glm::length(normal);
+            if (area == 0.f)
+                continue;
+
+            normal /= area;
+            auto const d = -glm::dot(normal, p0);
+
+            for (auto c = 0u; c < 3; ++c)
+                quadrics[position_group[result[i + c]]].add_plane(normal, d, area);
+
+            // seams keep their course, plane through the edge upright on the face
+            for (auto e = 0u; e < 3; ++e) {
+                auto const a = position_group[result[i + e]];
+                auto const b = position_group[result[i + (e + 1) % 3]];
+
+                auto const it = edges.find(edge_key(a, b));
+                if ((it == edges.end()) || !it->second.seam)
+                    continue;
+
+                auto const& pa = vertices[a].position;
+                auto side = glm::cross(vertices[b].position - pa, normal);
+
+                auto const length = glm::length(side);
+                if (length == 0.f)
+                    continue;
+
+                side /= length;
+
+                quadrics[a].add_plane(side, -glm::dot(side, pa), area);
+                quadrics[b].add_plane(side, -glm::dot(side, pa), area);
+            }
+        }
+
+        auto const max_cost = r64(target_error) * r64(target_error);
+        auto reached_cost = 0.0;
+
+        index_list remap(vertex_count);
+        std::vector<bool> touched(vertex_count);
+        std::vector<collapse> collapses;
+
+        // per welded position
+        std::vector<bool> locked(vertex_count);
+        std::vector<bool> on_seam(vertex_count);
+        std::vector<ui32> wedge_count(vertex_count);
+        std::vector<ui32> seam_count(vertex_count);
+        std::vector<bool> used(vertex_count);
+
+        std::vector<ui32> adjacency_offsets(vertex_count + 1);
+        std::vector<ui32> adjacency;
+
+        index_list source_ring;
+        index_list target_ring;
+        index_list wedge_targets;
+
+        while (result.size() > target_index_count) {
+            auto const triangle_count = result.size() / 3;
+
+            find_edges();
+
+            std::fill(used.begin(), used.end(), false);
+            for (auto index : result)
+                used[index] = true;
+
+            std::fill(wedge_count.begin(), wedge_count.end(), 0);
+            for (auto i = 0u; i < vertex_count; ++i)
+                if (used[i])
+                    ++wedge_count[position_group[i]];
+
+            std::fill(locked.begin(), locked.end(), false);
+            std::fill(seam_count.begin(), seam_count.end(), 0);
+
+            for (auto const& [key, edge] : edges) {
+                auto const a = index(key >> 32);
+                auto const b = index(key & 0xffffffff);
+
+                // open or non-manifold edges stay
+                if (edge.count != 2) {
+                    locked[a] = true;
+                    locked[b] = true;
+                } else if (edge.seam) {
+                    ++seam_count[a];
+                    ++seam_count[b];
+                }
+            }
+
+            // one vertex -> free, two along one seam -> slides on it, anything else stays
+            for (auto i = 0u; i < vertex_count; ++i) {
+                on_seam[i] = !locked[i] && (wedge_count[i] == 2) && (seam_count[i] == 2);
+
+                if (((wedge_count[i] > 1) || (seam_count[i] > 0)) && !on_seam[i])
+                    locked[i] = true;
+            }
+
+            collapses.clear();
+            for (auto i = 0u; i < result.size(); i += 3) {
+                for (auto e = 0u; e < 3; ++e) {
+                    auto const a = position_group[result[i + e]];
+                    auto const b = position_group[result[i + (e + 1) % 3]];
+                    if (a == b)
+                        continue;
+
+                    auto const seam = edges[edge_key(a, b)].seam;
+
+                    for (auto [source, target] : { std::pair{ a, b }, std::pair{ b, a } }) {
+                        if (locked[source] || (on_seam[source] && !seam))
+                            continue;
+
+                        auto q = quadrics[source];
+                        q += quadrics[target];
+
+                        collapses.push_back({ source, target, q.error(vertices[target].position) });
+                    }
+                }
+            }
+
+            if (collapses.empty())
+                break;
+
+            std::sort(collapses.begin(), collapses.end(), [](collapse const& a, collapse const& b) { return a.cost < b.cost; });
+
+            // triangles per welded position
+            std::fill(adjacency_offsets.begin(), adjacency_offsets.end(), 0);
+            for (auto index : result)
+                ++adjacency_offsets[position_group[index] + 1];
+            for (auto i = 0u; i < vertex_count; ++i)
+                adjacency_offsets[i + 1] += adjacency_offsets[i];
+
+            adjacency.resize(result.size());
+            {
+                auto fill = adjacency_offsets;
+                for (auto i = 0u; i < result.size(); ++i)
+                    adjacency[fill[position_group[result[i]]]++] = i / 3;
+            }
+
+            auto ring = [&](index vertex, index exclude, index_list& list) {
+                list.clear();
+                for (auto a = adjacency_offsets[vertex]; a < adjacency_offsets[vertex + 1]; ++a) {
+                    auto const t = adjacency[a] * 3;
+                    for (auto c = 0u; c < 3; ++c) {
+                        auto const group = position_group[result[t + c]];
+                        if ((group != vertex) && (group != exclude))
+                            list.push_back(group);
+                    }
+                }
+
+                std::sort(list.begin(), list.end());
+                list.erase(std::unique(list.begin(), list.end()), list.end());
+            };
+
+            for (auto i = 0u; i < vertex_count; ++i)
+                remap[i] = i;
+
+            std::fill(touched.begin(), touched.end(), false);
+
+            auto remaining = triangle_count;
+            auto const target_triangles = target_index_count / 3;
+            auto collapsed = 0u;
+
+            for (auto const& item : collapses) {
+                if ((item.cost > max_cost) || (remaining <= target_triangles))
+                    break;
+
+                if (touched[item.source] || touched[item.target])
+                    continue;
+
+                auto const& from = vertices[item.source].position;
+                auto const& to = vertices[item.target].position;
+
+                // no flipped triangles around the source
+                auto flipped = false;
+                auto removed = 0u;
+
+                for (auto a = adjacency_offsets[item.source]; a < adjacency_offsets[item.source + 1] && !flipped; ++a) {
+                    auto const t = adjacency[a] * 3;
+
+                    index corner[] = { position_group[result[t]], position_group[result[t + 1]], position_group[result[t + 2]] };
+                    if (corner[0] == item.target || corner[1] == item.target || corner[2] == item.target) {
+                        ++removed;
+                        continue;
+                    }
+
+                    v3 p[3];
+                    for (auto c = 0u; c < 3; ++c)
+                        p[c] = corner[c] == item.source ? from : vertices[corner[c]].position;
+
+                    auto const before = face_normal(p[0], p[1], p[2]);
+
+                    for (auto c = 0u; c < 3; ++c)
+                        if (corner[c] == item.source)
+                            p[c] = to;
+
+                    auto const after = face_normal(p[0], p[1], p[2]);
+
+                    // folds over or turns into a sliver
+                    flipped = glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after);
+                }
+
+                if (flipped)
+                    continue;
+
+                // link condition: common neighbours only opposite the edge, else the surface pinches
+                ring(item.source, item.target, source_ring);
+                ring(item.target, item.source, target_ring);
+
+                auto common = 0u;
+                for (auto s = 0u, t = 0u; (s < source_ring.size()) && (t < target_ring.size());) {
+                    if (source_ring[s] < target_ring[t]) {
+                        ++s;
+                    } else if (target_ring[t] < source_ring[s]) {
+                        ++t;
+                    } else {
+                        ++common;
+                        ++s;
+                        ++t;
+                    }
+                }
+
+                if (common != removed)
+                    continue;
+
+                // every vertex of the source moves to the target vertex it shares an edge with
+                auto mapped = true;
+                wedge_targets.clear();
+
+                auto wedge = item.source;
+                do {
+                    auto target = no_index;
+                    auto referenced = false;
+
+                    for (auto a = adjacency_offsets[item.source]; a < adjacency_offsets[item.source + 1]; ++a) {
+                        auto const t = adjacency[a] * 3;
+                        if ((result[t] != wedge) && (result[t + 1] != wedge) && (result[t + 2] != wedge))
+                            continue;
+
+                        referenced = true;
+
+                        for (auto c = 0u; c < 3; ++c)
+                            if (position_group[result[t + c]] == item.target)
+                                target = result[t + c];
+
+                        if (target != no_index)
+                            break;
+                    }
+
+                    if (referenced && (target == no_index))
+                        mapped = false;
+
+                    wedge_targets.push_back(target);
+                    wedge = next_wedge[wedge];
+                } while (wedge != item.source && mapped);
+
+                if (!mapped)
+                    continue;
+
+                wedge = item.source;
+                for (auto target : wedge_targets) {
+                    if (target != no_index)
+                        remap[wedge] = target;
+
+                    wedge = next_wedge[wedge];
+                }
+
+                quadrics[item.target] += quadrics[item.source];
+
+                // neighborhood fixed for this pass
+                for (auto a = adjacency_offsets[item.source]; a < adjacency_offsets[item.source + 1]; ++a) {
+                    auto const t = adjacency[a] * 3;
+                    for (auto c = 0u; c < 3; ++c)
+                        touched[position_group[result[t + c]]] = true;
+                }
+
+                reached_cost = std::max(reached_cost, item.cost);
+                remaining -= std::min<size_t>(removed, remaining);
+                ++collapsed;
+            }
+
+            if (collapsed == 0)
+                break;
+
+            auto write = 0u;
+            for (auto i = 0u; i < result.size(); i += 3) {
+                auto const a = remap[result[i]];
+                auto const b = remap[result[i + 1]];
+                auto const c = remap[result[i + 2]];
+
+                auto const ga = position_group[a];
+                auto const gb = position_group[b];
+                auto const gc = position_group[c];
+
+                if ((ga == gb) || (gb == gc) || (ga == gc))
+                    continue;
+
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+
+            result.resize(write);
+        }
+
+        if (result_error)
+            *result_error = to_r32(std::sqrt(reached_cost));
+
+        return result;
+    }
+
+    bool mesh_lod::generate(mesh_data const& data, std::vector<r32> const& ratios, r32 max_error) {
+        levels.clear();
+        indices.clear();
+
+        if (data.indices.empty() || data.vertices.empty())
+            return false;
+
+        auto bounds_min = data.vertices.front().position;
+        auto bounds_max = bounds_min;
+
+        for (auto const& vertex : data.vertices) {
+            bounds_min = glm::min(bounds_min, vertex.position);
+            bounds_max = glm::max(bounds_max, vertex.position);
+        }
+
+        center = (bounds_min + bounds_max) * 0.5f;
+        radius = glm::length(bounds_max - bounds_min) * 0.5f;
+
+        levels.push_back({ 0, to_ui32(data.indices.size()), 0.f });
+        indices = data.indices;
+
+        auto const target_error = max_error * radius;
+
+        // finest first, every level from the source so its error is against the original
+        auto sorted_ratios = ratios;
+        std::sort(sorted_ratios.begin(), sorted_ratios.end(), std::greater<r32>());
+
+        for (auto ratio : sorted_ratios) {
+            auto const target_index_count = to_size_t(to_r32(data.indices.size() / 3) * ratio) * 3;
+
+            r32 error = 0.f;
+            auto level_indices = simplify_mesh(data.indices, data.vertices, target_index_count, target_error, &error);
+
+            // no progress -> error bound reached
+            if (level_indices.size() >= levels.back().index_count)
+                break;
+
+            optimize_vertex_cache(level_indices, data.vertices.size());
+
+            levels.push_back({ to_ui32(indices.size()), to_ui32(level_indices.size()), std::max(error, levels.back().error) });
+            indices.insert(indices.end(), level_indices.begin(), level_indices.end());
+        }
+
+        return true;
+    }
+
+    bool mesh_lod::create(device_ptr d) {
+        device = d;
+
+        if (indices.empty())
+            return false;
+
+        index_buffer = make_buffer();
+
+        if (!index_buffer->create(device, indices.data(), sizeof(ui32) * indices.size(),
+                                  VK_BUFFER_USAGE_INDEX_BUFFER_BIT, false, VMA_MEMORY_USAGE_CPU_TO_GPU)) {
+            log()->error("create mesh lod index buffer");
+            return false;
+        }
+
+        return true;
+    }
+
+    void mesh_lod::destroy() {
+        index_buffer = nullptr;
+        device = nullptr;
+    }
+
+    void mesh_lod::bind(VkCommandBuffer cmd_buf) const {
+        if (index_buffer && index_buffer->valid())
+            vkCmdBindIndexBuffer(cmd_buf, index_buffer->get(), 0, VK_INDEX_TYPE_UINT32);
+    }
+
+    void mesh_lod::draw(VkCommandBuffer cmd_buf, index level) const {
+        if (levels.empty())
+            return;
+
+        auto const& selected = levels.at(std::min(level, to_index(levels.size() - 1)));
+        vkCmdDrawIndexed(cmd_buf, selected.index_count, 1, selected.first_index, 0, 0);
+    }
+
+    index mesh_lod::select(r32 pixels_per_unit, r32 pixel_error) const {
+        index result = 0;
+
+        for (auto i = 1u; i < levels.size(); ++i)
+            if (levels[i].error * pixels_per_unit <= pixel_error)
+                result = i;
+
+        return result;
+    }
+
+} // namespace lava
@@ -0,0 +1,94 @@
+// file      : liblava/resource/mesh_lod.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/resource/mesh.hpp>
+
+namespace lava {
+
+    // quadric error edge collapse onto existing vertices, welded by position
+    // borders stay, attribute seams only collapse along themselves
+    // target_error in object space, result_error -> reached error
+    index_list simplify_mesh(index_list const& indices, vertex::list const& vertices, size_t target_index_count,
+                             r32 target_error, r32* result_error = nullptr);
+
+    constexpr r32 const default_lod_max_error = 0.05f; // relative to radius
+
+    // levels in one index buffer, drawn with the vertex buffer of the source mesh
+    struct mesh_lod : id_obj {
+        using ptr = std::shared_ptr<mesh_lod>;
+        using list = std::vector<ptr>;
+
+        struct level {
+            using list = std::vector<level>;
+
+            ui32 first_index = 0;
+            ui32 index_count = 0;
+            r32 error = 0.f; // object space
+        };
+
+        ~mesh_lod() {
+            destroy();
+        }
+
+        // level 0 -> source indices, one level per ratio until max_error is reached
+        // every level simplified from the source, error against it
+        bool generate(mesh_data const& data, std::vector<r32> const& ratios = { 0.5f, 0.25f, 0.125f, 0.0625f },
+                      r32 max_error = default_lod_max_error);
+
+        bool create(device_ptr device);
+        void destroy();
+
+        // after mesh::bind
+        void bind(VkCommandBuffer cmd_buf) const;
+        void draw(VkCommandBuffer cmd_buf, index level) const;
+
+        void bind_draw(VkCommandBuffer cmd_buf, index level) const {
+            bind(cmd_buf);
+            draw(cmd_buf, level);
+        }
+
+        // coarsest level with projected error below pixel_error
+        index select(r32 pixels_per_unit, r32 pixel_error = 1.f) const;
+
+        level::list const& get_levels() const {
+            return levels;
+        }
+        ui32 get_level_count() const {
+            return to_ui32(levels.size());
+        }
+
+        index_list const& get_indices() const {
+            return indices;
+        }
+
+        v3 get_center() const {
+            return center;
+        }
+        r32 get_radius() const {
+            return radius;
+        }
+
+        buffer::ptr get_index_buffer() {
+            return index_buffer;
+        }
+
+    private:
+        device_ptr device = nullptr;
+
+        level::list levels;
+        index_list indices;
+
+        v3 center = v3(0.f);
+        r32 radius = 0.f;
+
+        buffer::ptr index_buffer;
+    };
+
+    inline mesh_lod::ptr make_mesh_lod() {
+        return std::make_shared<mesh_lod>();
+    }
+
+} // namespace lava
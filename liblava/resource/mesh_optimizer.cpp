@@ -0,0 +1,342 @@
+// file      : liblava/resource/mesh_optimizer.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#include <algorithm>
+#include <cmath>
+#include <liblava/resource/mesh_optimizer.hpp>
+
+namespace lava {
+
+    namespace {
+
+        bool valid_indices(index_list const& indices, size_t vertex_count) {
+            if (indices.size() % 3 != 0)
+                return false;
+
+            for (auto index : indices)
+                if (index >= vertex_count)
+                    return false;
+
+            return true;
+        }
+
+        struct fifo_cache {
+            explicit fifo_cache(size_t vertex_count, ui32 cache_size)
+            : stamps(vertex_count, 0), cache_size(cache_size) {}
+
+            // true -> miss
+            bool access(index vertex) {
+                if ((time - stamps[vertex]) < cache_size && stamps[vertex] != 0)
+                    return false;
+
+                stamps[vertex] = ++time;
+                return true;
+            }
+
+            void reset() {
+                time += cache_size + 1;
+            }
+
+        private:
+            std::vector<ui32> stamps;
+            ui32 cache_size = 0;
+            ui32 time = 0;
+        };
+
+        // Forsyth, linear-speed vertex cache optimisation
+        constexpr ui32 const forsyth_cache_size = 32;
+        constexpr r32 const forsyth_cache_decay_power = 1.5f;
+        constexpr r32 const forsyth_last_triangle_score = 0.75f;
+        constexpr r32 const forsyth_valence_boost_scale = 2.f;
+        constexpr r32 const forsyth_valence_boost_power = 0.5f;
+
+        r32 forsyth_score(i32 cache_position, ui32 remaining) {
+            if (remaining == 0)
+                return -1.f;
+
+            auto score = 0.f;
+
+            if (cache_position >= 0) {
+                if (cache_position < 3)
+                    score = forsyth_last_triangle_score;
+                else {
+                    auto const scaler = 1.f / (forsyth_cache_size - 3);
+                    score = std::pow(1.f - (cache_position - 3) * scaler, forsyth_cache_decay_power);
+                }
+            }
+
+            return score + forsyth_valence_boost_scale * std::pow(to_r32(remaining), -forsyth_valence_boost_power);
+        }
+
+    } // namespace
+
+    vertex_cache_stats analyze_vertex_cache(index_list const& indices, size_t vertex_count, ui32 cache_size) {
+        vertex_cache_stats result;
+        if (indices.empty() || (vertex_count == 0) || !valid_indices(indices, vertex_count))
+            return result;
+
+        fifo_cache cache(vertex_count, cache_size);
+
+        auto misses = 0u;
+        for (auto index : indices)
+            if (cache.access(index))
+                ++misses;
+
+        result.acmr = to_r32(misses) / to_r32(indices.size() / 3);
+        result.atvr = to_r32(misses) / to_r32(vertex_count);
+        return result;
+    }
+
+    bool optimize_vertex_cache(index_list& indices, size_t vertex_count) {
+        if (!valid_indices(indices, vertex_count))
+            return false;
+
+        auto const triangle_count = indices.size() / 3;
+        if (triangle_count < 2)
+            return true;
+
+        // triangles per vertex
+        std::vector<ui32> remaining(vertex_count, 0);
+        for (auto index : indices)
+            ++remaining[index];
+
+        std::vector<ui32> adjacency_offsets(vertex_count + 1, 0);
+        for (auto i = 0u; i < vertex_count; ++i)
+            adjacency_offsets[i + 1] = adjacency_offsets[i] + remaining[i];
+
+        std::vector<ui32> adjacency(indices.size());
+        {
+            auto fill = adjacency_offsets;
+            for (auto i = 0u; i < indices.size(); ++i)
+                adjacency[fill[indices[i]]++] = i / 3;
+        }
+
+        std::vector<r32> vertex_scores(vertex_count);
+        for (auto i = 0u; i < vertex_count; ++i)
+            vertex_scores[i] = forsyth_score(-1, remaining[i]);
+
+        std::vector<bool> emitted(triangle_count, false);
+
+        index_list result;
+        result.reserve(indices.size());
+
+        index_list cache;
+        cache.reserve(forsyth_cache_size + 3);
+
+        index_list next_cache;
+        next_cache.reserve(forsyth_cache_size + 3);
+
+        auto cursor = 0u;
+        auto best = no_index;
+
+        for (auto emitted_count = 0u; emitted_count < triangle_count; ++emitted_count) {
+            if (best == no_index) {
+                // cache ran dry, continue with the next open triangle
+                while (emitted[cursor])
+                    ++cursor;
+
+                best = cursor;
+            }
+
+            emitted[best] = true;
+
+            index const triangle[] = { indices[best * 3], indices[best * 3 + 1], indices[best * 3 + 2] };
+
+            next_cache.clear();
+            for (auto vertex : triangle) {
+                result.push_back(vertex);
+                --remaining[vertex];
+                next_cache.push_back(vertex);
+            }
+
+            for (auto vertex : cache)
+                if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+                    next_cache.push_back(vertex);
+
+            for (auto i = forsyth_cache_size; i < next_cache.size(); ++i) {
+                auto vertex = next_cache[i];
+                vertex_scores[vertex] = forsyth_score(-1, remaining[vertex]);
+            }
+
+            if (next_cache.size() > forsyth_cache_size)
+                next_cache.resize(forsyth_cache_size);
+
+            cache.swap(next_cache);
+
+            for (auto i = 0u; i < cache.size(); ++i) {
+                auto vertex = cache[i];
+                vertex_scores[vertex] = forsyth_score(to_i32(i), remaining[vertex]);
+            }
+
+            // only triangles touching the cache can win
+            best = no_index;
+            auto best_score = -1.f;
+
+            for (auto vertex : cache) {
+                for (auto a = adjacency_offsets[vertex]; a < adjacency_offsets[vertex + 1]; ++a) {
+                    auto t = adjacency[a];
+                    if (emitted[t])
+                        continue;
+
+                    auto score = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+
+                    if (score > best_score) {
+                        best_score = score;
+                        best = t;
+                    }
+                }
+            }
+        }
+
+        indices = std::move(result);
+        return true;
+    }
+
+    bool optimize_overdraw(index_list& indices, vertex::list const& vertices, r32 threshold) {
+        auto const vertex_count = vertices.size();
+        if (!valid_indices(indices, vertex_count))
+            return false;
+
+        auto const triangle_count = indices.size() / 3;
+        if (triangle_count < 2)
+            return true;
+
+        auto const mesh_acmr = analyze_vertex_cache(indices, vertex_count).acmr;
+
+        // hard boundaries at full cache misses, soft ones while the cluster keeps the acmr
+        index_list cluster_starts;
+        {
+            fifo_cache cache(vertex_count, default_vertex_cache_size);
+
+            auto cluster_start = 0u;
+            auto cluster_misses = 0u;
+
+            for (auto t = 0u; t < triangle_count; ++t) {
+                auto misses = 0u;
+                for (auto c = 0u; c < 3; ++c)
+                    misses += cache.access(indices[t * 3 + c]) ? 1 : 0;
+
+                if ((t == 0) || (misses == 3)) {
+                    cluster_starts.push_back(t);
+                    cluster_start = t;
+                    cluster_misses = misses;
+                    continue;
+                }
+
+                cluster_misses += misses;
+
+                auto const cluster_acmr = to_r32(cluster_misses) / to_r32(t - cluster_start + 1);
+                if ((cluster_acmr <= threshold * mesh_acmr) && (t + 1 < triangle_count)) {
+                    cluster_starts.push_back(t + 1);
+                    cluster_start = t + 1;
+                    cluster_misses = 0;
+                    cache.reset();
+                }
+            }
+        }
+
+        auto const cluster_count = cluster_starts.size();
+        if (cluster_count < 2)
+            return true;
+
+        cluster_starts.push_back(to_ui32(triangle_count));
+
+        v3 mesh_center(0.f);
+        for (auto const& vertex : vertices)
+            mesh_center += vertex.position;
+        mesh_center /= to_r32(vertex_count);
+
+        std::vector<r32> sort_keys(cluster_count);
+
+        for (auto c = 0u; c < cluster_count; ++c) {
+            v3 center(0.f);
+            v3 normal(0.f);
+            auto area = 0.f;
+
+            for (auto t = cluster_starts[c]; t < cluster_starts[c + 1]; ++t) {
+                auto const& p0 = vertices[indices[t * 3]].position;
+                auto const& p1 = vertices[indices[t * 3 + 1]].position;
+                auto const& p2 = vertices[indices[t * 3 + 2]].position;
+
+                auto const face = glm::cross(p1 - p0, p2 - p0);
+                auto const face_area = glm::length(face);
+
+                center += (p0 + p1 + p2) * (face_area / 3.f);
+                normal += face;
+                area += face_area;
+            }
+
+            if (area > 0.f)
+                center /= area;
+
+            auto const normal_length = glm::length(normal);
+            if (normal_length > 0.f)
+                normal /= normal_length;
+
+            // facing away from the center -> likely in front, draw first
+            sort_keys[c] = glm::dot(center - mesh_center, normal);
+        }
+
+        index_list order(cluster_count);
+        for (auto c = 0u; c < cluster_count; ++c)
+            order[c] = c;
+
+        std::stable_sort(order.begin(), order.end(), [&](index a, index b) { return sort_keys[a] > sort_keys[b]; });
+
+        index_list result;
+        result.reserve(indices.size());
+
+        for (auto c : order)
+            result.insert(result.end(), indices.begin() + cluster_starts[c] * 3, indices.begin() + cluster_starts[c + 1] * 3);
+
+        indices = std::move(result);
+        return true;
+    }
+
+    size_t optimize_vertex_fetch(mesh_data& data) {
+        auto const vertex_count = data.vertices.size();
+        if (!valid_indices(data.indices, vertex_count))
+            return vertex_count;
+
+        index_list remap(vertex_count, no_index);
+
+        vertex::list vertices;
+        vertices.reserve(vertex_count);
+
+        for (auto& index : data.indices) {
+            if (remap[index] == no_index) {
+                remap[index] = to_ui32(vertices.size());
+                vertices.push_back(data.vertices[index]);
+            }
+
+            index = remap[index];
+        }
+
+        data.vertices = std::move(vertices);
+        return data.vertices.size();
+    }
+
+    bool optimize_mesh(mesh_data& data, bool overdraw) {
+        if (data.indices.empty())
+            return false;
+
+        auto const before = analyze_vertex_cache(data.indices, data.vertices.size());
+
+        if (!optimize_vertex_cache(data.indices, data.vertices.size()))
+            return false;
+
+        if (overdraw && !optimize_overdraw(data.indices, data.vertices))
+            return false;
+
+        optimize_vertex_fetch(data);
+
+        auto const after = analyze_vertex_cache(data.indices, data.vertices.size());
+
+        log()->debug("optimize mesh - acmr {:.3f} -> {:.3f} / atvr {:.3f} -> {:.3f}",
+                     before.acmr, after.acmr, before.atvr, after.atvr);
+
+        return true;
+    }
+
+} // namespace lava
@@ -0,0 +1,35 @@
+// file      : liblava/resource/mesh_optimizer.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/resource/mesh.hpp>
+
+namespace lava {
+
+    constexpr ui32 const default_vertex_cache_size = 16;
+
+    struct vertex_cache_stats {
+        r32 acmr = 0.f; // misses per triangle, 3 worst - 0.5 best
+        r32 atvr = 0.f; // misses per vertex, 1 best
+    };
+
+    // fifo cache like most hardware
+    vertex_cache_stats analyze_vertex_cache(index_list const& indices, size_t vertex_count,
+                                            ui32 cache_size = default_vertex_cache_size);
+
+    // triangle order for post-transform cache hits (Forsyth)
+    bool optimize_vertex_cache(index_list& indices, size_t vertex_count);
+
+    // clusters split at cache restarts and sorted outside in, after optimize_vertex_cache
+    // threshold -> allowed acmr loss against the cache optimized order
+    bool optimize_overdraw(index_list& indices, vertex::list const& vertices, r32 threshold = 1.05f);
+
+    // vertices in order of first use, unreferenced removed
+    size_t optimize_vertex_fetch(mesh_data& data);
+
+    // all passes, logs acmr / atvr before and after
+    bool optimize_mesh(mesh_data& data, bool overdraw = false);
+
+} // namespace lava
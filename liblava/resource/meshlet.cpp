@@ -0,0 +1,176 @@
+// file      : liblava/resource/meshlet.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#include <algorithm>
+#include <liblava/resource/meshlet.hpp>
+
+namespace lava {
+
+    meshlet_data build_meshlets(mesh_data const& data, ui32 max_vertices, ui32 max_triangles) {
+        meshlet_data result;
+
+        auto const vertex_count = data.vertices.size();
+        if (data.indices.empty() || (data.indices.size() % 3 != 0))
+            return result;
+
+        max_vertices = std::clamp(max_vertices, 3u, 256u);
+        max_triangles = std::max(max_triangles, 1u);
+
+        // mesh vertex -> local index of the current meshlet
+        std::vector<ui8> local(vertex_count, 0xff);
+        std::vector<bool> used(vertex_count, false);
+
+        meshlet current;
+
+        auto flush = [&]() {
+            if (current.triangle_count == 0)
+                return;
+
+            for (auto i = 0u; i < current.vertex_count; ++i)
+                used[result.vertices[current.vertex_offset + i]] = false;
+
+            result.meshlets.push_back(current);
+
+            // keep triangle blocks 4 byte aligned
+            result.triangles.resize(align_up<size_t>(result.triangles.size(), 4), 0);
+
+            current = {};
+            current.vertex_offset = to_ui32(result.vertices.size());
+            current.triangle_offset = to_ui32(result.triangles.size());
+        };
+
+        for (auto i = 0u; i < data.indices.size(); i += 3) {
+            index const corners[] = { data.indices[i], data.indices[i + 1], data.indices[i + 2] };
+
+            if ((corners[0] >= vertex_count) || (corners[1] >= vertex_count) || (corners[2] >= vertex_count))
+                return {};
+
+            auto new_vertices = 0u;
+            for (auto c = 0u; c < 3; ++c)
+                if (!used[corners[c]] && (c == 0 || corners[c] != corners[0]) && (c < 2 || corners[c] != corners[1]))
+                    ++new_vertices;
+
+            if ((current.vertex_count + new_vertices > max_vertices) || (current.triangle_count + 1 > max_triangles))
+                flush();
+
+            for (auto vertex : corners) {
+                if (!used[vertex]) {
+                    used[vertex] = true;
+                    local[vertex] = static_cast<ui8>(current.vertex_count++);
+                    result.vertices.push_back(vertex);
+                }
+
+                result.triangles.push_back(local[vertex]);
+            }
+
+            ++current.triangle_count;
+        }
+
+        flush();
+
+        result.bounds.reserve(result.meshlets.size());
+        for (auto const& meshlet : result.meshlets)
+            result.bounds.push_back(compute_meshlet_bounds(result, meshlet, data.vertices));
+
+        return result;
+    }
+
+    meshlet_bounds compute_meshlet_bounds(meshlet_data const& data, meshlet const& meshlet, vertex::list const& vertices) {
+        meshlet_bounds result;
+        if (meshlet.vertex_count == 0)
+            return result;
+
+        auto const position = [&](ui32 local) {
+            return vertices[data.vertices[meshlet.vertex_offset + local]].position;
+        };
+
+        auto bounds_min = position(0);
+        auto bounds_max = bounds_min;
+
+        for (auto i = 1u; i < meshlet.vertex_count; ++i) {
+            bounds_min = glm::min(bounds_min, position(i));
+            bounds_max = glm::max(bounds_max, position(i));
+        }
+
+        auto const center = (bounds_min + bounds_max) * 0.5f;
+
+        auto radius = 0.f;
+        for (auto i = 0u; i < meshlet.vertex_count; ++i)
+            radius = std::max(radius, glm::length(position(i) - center));
+
+        result.sphere = v4(center, radius);
+
+        // normal cone of the triangles
+        std::vector<v3> normals;
+        std::vector<v3> first_corners;
+        normals.reserve(meshlet.triangle_count);
+        first_corners.reserve(meshlet.triangle_count);
+
+        auto axis = v3(0.f);
+
+        for (auto t = 0u; t < meshlet.triangle_count; ++t) {
+            auto const triangle = &data.triangles[meshlet.triangle_offset + t * 3];
+
+            auto const p0 = position(triangle[0]);
+            auto const normal = glm::cross(position(triangle[1]) - p0, position(triangle[2]) - p0);
+
+            auto const area = glm::length(normal);
+            if (area == 0.f)
+                continue;
+
+            normals.push_back(normal / area);
+            first_corners.push_back(p0);
+            axis += normal;
+        }
+
+        auto const axis_length = glm::length(axis);
+        if (normals.empty() || (axis_length == 0.f))
+            return result;
+
+        axis /= axis_length;
+
+        auto min_dot = 1.f;
+        for (auto const& normal : normals)
+            min_dot = std::min(min_dot, glm::dot(axis, normal));
+
+        // wider than a half sphere
+        if (min_dot <= 0.f)
+            return result;
+
+        // apex behind every triangle plane
+        auto max_t = 0.f;
+        for (auto i = 0u; i < normals.size(); ++i) {
+            auto const t = glm::dot(normals[i], center - first_corners[i]) / glm::dot(axis, normals[i]);
+            max_t = std::max(max_t, t);
+        }
+
+        result.cone = v4(axis, std::sqrt(1.f - min_dot * min_dot));
+        result.cone_apex = v4(center - axis * max_t, 0.f);
+
+        return result;
+    }
+
+    bool cull_meshlet(meshlet_bounds const& bounds, frustum const& frustum, v3 camera_position) {
+        if (!frustum.intersects(v3(bounds.sphere), bounds.sphere.w))
+            return true;
+
+        auto const to_apex = v3(bounds.cone_apex) - camera_position;
+        auto const distance = glm::length(to_apex);
+        if (distance == 0.f)
+            return false;
+
+        return glm::dot(to_apex / distance, v3(bounds.cone)) >= bounds.cone.w && bounds.cone.w < 1.f;
+    }
+
+    ui32 cull_meshlets(meshlet_data const& data, frustum const& frustum, v3 camera_position, index_list& visible) {
+        visible.clear();
+
+        for (auto i = 0u; i < data.bounds.size(); ++i)
+            if (!cull_meshlet(data.bounds[i], frustum, camera_position))
+                visible.push_back(i);
+
+        return to_ui32(visible.size());
+    }
+
+} // namespace lava
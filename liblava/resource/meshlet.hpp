@@ -0,0 +1,59 @@
+// file      : liblava/resource/meshlet.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/resource/mesh.hpp>
+
+namespace lava {
+
+    constexpr ui32 const default_meshlet_vertices = 64;
+    constexpr ui32 const default_meshlet_triangles = 124;
+
+    // std430 layouts, uploadable as they are
+    struct meshlet {
+        using list = std::vector<meshlet>;
+
+        ui32 vertex_offset = 0;   // into meshlet_data::vertices
+        ui32 triangle_offset = 0; // into meshlet_data::triangles, 3 local indices each
+        ui32 vertex_count = 0;
+        ui32 triangle_count = 0;
+    };
+
+    struct meshlet_bounds {
+        using list = std::vector<meshlet_bounds>;
+
+        v4 sphere = v4(0.f); // center, radius
+
+        // backfacing from camera: dot(normalize(apex - camera), axis) >= cutoff
+        v4 cone = v4(0.f, 0.f, 1.f, 1.f); // axis, cutoff - 1 never culls
+        v4 cone_apex = v4(0.f);
+    };
+
+    struct meshlet_data {
+        meshlet::list meshlets;
+        meshlet_bounds::list bounds;
+
+        index_list vertices;        // mesh vertex per meshlet vertex
+        std::vector<ui8> triangles; // padded to 4 bytes
+
+        bool empty() const {
+            return meshlets.empty();
+        }
+    };
+
+    // greedy in index order, best after optimize_vertex_cache
+    // max_vertices up to 256
+    meshlet_data build_meshlets(mesh_data const& data, ui32 max_vertices = default_meshlet_vertices,
+                                ui32 max_triangles = default_meshlet_triangles);
+
+    meshlet_bounds compute_meshlet_bounds(meshlet_data const& meshlets, meshlet const& meshlet, vertex::list const& vertices);
+
+    // true -> outside or backfacing
+    bool cull_meshlet(meshlet_bounds const& bounds, frustum const& frustum, v3 camera_position);
+
+    // frustum and camera in mesh space, returns visible meshlets
+    ui32 cull_meshlets(meshlet_data const& data, frustum const& frustum, v3 camera_position, index_list& visible);
+
+} // namespace lava
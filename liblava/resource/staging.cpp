@@ -0,0 +1,689 @@
+// file      : liblava/resource/staging.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#include <liblava/resource/format.hpp>
+#include <liblava/resource/staging.hpp>
+
+namespace lava {
+
+    constexpr VkAccessFlags const staging_read_access = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT
+                                                        | VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT
+                                                        | VK_ACCESS_SHADER_READ_BIT;
+
+    constexpr VkPipelineStageFlags const staging_read_stages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
+                                                               | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+                                                               | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+    bool staging::create(device_ptr d, VkDeviceSize size, bool a) {
+        device = d;
+
+        ring = make_buffer();
+        if (!ring->create_mapped(device, nullptr, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT)) {
+            log()->error("create staging ring buffer");
+            ring = nullptr;
+            return false;
+        }
+
+        head = 0;
+        tail = 0;
+
+        async = a;
+        if (!async)
+            return true;
+
+        transfer_queue = device->get_async_transfer_queue();
+        graphics_family = device->get_graphics_queue().family;
+
+        if (device->timeline_semaphore_enabled()) {
+            VkSemaphoreTypeCreateInfoKHR const type_info{
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR,
+                .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR,
+                .initialValue = 0,
+            };
+
+            VkSemaphoreCreateInfo const create_info{
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+                .pNext = &type_info,
+            };
+
+            if (!device->vkCreateSemaphore(&create_info, &timeline)) {
+                log()->error("create staging timeline semaphore");
+                return false;
+            }
+
+            timeline_value = 0;
+        }
+
+        log()->debug("staging transfer queue family {} (graphics {}) - {} semaphore", transfer_queue.family,
+                     graphics_family, timeline ? "timeline" : "binary");
+
+        return true;
+    }
+
+    void staging::destroy() {
+        for (auto& frame : async_frames) {
+            if (frame.pending)
+                device->vkWaitForFences(1, &frame.fence, VK_TRUE, UINT64_MAX);
+
+            if (frame.cmd_pool)
+                device->call().vkDestroyCommandPool(device->get(), frame.cmd_pool, memory::alloc());
+
+            if (frame.fence)
+                device->vkDestroyFence(frame.fence);
+
+            if (frame.semaphore)
+                device->vkDestroySemaphore(frame.semaphore);
+        }
+
+        async_frames.clear();
+
+        if (timeline) {
+            device->vkDestroySemaphore(timeline);
+            timeline = 0;
+        }
+
+        async = false;
+
+        uploads.clear();
+
+        frame_buffers.clear();
+        frame_heads.clear();
+        reclaimed_frame = no_index;
+
+        ring = nullptr;
+        device = nullptr;
+
+        head = 0;
+        tail = 0;
+    }
+
+    void staging::add(texture::ptr texture) {
+        upload item;
+        item.dst_texture = texture;
+        item.old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        item.initial = true;
+        item.size = texture->get_upload_buffer() ? texture->get_upload_buffer()->get_size() : 0;
+        item.alignment = std::max(1u, format_block_size(texture->get_format())) * 4;
+
+        // data stays in the texture until staged
+        uploads.push_back(std::move(item));
+    }
+
+    bool staging::add(texture::ptr texture, void const* data, size_t size, VkBufferImageCopy region, VkImageLayout old_layout) {
+        upload item;
+        item.dst_texture = texture;
+        item.regions.push_back(region);
+        item.old_layout = old_layout;
+        item.size = size;
+        item.alignment = std::max(1u, format_block_size(texture->get_format())) * 4;
+
+        if (!write(item, data))
+            item.pending.assign(as_ptr(data), as_ptr(data) + size);
+
+        uploads.push_back(std::move(item));
+        return true;
+    }
+
+    bool staging::add(buffer::ptr buffer, void const* data, size_t size, VkDeviceSize offset) {
+        if (!buffer || !buffer->valid() || (offset + size > buffer->get_size())) {
+            log()->error("add staging buffer");
+            return false;
+        }
+
+        upload item;
+        item.dst_buffer = buffer;
+        item.dst_offset = offset;
+        item.initial = (offset == 0) && (size == buffer->get_size());
+        item.size = size;
+
+        if (!write(item, data))
+            item.pending.assign(as_ptr(data), as_ptr(data) + size);
+
+        uploads.push_back(std::move(item));
+        return true;
+    }
+
+    bool staging::add(mesh::ptr mesh) {
+        if (auto vertex_buffer = mesh->get_vertex_buffer())
+            if (!add(vertex_buffer, mesh->get_vertex_data(), mesh->get_vertex_data_size()))
+                return false;
+
+        if (auto index_buffer = mesh->get_index_buffer())
+            if (!add(index_buffer, mesh->get_indices().data(), sizeof(ui32) * mesh->get_indices_count()))
+                return false;
+
+        return true;
+    }
+
+    bool staging::allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) {
+        if (!ring)
+            return false;
+
+        auto ring_size = ring->get_size();
+        if (size > ring_size)
+            return false;
+
+        auto position = head;
+
+        auto ring_offset = position % ring_size;
+        position += align_up(ring_offset, alignment) - ring_offset;
+
+        ring_offset = position % ring_size;
+        if (ring_offset + size > ring_size)
+            position += ring_size - ring_offset; // wrap
+
+        if (position + size - tail > ring_size)
+            return false;
+
+        head = position + size;
+        offset = position % ring_size;
+        return true;
+    }
+
+    bool staging::write(upload& item, void const* data) {
+        VkDeviceSize offset = 0;
+        if (!allocate(item.size, item.alignment, offset))
+            return false;
+
+        memcpy(as_ptr(ring->get_mapped_data()) + offset, data, item.size);
+
+        item.src = ring->get();
+        item.src_offset = offset;
+        return true;
+    }
+
+    bool staging::write_dedicated(upload& item, void const* data, index frame) {
+        auto dedicated = make_buffer();
+        if (!dedicated->create(device, data, item.size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, false, VMA_MEMORY_USAGE_CPU_TO_GPU))
+            return false;
+
+        item.src = dedicated->get();
+        item.src_offset = 0;
+
+        frame_buffers.at(frame).push_back(dedicated);
+        return true;
+    }
+
+    staging::prepare_result staging::prepare(upload& item, index frame) {
+        // levels below 0 would be sampled undefined
+        if (item.dst_texture && !mip_supported(*item.dst_texture)) {
+            log()->error("stage texture - no mip generation for format {}", to_ui32(item.dst_texture->get_format()));
+            return prepare_result::failed;
+        }
+
+        if (!item.src) {
+            // written into its own mapped buffer -> copy from there
+            if (item.dst_texture && item.regions.empty()) {
+                auto upload_buffer = item.dst_texture->get_upload_buffer();
+                if (!upload_buffer) {
+                    log()->error("stage texture");
+                    return prepare_result::failed;
+                }
+
+                upload_buffer->flush();
+
+                item.src = upload_buffer->get();
+                item.src_offset = 0;
+                item.regions = item.dst_texture->get_copy_regions();
+
+                frame_buffers.at(frame).push_back(upload_buffer);
+                item.dst_texture->destroy_upload_buffer();
+
+                return prepare_result::ready;
+            }
+
+            if (!write(item, item.pending.data())) {
+                if (item.size <= ring->get_size())
+                    return prepare_result::waiting;
+
+                if (!write_dedicated(item, item.pending.data(), frame)) {
+                    log()->error("create staging buffer");
+                    return prepare_result::failed;
+                }
+            }
+
+            item.pending.clear();
+        }
+
+        if (item.dst_texture && (item.src_offset != 0)) {
+            for (auto& region : item.regions)
+                region.bufferOffset += item.src_offset;
+
+            item.src_offset = 0;
+        }
+
+        return prepare_result::ready;
+    }
+
+    bool staging::mip_supported(texture& target) const {
+        if (!target.mip_levels_generation() || target.mip_blit_supported())
+            return true;
+
+        return mip_fallback && (!mip_fallback_check || mip_fallback_check(target));
+    }
+
+    void staging::reclaim(index frame) {
+        if (frame == reclaimed_frame)
+            return;
+
+        reclaimed_frame = frame;
+
+        if (frame >= frame_heads.size()) {
+            frame_heads.resize(frame + 1, 0);
+            frame_buffers.resize(frame + 1);
+            async_frames.resize(frame + 1);
+        }
+
+        auto& async_frame = async_frames.at(frame);
+        if (async_frame.pending) {
+            device->vkWaitForFences(1, &async_frame.fence, VK_TRUE, UINT64_MAX);
+            device->vkResetFences(1, &async_frame.fence);
+            async_frame.pending = false;
+        }
+
+        // space of the last submit with this frame is free again
+        tail = std::max(tail, frame_heads.at(frame));
+        frame_buffers.at(frame).clear();
+    }
+
+    bool staging::create_async_frame(async_frame& frame) {
+        if (frame.cmd_pool)
+            return true;
+
+        VkCommandPoolCreateInfo const pool_info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags = 0,
+            .queueFamilyIndex = transfer_queue.family,
+        };
+        if (failed(device->call().vkCreateCommandPool(device->get(), &pool_info, memory::alloc(), &frame.cmd_pool))) {
+            log()->error("create staging command pool");
+            return false;
+        }
+
+        VkCommandBufferAllocateInfo const allocate_info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = frame.cmd_pool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1,
+        };
+        if (failed(device->call().vkAllocateCommandBuffers(device->get(), &allocate_info, &frame.cmd_buf))) {
+            log()->error("create staging command buffer");
+            return false;
+        }
+
+        VkFenceCreateInfo const fence_info{
+            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+        };
+        if (!device->vkCreateFence(&fence_info, &frame.fence))
+            return false;
+
+        if (!timeline) {
+            VkSemaphoreCreateInfo const semaphore_info{
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            };
+            if (!device->vkCreateSemaphore(&semaphore_info, &frame.semaphore))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool staging::submit(index frame) {
+        if (!async || !ring || uploads.empty())
+            return false;
+
+        reclaim(frame);
+
+        auto& async_frame = async_frames.at(frame);
+
+        // without stage() in between / binary semaphore still signaled
+        if (async_frame.pending || (!timeline && async_frame.wait))
+            return false;
+
+        upload::list ready;
+        upload::list remaining;
+
+        for (auto& item : uploads) {
+            // mip chains need the graphics queue
+            if (!item.initial || (item.dst_texture && item.dst_texture->mip_levels_generation())) {
+                remaining.push_back(std::move(item));
+                continue;
+            }
+
+            switch (prepare(item, frame)) {
+            case prepare_result::ready:
+                ready.push_back(std::move(item));
+                break;
+
+            case prepare_result::waiting:
+                remaining.push_back(std::move(item));
+                break;
+
+            case prepare_result::failed:
+                break;
+            }
+        }
+
+        uploads = std::move(remaining);
+        frame_heads.at(frame) = head;
+
+        if (ready.empty())
+            return false;
+
+        auto fallback = [&]() {
+            // already in the ring, left for stage()
+            uploads.insert(uploads.end(), std::make_move_iterator(ready.begin()), std::make_move_iterator(ready.end()));
+            return false;
+        };
+
+        if (!create_async_frame(async_frame))
+            return fallback();
+
+        if (failed(device->call().vkResetCommandPool(device->get(), async_frame.cmd_pool, 0)))
+            return fallback();
+
+        VkCommandBufferBeginInfo const begin_info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
+        if (failed(device->call().vkBeginCommandBuffer(async_frame.cmd_buf, &begin_info)))
+            return fallback();
+
+        ring->flush();
+        record(async_frame.cmd_buf, ready, frame, &async_frame);
+
+        if (failed(device->call().vkEndCommandBuffer(async_frame.cmd_buf)))
+            return fallback();
+
+        auto value = timeline_value + 1;
+        auto semaphore = timeline ? timeline : async_frame.semaphore;
+
+        VkTimelineSemaphoreSubmitInfoKHR const timeline_info{
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR,
+            .signalSemaphoreValueCount = 1,
+            .pSignalSemaphoreValues = &value,
+        };
+
+        VkSubmitInfo const submit_info{
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext = timeline ? &timeline_info : nullptr,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &async_frame.cmd_buf,
+            .signalSemaphoreCount = 1,
+            .pSignalSemaphores = &semaphore,
+        };
+
+        if (!device->vkQueueSubmit(transfer_queue.vk_queue, 1, &submit_info, async_frame.fence)) {
+            log()->error("submit staging transfer");
+            async_frame.acquire = false;
+            async_frame.buffer_barriers.clear();
+            async_frame.image_barriers.clear();
+            return fallback();
+        }
+
+        if (timeline)
+            timeline_value = value;
+
+        async_frame.pending = true;
+        async_frame.wait = true;
+        async_frame.value = timeline ? value : 0;
+
+        return true;
+    }
+
+    bool staging::consume_wait(index frame, VkSemaphore& semaphore, ui64& value) {
+        if (frame >= async_frames.size())
+            return false;
+
+        auto& async_frame = async_frames.at(frame);
+        if (!async_frame.wait)
+            return false;
+
+        async_frame.wait = false;
+
+        semaphore = timeline ? timeline : async_frame.semaphore;
+        value = async_frame.value;
+        return true;
+    }
+
+    bool staging::stage(VkCommandBuffer cmd_buf, index frame) {
+        if (!ring && !uploads.empty()) {
+            auto& front = uploads.front();
+            auto owner = front.dst_texture ? front.dst_texture->get_image()->get_device() : front.dst_buffer->get_device();
+
+            if (!create(owner))
+                return false;
+        }
+
+        if (!ring)
+            return false;
+
+        reclaim(frame);
+
+        auto& async_frame = async_frames.at(frame);
+        if (async_frame.acquire)
+            record_acquire(cmd_buf, async_frame);
+
+        upload::list ready;
+        upload::list waiting;
+
+        for (auto& item : uploads) {
+            switch (prepare(item, frame)) {
+            case prepare_result::ready:
+                ready.push_back(std::move(item));
+                break;
+
+            case prepare_result::waiting:
+                waiting.push_back(std::move(item));
+                break;
+
+            case prepare_result::failed:
+                break;
+            }
+        }
+
+        uploads = std::move(waiting);
+
+        auto result = !ready.empty();
+
+        if (result) {
+            ring->flush();
+            result = record(cmd_buf, ready, frame);
+        }
+
+        frame_heads.at(frame) = head;
+        reclaimed_frame = no_index;
+
+        return result;
+    }
+
+    bool staging::record(VkCommandBuffer cmd_buf, upload::list const& ready, index frame, async_frame* release) {
+        struct image_batch {
+            texture::ptr target;
+            VkImageLayout old_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            std::map<VkBuffer, std::vector<VkBufferImageCopy>> regions;
+        };
+
+        std::map<VkImage, image_batch> images;
+        std::map<std::pair<VkBuffer, VkBuffer>, std::vector<VkBufferCopy>> buffers;
+
+        // ranges of buffers still read or written by earlier frames
+        std::vector<VkBufferMemoryBarrier> buffer_barriers;
+
+        auto preserve = false;
+        auto result = true;
+
+        for (auto& item : ready) {
+            if (item.dst_texture) {
+                auto& batch = images[item.dst_texture->get_image()->get()];
+                batch.target = item.dst_texture;
+
+                if (item.old_layout == VK_IMAGE_LAYOUT_UNDEFINED)
+                    batch.old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+                auto& regions = batch.regions[item.src];
+                regions.insert(regions.end(), item.regions.begin(), item.regions.end());
+            } else {
+                buffers[{ item.src, item.dst_buffer->get() }].push_back({
+                    .srcOffset = item.src_offset,
+                    .dstOffset = item.dst_offset,
+                    .size = item.size,
+                });
+
+                if (!item.initial)
+                    buffer_barriers.push_back({
+                        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                        .srcAccessMask = staging_read_access | VK_ACCESS_TRANSFER_WRITE_BIT,
+                        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                        .buffer = item.dst_buffer->get(),
+                        .offset = item.dst_offset,
+                        .size = item.size,
+                    });
+            }
+        }
+
+        std::vector<VkImageMemoryBarrier> barriers;
+
+        for (auto& [image, batch] : images) {
+            auto barrier = image_memory_barrier(image, batch.old_layout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+            barrier.srcAccessMask = (batch.old_layout == VK_IMAGE_LAYOUT_UNDEFINED) ? 0 : VK_ACCESS_SHADER_READ_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.subresourceRange = batch.target->get_subresource_range();
+            barriers.push_back(barrier);
+
+            if (batch.old_layout != VK_IMAGE_LAYOUT_UNDEFINED)
+                preserve = true;
+        }
+
+        if (!barriers.empty() || !buffer_barriers.empty()) {
+            VkPipelineStageFlags src_stage_mask = preserve ? VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+
+            // partial writes wait for reads and copies of earlier frames
+            if (!buffer_barriers.empty())
+                src_stage_mask |= staging_read_stages | VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+            device->call().vkCmdPipelineBarrier(cmd_buf, src_stage_mask, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr,
+                                                to_ui32(buffer_barriers.size()), buffer_barriers.data(),
+                                                to_ui32(barriers.size()), barriers.data());
+        }
+
+        for (auto& [pair, regions] : buffers)
+            device->call().vkCmdCopyBuffer(cmd_buf, pair.first, pair.second, to_ui32(regions.size()), regions.data());
+
+        for (auto& [image, batch] : images)
+            for (auto& [src, regions] : batch.regions)
+                device->call().vkCmdCopyBufferToImage(cmd_buf, src, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                      to_ui32(regions.size()), regions.data());
+
+        // level 0 written -> rest of the chain, ends in shader read only
+        for (auto& [image, batch] : images) {
+            auto& target = *batch.target;
+            if (!target.mip_levels_generation())
+                continue;
+
+            if (!target.generate_mips(cmd_buf) && !(mip_fallback && mip_fallback(cmd_buf, target, frame))) {
+                log()->error("staging - mip generation for format {}", to_ui32(target.get_format()));
+                result = false;
+                continue;
+            }
+
+            auto const generated = image;
+            std::erase_if(barriers, [&](VkImageMemoryBarrier const& barrier) { return barrier.image == generated; });
+        }
+
+        for (auto& barrier : barriers) {
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        }
+
+        if (release) {
+            release->acquire = true;
+            release->buffer_barriers.clear();
+            release->image_barriers.clear();
+
+            if (transfer_queue.family != graphics_family) {
+                // queue family ownership: release here, acquire in stage()
+                std::vector<VkBufferMemoryBarrier> buffer_barriers;
+
+                for (auto& [pair, regions] : buffers) {
+                    buffer_barriers.push_back({
+                        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                        .dstAccessMask = 0,
+                        .srcQueueFamilyIndex = transfer_queue.family,
+                        .dstQueueFamilyIndex = graphics_family,
+                        .buffer = pair.second,
+                        .offset = 0,
+                        .size = VK_WHOLE_SIZE,
+                    });
+                }
+
+                for (auto& barrier : barriers) {
+                    barrier.dstAccessMask = 0;
+                    barrier.srcQueueFamilyIndex = transfer_queue.family;
+                    barrier.dstQueueFamilyIndex = graphics_family;
+                }
+
+                device->call().vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                                                    0, nullptr, to_ui32(buffer_barriers.size()), buffer_barriers.data(),
+                                                    to_ui32(barriers.size()), barriers.data());
+
+                for (auto& barrier : buffer_barriers) {
+                    barrier.srcAccessMask = 0;
+                    barrier.dstAccessMask = staging_read_access;
+                }
+
+                for (auto& barrier : barriers) {
+                    barrier.srcAccessMask = 0;
+                    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+                }
+
+                release->buffer_barriers = std::move(buffer_barriers);
+                release->image_barriers = std::move(barriers);
+                return result;
+            }
+        }
+
+        VkMemoryBarrier const memory_barrier{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = staging_read_access,
+        };
+
+        VkPipelineStageFlags dst_stage_mask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        if (!buffers.empty())
+            dst_stage_mask |= staging_read_stages;
+
+        device->call().vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stage_mask, 0,
+                                            buffers.empty() ? 0 : 1, &memory_barrier, 0, nullptr,
+                                            to_ui32(barriers.size()), barriers.data());
+
+        return result;
+    }
+
+    void staging::record_acquire(VkCommandBuffer cmd_buf, async_frame& frame) {
+        // chained to the semaphore wait at staging_wait_stage
+        VkMemoryBarrier const memory_barrier{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = staging_read_access,
+        };
+
+        auto same_family = transfer_queue.family == graphics_family;
+
+        device->call().vkCmdPipelineBarrier(cmd_buf, staging_wait_stage, staging_read_stages, 0,
+                                            same_family ? 1 : 0, &memory_barrier,
+                                            to_ui32(frame.buffer_barriers.size()), frame.buffer_barriers.data(),
+                                            to_ui32(frame.image_barriers.size()), frame.image_barriers.data());
+
+        frame.acquire = false;
+        frame.buffer_barriers.clear();
+        frame.image_barriers.clear();
+    }
+
+} // namespace lava
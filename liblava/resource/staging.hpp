@@ -0,0 +1,170 @@
+// file      : liblava/resource/staging.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <algorithm>
+#include <liblava/resource/mesh.hpp>
+#include <liblava/resource/texture.hpp>
+
+namespace lava {
+
+    constexpr VkDeviceSize const default_staging_size = 32 * 1024 * 1024;
+
+    // wait stage for the semaphore of staging::submit
+    constexpr VkPipelineStageFlags const staging_wait_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+    struct staging {
+        ~staging() {
+            destroy();
+        }
+
+        // persistent mapped ring, suballocated by all uploads
+        // async -> initial uploads go through submit() on the async transfer queue
+        bool create(device_ptr device, VkDeviceSize size = default_staging_size, bool async = false);
+        void destroy();
+
+        // whole texture from texture::upload or map_upload
+        void add(texture::ptr texture);
+
+        // region.bufferOffset relative to data
+        bool add(texture::ptr texture, void const* data, size_t size, VkBufferImageCopy region,
+                 VkImageLayout old_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+        bool add(buffer::ptr buffer, void const* data, size_t size, VkDeviceSize offset = 0);
+
+        // mesh created with VMA_MEMORY_USAGE_GPU_ONLY
+        bool add(mesh::ptr mesh);
+
+        // before stage() of the same frame
+        bool submit(index frame);
+
+        // true once per submit(), wait with staging_wait_stage in the graphics submit of the frame
+        bool consume_wait(index frame, VkSemaphore& semaphore, ui64& value);
+
+        // frame index reuse -> fence of its last submit passed
+        // false -> nothing staged or a mip chain not generated
+        bool stage(VkCommandBuffer cmd_buf, index frame);
+
+        void clear() {
+            uploads.clear();
+        }
+
+        // textures without blit support for their mip chain, see mip_generator
+        // check empty -> func handles every texture, textures left without a chain are not staged
+        void set_mip_func(texture::mip_func func, texture::mip_check check = {}) {
+            mip_fallback = std::move(func);
+            mip_fallback_check = std::move(check);
+        }
+
+        bool busy() const {
+            return !uploads.empty() || (head != tail);
+        }
+
+        // queued and not recorded yet, destroying it now would leave a dangling copy
+        bool pending(texture const& target) const {
+            return std::any_of(uploads.begin(), uploads.end(), [&](upload const& item) {
+                return item.dst_texture.get() == &target;
+            });
+        }
+
+        bool async_enabled() const {
+            return async;
+        }
+
+        VkDeviceSize get_size() const {
+            return ring ? ring->get_size() : 0;
+        }
+        VkDeviceSize get_used() const {
+            return head - tail;
+        }
+
+    private:
+        struct upload {
+            using list = std::vector<upload>;
+
+            buffer::ptr dst_buffer;
+            VkDeviceSize dst_offset = 0;
+
+            texture::ptr dst_texture;
+            std::vector<VkBufferImageCopy> regions;
+            VkImageLayout old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+            // whole resource written, nothing to preserve
+            bool initial = false;
+
+            VkDeviceSize size = 0;
+            VkDeviceSize alignment = 4;
+
+            VkBuffer src = 0;
+            VkDeviceSize src_offset = 0;
+
+            // waiting for ring space
+            std::vector<c8> pending;
+        };
+
+        struct async_frame {
+            using list = std::vector<async_frame>;
+
+            VkCommandPool cmd_pool = 0;
+            VkCommandBuffer cmd_buf = 0;
+
+            VkFence fence = 0;
+            VkSemaphore semaphore = 0; // binary, without timeline semaphore
+
+            bool pending = false; // fence not waited yet
+            bool wait = false;    // graphics submit did not wait yet
+            ui64 value = 0;
+
+            bool acquire = false;
+            std::vector<VkBufferMemoryBarrier> buffer_barriers;
+            std::vector<VkImageMemoryBarrier> image_barriers;
+        };
+
+        enum class prepare_result {
+            ready,
+            waiting,
+            failed
+        };
+
+        bool allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+        bool write(upload& item, void const* data);
+        bool write_dedicated(upload& item, void const* data, index frame);
+        prepare_result prepare(upload& item, index frame);
+
+        void reclaim(index frame);
+        bool create_async_frame(async_frame& frame);
+
+        bool mip_supported(texture& target) const;
+
+        bool record(VkCommandBuffer cmd_buf, upload::list const& ready, index frame, async_frame* release = nullptr);
+        void record_acquire(VkCommandBuffer cmd_buf, async_frame& frame);
+
+        device_ptr device = nullptr;
+        buffer::ptr ring;
+
+        // absolute positions, offset = position % size
+        VkDeviceSize head = 0;
+        VkDeviceSize tail = 0;
+
+        std::vector<VkDeviceSize> frame_heads;
+        std::vector<buffer::list> frame_buffers;
+        index reclaimed_frame = no_index;
+
+        upload::list uploads;
+
+        bool async = false;
+        device::queue transfer_queue;
+        index graphics_family = 0;
+
+        VkSemaphore timeline = 0;
+        ui64 timeline_value = 0;
+
+        async_frame::list async_frames;
+
+        texture::mip_func mip_fallback;
+        texture::mip_check mip_fallback_check;
+    };
+
+} // namespace lava
@@ -7,10 +7,13 @@
 
 namespace lava {
 
-    bool texture::create(device_ptr device, uv2 size, VkFormat format, layer::list const& l, texture_type t) {
+    bool texture::create(device_ptr device, uv2 size, VkFormat format, layer::list const& l, texture_type t, bool mip_levels_generation) {
         layers = l;
         type = t;
 
+        mip_generation = false;
+        mip_blit = false;
+
         if (layers.empty()) {
             layer layer;
 
@@ -21,6 +24,23 @@ namespace lava {
             layers.push_back(layer);
         }
 
+        // level 0 given, rest of the chain generated
+        if (mip_levels_generation && (layers.front().levels.size() == 1)) {
+            auto const level_count = mip_level_count(size);
+
+            for (auto& layer : layers) {
+                for (auto level = 1u; level < level_count; ++level) {
+                    mip_level mip;
+                    mip.extent = { std::max(size.x >> level, 1u), std::max(size.y >> level, 1u) };
+
+                    layer.levels.push_back(mip);
+                }
+            }
+
+            mip_generation = level_count > 1;
+            mip_blit = format_blit_supported(device->get_vk_physical_device(), format);
+        }
+
         VkSamplerAddressMode sampler_address_mode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
         if (type == texture_type::array || type == texture_type::cube_map)
             sampler_address_mode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
@@ -65,7 +85,11 @@ namespace lava {
         img->set_layer_count(to_ui32(layers.size()));
         img->set_view_type(view_type);
 
-        if (!img->create(device, size, VMA_MEMORY_USAGE_GPU_ONLY)) {
+        // compute fallback writes the levels
+        if (mip_generation && !mip_blit && format_storage_supported(device->get_vk_physical_device(), format))
+            img->set_usage(img->get_info().usage | VK_IMAGE_USAGE_STORAGE_BIT);
+
+        if (!img->create(device, size, VMA_MEMORY_USAGE_GPU_ONLY, mip_generation)) {
             log()->error("create texture image");
             return false;
         }
@@ -99,34 +123,42 @@ namespace lava {
     }
 
     bool texture::upload(void const* data, size_t data_size) {
-        upload_buffer = make_buffer();
+        auto pixels = map_upload(data_size);
+        if (!pixels)
+            return false;
 
-        return upload_buffer->create(img->get_device(), data, data_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, false, VMA_MEMORY_USAGE_CPU_TO_GPU);
+        memcpy(pixels, data, data_size);
+        return true;
     }
 
-    bool texture::stage(VkCommandBuffer cmd_buf) {
-        if (!upload_buffer || !upload_buffer->valid()) {
-            log()->error("stage texture");
-            return false;
+    data_ptr texture::map_upload(size_t data_size) {
+        destroy_upload_buffer();
+
+        upload_buffer = make_buffer();
+        if (!upload_buffer->create_mapped(img->get_device(), nullptr, data_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT)) {
+            log()->error("create texture upload buffer");
+            upload_buffer = nullptr;
+            return nullptr;
         }
 
-        VkImageSubresourceRange subresource_range{
+        return as_ptr(upload_buffer->get_mapped_data());
+    }
+
+    VkImageSubresourceRange texture::get_subresource_range() const {
+        return {
             .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
             .baseMipLevel = 0,
             .levelCount = to_ui32(layers.front().levels.size()),
             .baseArrayLayer = 0,
             .layerCount = to_ui32(layers.size()),
         };
+    }
 
-        auto device = img->get_device();
-
-        set_image_layout(device, cmd_buf, img->get(), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresource_range,
-                         VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
-
+    std::vector<VkBufferImageCopy> texture::get_copy_regions(VkDeviceSize buffer_offset) const {
         std::vector<VkBufferImageCopy> regions;
 
-        if (to_ui32(layers.front().levels.size()) > 1) {
-            auto offset = 0u;
+        if ((to_ui32(layers.front().levels.size()) > 1) && !mip_generation) {
+            auto offset = buffer_offset;
 
             for (auto layer = 0u; layer < layers.size(); ++layer) {
                 for (auto level = 0u; level < to_ui32(layers.front().levels.size()); ++level) {
@@ -165,7 +197,7 @@ namespace lava {
             auto size = img->get_size();
 
             VkBufferImageCopy region{
-                .bufferOffset = 0,
+                .bufferOffset = buffer_offset,
                 .bufferRowLength = size.x,
                 .bufferImageHeight = size.y,
                 .imageSubresource = subresource_layers,
@@ -176,9 +208,38 @@ namespace lava {
             regions.push_back(region);
         }
 
+        return regions;
+    }
+
+    bool texture::stage(VkCommandBuffer cmd_buf) {
+        auto device = img->get_device();
+
+        // levels below 0 would be sampled undefined
+        if (mip_generation && !mip_blit) {
+            log()->error("stage texture - no blit support for mips, use staging with a mip generator");
+            return false;
+        }
+
+        if (!upload_buffer || !upload_buffer->valid()) {
+            log()->error("stage texture");
+            return false;
+        }
+
+        upload_buffer->flush();
+
+        auto subresource_range = get_subresource_range();
+
+        set_image_layout(device, cmd_buf, img->get(), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresource_range,
+                         VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+        auto regions = get_copy_regions();
+
         device->call().vkCmdCopyBufferToImage(cmd_buf, upload_buffer->get(), img->get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                                               to_ui32(regions.size()), regions.data());
 
+        if (mip_generation && generate_mips(cmd_buf))
+            return true;
+
         set_image_layout(device, cmd_buf, img->get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresource_range,
                          VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
@@ -186,36 +247,63 @@ namespace lava {
         return true;
     }
 
-    bool staging::stage(VkCommandBuffer cmd_buf, index frame) {
-        if (!staged.empty() && staged.count(frame) && !staged.at(frame).empty()) {
-            for (auto& texture : staged.at(frame))
-                texture->destroy_upload_buffer();
+    bool texture::generate_mips(VkCommandBuffer cmd_buf) {
+        if (!mip_generation || !mip_blit)
+            return false;
 
-            staged.erase(frame);
-        }
+        auto device = img->get_device();
 
-        if (todo.empty())
-            return false;
+        auto const level_count = get_level_count();
+        auto const layer_count = get_layer_count();
 
-        texture::list stage_done;
+        auto barrier = image_memory_barrier(img->get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.subresourceRange = get_subresource_range();
+        barrier.subresourceRange.levelCount = 1;
 
-        for (auto& texture : todo) {
-            if (!texture->stage(cmd_buf))
-                continue;
+        for (auto level = 1u; level < level_count; ++level) {
+            // level above written -> blit source
+            barrier.subresourceRange.baseMipLevel = level - 1;
 
-            stage_done.push_back(texture);
-        }
+            device->call().vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                                                0, nullptr, 0, nullptr, 1, &barrier);
 
-        if (!staged.count(frame))
-            staged.emplace(frame, texture::list());
+            auto const src = layers.front().levels[level - 1].extent;
+            auto const dst = layers.front().levels[level].extent;
 
-        for (auto& texture : stage_done) {
-            if (!contains(staged.at(frame), texture))
-                staged.at(frame).push_back(texture);
+            VkImageBlit const blit{
+                .srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, layer_count },
+                .srcOffsets = { { 0, 0, 0 }, { to_i32(src.x), to_i32(src.y), 1 } },
+                .dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, layer_count },
+                .dstOffsets = { { 0, 0, 0 }, { to_i32(dst.x), to_i32(dst.y), 1 } },
+            };
 
-            remove(todo, texture);
+            device->call().vkCmdBlitImage(cmd_buf, img->get(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                          img->get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
         }
 
+        // all levels but the last one are blit sources now
+        std::array<VkImageMemoryBarrier, 2> barriers = {
+            image_memory_barrier(img->get(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+            image_memory_barrier(img->get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+        };
+
+        barriers[0].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barriers[0].subresourceRange = get_subresource_range();
+        barriers[0].subresourceRange.levelCount = level_count - 1;
+
+        barriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barriers[1].subresourceRange = get_subresource_range();
+        barriers[1].subresourceRange.baseMipLevel = level_count - 1;
+        barriers[1].subresourceRange.levelCount = 1;
+
+        for (auto& item : barriers)
+            item.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        device->call().vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                                            0, nullptr, 0, nullptr, to_ui32(barriers.size()), barriers.data());
+
         return true;
     }
 
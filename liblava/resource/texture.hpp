@@ -41,18 +41,60 @@ namespace lava {
             mip_level::list levels;
         };
 
+        // records a mip chain without blit support, frame as in staging::stage
+        using mip_func = std::function<bool(VkCommandBuffer, texture&, index)>;
+
+        // mip_func able to record the chain of the texture
+        using mip_check = std::function<bool(texture&)>;
+
         ~texture() {
             destroy();
         }
 
+        // mip_levels_generation -> only level 0 uploaded, chain generated at stage
         bool create(device_ptr device, uv2 size, VkFormat format,
-                    layer::list const& layers = {}, texture_type type = texture_type::tex_2d);
+                    layer::list const& layers = {}, texture_type type = texture_type::tex_2d,
+                    bool mip_levels_generation = false);
         void destroy();
 
+        // copied straight into the mapped upload buffer
         bool upload(void const* data, size_t data_size);
+
+        // mapped upload buffer to write the data into, no host copy
+        data_ptr map_upload(size_t data_size);
+        // mapped upload buffer written before the texture was created, e.g. on a loader thread
+        void set_upload_buffer(buffer::ptr buffer) {
+            upload_buffer = std::move(buffer);
+        }
+        // mip chain without blit support -> false, see staging::set_mip_func
         bool stage(VkCommandBuffer cmd_buffer);
         void destroy_upload_buffer();
 
+        // all levels in transfer dst with level 0 written -> all levels shader read only
+        // false without blit support, nothing recorded
+        bool generate_mips(VkCommandBuffer cmd_buffer);
+
+        bool mip_levels_generation() const {
+            return mip_generation;
+        }
+        bool mip_blit_supported() const {
+            return mip_blit;
+        }
+
+        ui32 get_level_count() const {
+            return to_ui32(layers.front().levels.size());
+        }
+        ui32 get_layer_count() const {
+            return to_ui32(layers.size());
+        }
+
+        buffer::ptr const& get_upload_buffer() const {
+            return upload_buffer;
+        }
+
+        VkImageSubresourceRange get_subresource_range() const;
+        std::vector<VkBufferImageCopy> get_copy_regions(VkDeviceSize buffer_offset = 0) const;
+
         VkDescriptorImageInfo const* get_descriptor() const {
             return &descriptor;
         }
@@ -75,6 +117,10 @@ namespace lava {
             return img ? img->get_format() : VK_FORMAT_UNDEFINED;
         }
 
+        VkDeviceSize get_memory_size() const {
+            return img ? img->get_memory_size() : 0;
+        }
+
     private:
         image::ptr img;
 
@@ -84,6 +130,9 @@ namespace lava {
         VkSampler sampler = 0;
         VkDescriptorImageInfo descriptor = {};
 
+        bool mip_generation = false;
+        bool mip_blit = false;
+
         buffer::ptr upload_buffer;
     };
 
@@ -91,29 +140,6 @@ namespace lava {
         return std::make_shared<texture>();
     }
 
-    struct staging {
-        void add(texture::ptr texture) {
-            todo.push_back(texture);
-        }
-
-        bool stage(VkCommandBuffer cmd_buf, index frame);
-
-        void clear() {
-            todo.clear();
-            staged.clear();
-        }
-
-        bool busy() const {
-            return !todo.empty() || !staged.empty();
-        }
-
-    private:
-        texture::list todo;
-
-        using frame_stage_map = std::map<index, texture::list>;
-        frame_stage_map staged;
-    };
-
     using texture_registry = id_registry<texture, file_format>;
 
 } // namespace lava
@@ -0,0 +1,205 @@
+// file      : liblava/resource/vertex_format.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <array>
+#include <liblava/resource/mesh.hpp>
+#include <limits>
+#include <utility>
+
+namespace lava {
+
+    namespace vertex_attribute {
+
+        struct position {
+            using type = v3;
+            static constexpr VkFormat const format = VK_FORMAT_R32G32B32_SFLOAT;
+            static constexpr bool const quantized = false;
+
+            static void pack(vertex const& vertex, type& target, vertex_quantization const&) {
+                target = vertex.position;
+            }
+        };
+
+        // snorm16 in mesh bounds, position = offset + scale * value
+        struct position_16 {
+            using type = std::array<i16, 4>;
+            static constexpr VkFormat const format = VK_FORMAT_R16G16B16A16_SNORM;
+            static constexpr bool const quantized = true;
+
+            static void pack(vertex const& vertex, type& target, vertex_quantization const& quantization) {
+                auto const value = glm::clamp((vertex.position - quantization.offset) / quantization.scale, v3(-1.f), v3(1.f));
+
+                for (auto i = 0; i < 3; ++i)
+                    target[i] = static_cast<i16>(glm::round(value[i] * 32767.f));
+
+                target[3] = 32767;
+            }
+        };
+
+        struct color {
+            using type = v4;
+            static constexpr VkFormat const format = VK_FORMAT_R32G32B32A32_SFLOAT;
+            static constexpr bool const quantized = false;
+
+            static void pack(vertex const& vertex, type& target, vertex_quantization const&) {
+                target = vertex.color;
+            }
+        };
+
+        struct color_8 {
+            using type = ui32;
+            static constexpr VkFormat const format = VK_FORMAT_R8G8B8A8_UNORM;
+            static constexpr bool const quantized = false;
+
+            static void pack(vertex const& vertex, type& target, vertex_quantization const&) {
+                target = glm::packUnorm4x8(vertex.color);
+            }
+        };
+
+        struct uv {
+            using type = v2;
+            static constexpr VkFormat const format = VK_FORMAT_R32G32_SFLOAT;
+            static constexpr bool const quantized = false;
+
+            static void pack(vertex const& vertex, type& target, vertex_quantization const&) {
+                target = vertex.uv;
+            }
+        };
+
+        struct uv_16 {
+            using type = ui32;
+            static constexpr VkFormat const format = VK_FORMAT_R16G16_SFLOAT;
+            static constexpr bool const quantized = false;
+
+            static void pack(vertex const& vertex, type& target, vertex_quantization const&) {
+                target = glm::packHalf2x16(vertex.uv);
+            }
+        };
+
+        struct normal {
+            using type = v3;
+            static constexpr VkFormat const format = VK_FORMAT_R32G32B32_SFLOAT;
+            static constexpr bool const quantized = false;
+
+            static void pack(vertex const& vertex, type& target, vertex_quantization const&) {
+                target = vertex.normal;
+            }
+        };
+
+        // octahedral, decode in shader:
+        // n = vec3(e, 1 - abs(e.x) - abs(e.y)); if (n.z < 0) n.xy = (1 - abs(n.yx)) * sign(n.xy); normalize(n)
+        struct normal_oct {
+            using type = ui32;
+            static constexpr VkFormat const format = VK_FORMAT_R16G16_SNORM;
+            static constexpr bool const quantized = false;
+
+            static v2 encode(v3 normal) {
+                auto const length = glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z);
+                if (length == 0.f)
+                    return v2(0.f);
+
+                normal /= length;
+
+                v2 result(normal.x, normal.y);
+                if (normal.z < 0.f) {
+                    v2 const sign(result.x >= 0.f ? 1.f : -1.f, result.y >= 0.f ? 1.f : -1.f);
+                    result = (v2(1.f) - glm::abs(v2(result.y, result.x))) * sign;
+                }
+
+                return result;
+            }
+
+            static void pack(vertex const& vertex, type& target, vertex_quantization const&) {
+                target = glm::packSnorm2x16(encode(vertex.normal));
+            }
+        };
+
+    } // namespace vertex_attribute
+
+    // interleaved layout of vertex_attribute members, locations in order
+    template<typename... Attributes>
+    struct vertex_format {
+        static constexpr ui32 const attribute_count = sizeof...(Attributes);
+        static constexpr ui32 const stride = (sizeof(typename Attributes::type) + ...);
+        static constexpr bool const quantized = (Attributes::quantized || ...);
+
+        static constexpr std::array<ui32, attribute_count> const offsets = []() {
+            std::array<ui32, attribute_count> const sizes = { sizeof(typename Attributes::type)... };
+            std::array<ui32, attribute_count> result = {};
+
+            for (auto i = 1u; i < attribute_count; ++i)
+                result[i] = result[i - 1] + sizes[i - 1];
+
+            return result;
+        }();
+
+        static_assert(stride % 4 == 0, "vertex stride must be 4 byte aligned");
+
+        static VkVertexInputBindingDescription get_binding(ui32 binding = 0) {
+            return { binding, stride, VK_VERTEX_INPUT_RATE_VERTEX };
+        }
+
+        static VkVertexInputAttributeDescriptions get_attributes(ui32 binding = 0, ui32 first_location = 0) {
+            std::array<VkFormat, attribute_count> const formats = { Attributes::format... };
+
+            VkVertexInputAttributeDescriptions result;
+            for (auto i = 0u; i < attribute_count; ++i)
+                result.push_back({ first_location + i, binding, formats[i], offsets[i] });
+
+            return result;
+        }
+
+        static void pack(vertex::list const& vertices, std::vector<char>& target, vertex_quantization& quantization) {
+            quantization = {};
+
+            if (quantized && !vertices.empty()) {
+                auto bounds_min = vertices.front().position;
+                auto bounds_max = bounds_min;
+
+                for (auto const& vertex : vertices) {
+                    bounds_min = glm::min(bounds_min, vertex.position);
+                    bounds_max = glm::max(bounds_max, vertex.position);
+                }
+
+                quantization.offset = (bounds_min + bounds_max) * 0.5f;
+                quantization.scale = glm::max((bounds_max - bounds_min) * 0.5f, v3(std::numeric_limits<r32>::min()));
+            }
+
+            target.resize(vertices.size() * stride);
+
+            auto dst = target.data();
+            for (auto const& vertex : vertices) {
+                pack_vertex(vertex, dst, quantization, std::index_sequence_for<Attributes...>{});
+                dst += stride;
+            }
+        }
+
+    private:
+        template<size_t... Index>
+        static void pack_vertex(vertex const& vertex, char* dst, vertex_quantization const& quantization, std::index_sequence<Index...>) {
+            (pack_attribute<Attributes>(vertex, dst + offsets[Index], quantization), ...);
+        }
+
+        template<typename Attribute>
+        static void pack_attribute(vertex const& vertex, char* dst, vertex_quantization const& quantization) {
+            typename Attribute::type value;
+            Attribute::pack(vertex, value, quantization);
+
+            memcpy(dst, &value, sizeof(value));
+        }
+    };
+
+    // layout of lava::vertex, 48 bytes
+    using vertex_format_default = vertex_format<vertex_attribute::position, vertex_attribute::color,
+                                                vertex_attribute::uv, vertex_attribute::normal>;
+
+    // 16 bytes, position needs mesh::get_quantization()
+    using vertex_format_compact = vertex_format<vertex_attribute::position_16, vertex_attribute::uv_16,
+                                                vertex_attribute::normal_oct>;
+
+    static_assert(vertex_format_default::stride == sizeof(vertex), "default vertex format must match vertex");
+
+} // namespace lava
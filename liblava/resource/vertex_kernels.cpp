@@ -0,0 +1,495 @@
+// file      : liblava/resource/vertex_kernels.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#include <cmath>
+#include <cstddef>
+#include <liblava/core/simd.hpp>
+#include <liblava/resource/vertex_kernels.hpp>
+#include <unordered_map>
+
+namespace lava {
+
+    namespace {
+
+        static_assert(offsetof(vertex, position) == 0, "position must lead the vertex");
+        static_assert(offsetof(vertex, normal) + sizeof(v3) == sizeof(vertex), "normal must end the vertex");
+        static_assert(offsetof(vertex, normal) == offsetof(vertex, uv) + sizeof(v2), "normal must follow uv");
+
+        // -0 == 0, like std::hash<vertex>
+        struct position_hash {
+            size_t operator()(v3 const& position) const noexcept {
+                size_t result = 0;
+
+                for (auto i = 0; i < 3; ++i) {
+                    auto value = position[i] + 0.f;
+
+                    ui32 bits = 0;
+                    std::memcpy(&bits, &value, sizeof(bits));
+
+                    result ^= std::hash<ui32>()(bits) + 0x9e3779b9 + (result << 6) + (result >> 2);
+                }
+
+                return result;
+            }
+        };
+
+        // any unit vector perpendicular to normal
+        v3 fallback_tangent(v3 normal) {
+            if (glm::dot(normal, normal) == 0.f)
+                return v3(1.f, 0.f, 0.f);
+
+            auto const axis = std::abs(normal.x) < 0.9f ? v3(1.f, 0.f, 0.f) : v3(0.f, 1.f, 0.f);
+            return glm::normalize(axis - normal * glm::dot(normal, axis));
+        }
+
+#if LIBLAVA_SIMD_SSE
+
+        // xyz loads pick up the next member in w, stores keep it
+
+        inline __m128 xyz_mask() {
+            return _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+        }
+
+        inline __m128 load_xyz(r32 const* source) {
+            return _mm_loadu_ps(source);
+        }
+
+        inline void store_xyz(r32* target, __m128 value) {
+            auto const mask = xyz_mask();
+            _mm_storeu_ps(target, _mm_or_ps(_mm_and_ps(mask, value), _mm_andnot_ps(mask, _mm_loadu_ps(target))));
+        }
+
+        inline __m128 load_position(vertex const& vertex) {
+            return load_xyz(&vertex.position.x);
+        }
+
+        inline void store_position(vertex& vertex, __m128 value) {
+            store_xyz(&vertex.position.x, value);
+        }
+
+        // normal ends the vertex, accessed from uv.y to stay inside
+        inline __m128 load_normal(vertex const& vertex) {
+            auto const value = _mm_loadu_ps(&vertex.uv.y);
+            return _mm_shuffle_ps(value, value, _MM_SHUFFLE(0, 3, 2, 1));
+        }
+
+        inline void store_normal(vertex& vertex, __m128 value) {
+            auto const target = &vertex.uv.y;
+            auto const shifted = _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 1, 0, 3));
+            auto const mask = _mm_castsi128_ps(_mm_set_epi32(-1, -1, -1, 0));
+            _mm_storeu_ps(target, _mm_or_ps(_mm_and_ps(mask, shifted), _mm_andnot_ps(mask, _mm_loadu_ps(target))));
+        }
+
+        template<int Lane>
+        inline __m128 splat(__m128 value) {
+            return _mm_shuffle_ps(value, value, _MM_SHUFFLE(Lane, Lane, Lane, Lane));
+        }
+
+        // result in all lanes
+        inline __m128 dot3(__m128 a, __m128 b) {
+            auto const product = _mm_mul_ps(a, b);
+            return _mm_add_ps(_mm_add_ps(splat<0>(product), splat<1>(product)), splat<2>(product));
+        }
+
+        inline __m128 cross3(__m128 a, __m128 b) {
+            auto const a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+            auto const b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+            auto const result = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+            return _mm_shuffle_ps(result, result, _MM_SHUFFLE(3, 0, 2, 1));
+        }
+
+        // zero stays zero
+        inline __m128 normalize3(__m128 value) {
+            auto const length = _mm_sqrt_ps(dot3(value, value));
+            auto const valid = _mm_cmpgt_ps(length, _mm_setzero_ps());
+            return _mm_and_ps(valid, _mm_div_ps(value, length));
+        }
+
+        inline void add_xyz(v4& target, __m128 value) {
+            _mm_storeu_ps(&target.x, _mm_add_ps(_mm_loadu_ps(&target.x), _mm_and_ps(xyz_mask(), value)));
+        }
+
+        inline __m128 transform_point(__m128 point, __m128 const* columns) {
+            auto result = _mm_add_ps(_mm_mul_ps(columns[0], splat<0>(point)), columns[3]);
+            result = _mm_add_ps(result, _mm_mul_ps(columns[1], splat<1>(point)));
+            return _mm_add_ps(result, _mm_mul_ps(columns[2], splat<2>(point)));
+        }
+
+#endif
+
+#if LIBLAVA_SIMD_AVX
+
+        inline __m256 load_positions(vertex const& first, vertex const& second) {
+            return _mm256_insertf128_ps(_mm256_castps128_ps256(load_position(first)), load_position(second), 1);
+        }
+
+        template<int Lane>
+        inline __m256 splat(__m256 value) {
+            return _mm256_shuffle_ps(value, value, _MM_SHUFFLE(Lane, Lane, Lane, Lane));
+        }
+
+        inline __m256 dot3(__m256 a, __m256 b) {
+            auto const product = _mm256_mul_ps(a, b);
+            return _mm256_add_ps(_mm256_add_ps(splat<0>(product), splat<1>(product)), splat<2>(product));
+        }
+
+        inline __m256 broadcast(__m128 value) {
+            return _mm256_insertf128_ps(_mm256_castps128_ps256(value), value, 1);
+        }
+
+        inline __m128 low(__m256 value) {
+            return _mm256_castps256_ps128(value);
+        }
+
+        inline __m128 high(__m256 value) {
+            return _mm256_extractf128_ps(value, 1);
+        }
+
+#endif
+
+        template<typename Corner>
+        void for_each_triangle(mesh_data const& data, Corner corner) {
+            auto const vertex_count = data.vertices.size();
+            auto const corner_count = data.indices.empty() ? vertex_count : data.indices.size();
+
+            for (size_t c = 0; c + 2 < corner_count; c += 3) {
+                index const triangle[] = {
+                    data.indices.empty() ? to_ui32(c) : data.indices[c],
+                    data.indices.empty() ? to_ui32(c + 1) : data.indices[c + 1],
+                    data.indices.empty() ? to_ui32(c + 2) : data.indices[c + 2],
+                };
+
+                if ((triangle[0] >= vertex_count) || (triangle[1] >= vertex_count) || (triangle[2] >= vertex_count))
+                    continue;
+
+                corner(triangle);
+            }
+        }
+
+    } // namespace
+
+    name get_vertex_kernel_path() {
+#if LIBLAVA_SIMD_AVX
+        return "avx";
+#elif LIBLAVA_SIMD_SSE
+        return "sse";
+#else
+        return "scalar";
+#endif
+    }
+
+    void translate_vertices(vertex::list& vertices, v3 offset) {
+#if LIBLAVA_SIMD_SSE
+        auto const add = _mm_set_ps(0.f, offset.z, offset.y, offset.x);
+
+        for (auto& vertex : vertices)
+            store_position(vertex, _mm_add_ps(load_position(vertex), add));
+#else
+        for (auto& vertex : vertices)
+            vertex.position += offset;
+#endif
+    }
+
+    void scale_vertices(vertex::list& vertices, r32 factor) {
+#if LIBLAVA_SIMD_SSE
+        auto const scale = _mm_set_ps(1.f, factor, factor, factor);
+
+        for (auto& vertex : vertices)
+            store_position(vertex, _mm_mul_ps(load_position(vertex), scale));
+#else
+        for (auto& vertex : vertices)
+            vertex.position *= factor;
+#endif
+    }
+
+    void transform_vertices(vertex::list& vertices, mat4 const& matrix) {
+        auto const normal_matrix = glm::transpose(glm::inverse(mat3(matrix)));
+
+#if LIBLAVA_SIMD_SSE
+        __m128 const columns[] = {
+            _mm_loadu_ps(&matrix[0].x),
+            _mm_loadu_ps(&matrix[1].x),
+            _mm_loadu_ps(&matrix[2].x),
+            _mm_loadu_ps(&matrix[3].x),
+        };
+
+        __m128 const normal_columns[] = {
+            _mm_set_ps(0.f, normal_matrix[0].z, normal_matrix[0].y, normal_matrix[0].x),
+            _mm_set_ps(0.f, normal_matrix[1].z, normal_matrix[1].y, normal_matrix[1].x),
+            _mm_set_ps(0.f, normal_matrix[2].z, normal_matrix[2].y, normal_matrix[2].x),
+            _mm_setzero_ps(),
+        };
+
+        auto const count = vertices.size();
+        size_t i = 0;
+
+#    if LIBLAVA_SIMD_AVX
+        __m256 const pair_columns[] = {
+            broadcast(columns[0]),
+            broadcast(columns[1]),
+            broadcast(columns[2]),
+            broadcast(columns[3]),
+        };
+
+        for (; i + 1 < count; i += 2) {
+            auto const points = load_positions(vertices[i], vertices[i + 1]);
+
+            auto result = _mm256_add_ps(_mm256_mul_ps(pair_columns[0], splat<0>(points)), pair_columns[3]);
+            result = _mm256_add_ps(result, _mm256_mul_ps(pair_columns[1], splat<1>(points)));
+            result = _mm256_add_ps(result, _mm256_mul_ps(pair_columns[2], splat<2>(points)));
+
+            store_position(vertices[i], low(result));
+            store_position(vertices[i + 1], high(result));
+
+            store_normal(vertices[i], normalize3(transform_point(load_normal(vertices[i]), normal_columns)));
+            store_normal(vertices[i + 1], normalize3(transform_point(load_normal(vertices[i + 1]), normal_columns)));
+        }
+#    endif
+
+        for (; i < count; ++i) {
+            auto& vertex = vertices[i];
+
+            store_position(vertex, transform_point(load_position(vertex), columns));
+            store_normal(vertex, normalize3(transform_point(load_normal(vertex), normal_columns)));
+        }
+#else
+        for (auto& vertex : vertices) {
+            vertex.position = v3(matrix * v4(vertex.position, 1.f));
+
+            auto const normal = normal_matrix * vertex.normal;
+            auto const length = glm::length(normal);
+            vertex.normal = length > 0.f ? normal / length : v3(0.f);
+        }
+#endif
+    }
+
+    mesh_bounds compute_bounds(vertex::list const& vertices) {
+        mesh_bounds result;
+        if (vertices.empty())
+            return result;
+
+#if LIBLAVA_SIMD_SSE
+        auto const count = vertices.size();
+
+        auto bounds_min = load_position(vertices.front());
+        auto bounds_max = bounds_min;
+
+        size_t i = 0;
+
+#    if LIBLAVA_SIMD_AVX
+        auto pair_min = broadcast(bounds_min);
+        auto pair_max = pair_min;
+
+        for (; i + 1 < count; i += 2) {
+            auto const points = load_positions(vertices[i], vertices[i + 1]);
+            pair_min = _mm256_min_ps(pair_min, points);
+            pair_max = _mm256_max_ps(pair_max, points);
+        }
+
+        bounds_min = _mm_min_ps(low(pair_min), high(pair_min));
+        bounds_max = _mm_max_ps(low(pair_max), high(pair_max));
+#    endif
+
+        for (; i < count; ++i) {
+            auto const point = load_position(vertices[i]);
+            bounds_min = _mm_min_ps(bounds_min, point);
+            bounds_max = _mm_max_ps(bounds_max, point);
+        }
+
+        auto const center = _mm_mul_ps(_mm_add_ps(bounds_min, bounds_max), _mm_set1_ps(0.5f));
+        auto radius_squared = _mm_setzero_ps();
+
+        i = 0;
+
+#    if LIBLAVA_SIMD_AVX
+        auto const pair_center = broadcast(center);
+        auto pair_radius = _mm256_setzero_ps();
+
+        for (; i + 1 < count; i += 2) {
+            auto const offset = _mm256_sub_ps(load_positions(vertices[i], vertices[i + 1]), pair_center);
+            pair_radius = _mm256_max_ps(pair_radius, dot3(offset, offset));
+        }
+
+        radius_squared = _mm_max_ps(low(pair_radius), high(pair_radius));
+#    endif
+
+        for (; i < count; ++i) {
+            auto const offset = _mm_sub_ps(load_position(vertices[i]), center);
+            radius_squared = _mm_max_ps(radius_squared, dot3(offset, offset));
+        }
+
+        alignas(16) r32 values[3][4];
+        _mm_store_ps(values[0], bounds_min);
+        _mm_store_ps(values[1], bounds_max);
+        _mm_store_ps(values[2], center);
+
+        result.min = v3(values[0][0], values[0][1], values[0][2]);
+        result.max = v3(values[1][0], values[1][1], values[1][2]);
+        result.center = v3(values[2][0], values[2][1], values[2][2]);
+        result.radius = _mm_cvtss_f32(_mm_sqrt_ss(radius_squared));
+#else
+        result.min = vertices.front().position;
+        result.max = result.min;
+
+        for (auto const& vertex : vertices) {
+            result.min = glm::min(result.min, vertex.position);
+            result.max = glm::max(result.max, vertex.position);
+        }
+
+        result.center = (result.min + result.max) * 0.5f;
+
+        auto radius_squared = 0.f;
+        for (auto const& vertex : vertices) {
+            auto const offset = vertex.position - result.center;
+            radius_squared = glm::max(radius_squared, glm::dot(offset, offset));
+        }
+
+        result.radius = std::sqrt(radius_squared);
+#endif
+
+        return result;
+    }
+
+    void compute_normals(mesh_data& data, bool by_position) {
+        auto& vertices = data.vertices;
+        auto const vertex_count = vertices.size();
+        if (vertex_count == 0)
+            return;
+
+        // vertex -> accumulated normal
+        index_list slots(vertex_count);
+        size_t slot_count = 0;
+
+        if (by_position) {
+            std::unordered_map<v3, index, position_hash> unique_positions;
+            unique_positions.reserve(vertex_count);
+
+            for (auto i = 0u; i < vertex_count; ++i) {
+                auto [it, inserted] = unique_positions.try_emplace(vertices[i].position, to_ui32(slot_count));
+                if (inserted)
+                    ++slot_count;
+
+                slots[i] = it->second;
+            }
+        } else {
+            for (auto i = 0u; i < vertex_count; ++i)
+                slots[i] = i;
+
+            slot_count = vertex_count;
+        }
+
+        // v4 -> full width loads
+        std::vector<v4> normals(slot_count, v4(0.f));
+
+        for_each_triangle(data, [&](index const* triangle) {
+#if LIBLAVA_SIMD_SSE
+            auto const p0 = load_position(vertices[triangle[0]]);
+            auto const p1 = load_position(vertices[triangle[1]]);
+            auto const p2 = load_position(vertices[triangle[2]]);
+
+            // length -> twice the area
+            auto const face = cross3(_mm_sub_ps(p1, p0), _mm_sub_ps(p2, p0));
+
+            for (auto c = 0u; c < 3; ++c)
+                add_xyz(normals[slots[triangle[c]]], face);
+#else
+            auto const& p0 = vertices[triangle[0]].position;
+            auto const face = glm::cross(vertices[triangle[1]].position - p0, vertices[triangle[2]].position - p0);
+
+            for (auto c = 0u; c < 3; ++c)
+                normals[slots[triangle[c]]] += v4(face, 0.f);
+#endif
+        });
+
+        for (auto i = 0u; i < vertex_count; ++i) {
+#if LIBLAVA_SIMD_SSE
+            store_normal(vertices[i], normalize3(_mm_loadu_ps(&normals[slots[i]].x)));
+#else
+            auto const normal = v3(normals[slots[i]]);
+            auto const length = glm::length(normal);
+            vertices[i].normal = length > 0.f ? normal / length : v3(0.f);
+#endif
+        }
+    }
+
+    std::vector<v4> compute_tangents(mesh_data const& data) {
+        auto const& vertices = data.vertices;
+        auto const vertex_count = vertices.size();
+
+        std::vector<v4> tangents(vertex_count, v4(0.f));
+        std::vector<v4> bitangents(vertex_count, v4(0.f));
+
+        for_each_triangle(data, [&](index const* triangle) {
+            auto const& v0 = vertices[triangle[0]];
+            auto const& v1 = vertices[triangle[1]];
+            auto const& v2 = vertices[triangle[2]];
+
+            auto const du1 = v1.uv.x - v0.uv.x;
+            auto const dv1 = v1.uv.y - v0.uv.y;
+            auto const du2 = v2.uv.x - v0.uv.x;
+            auto const dv2 = v2.uv.y - v0.uv.y;
+
+            auto const det = du1 * dv2 - du2 * dv1;
+            if ((det == 0.f) || !std::isfinite(det))
+                return;
+
+            auto const r = 1.f / det;
+
+#if LIBLAVA_SIMD_SSE
+            auto const e1 = _mm_sub_ps(load_position(v1), load_position(v0));
+            auto const e2 = _mm_sub_ps(load_position(v2), load_position(v0));
+
+            auto const tangent = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e1, _mm_set1_ps(dv2)), _mm_mul_ps(e2, _mm_set1_ps(dv1))), _mm_set1_ps(r));
+            auto const bitangent = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e2, _mm_set1_ps(du1)), _mm_mul_ps(e1, _mm_set1_ps(du2))), _mm_set1_ps(r));
+
+            for (auto c = 0u; c < 3; ++c) {
+                add_xyz(tangents[triangle[c]], tangent);
+                add_xyz(bitangents[triangle[c]], bitangent);
+            }
+#else
+            auto const e1 = v1.position - v0.position;
+            auto const e2 = v2.position - v0.position;
+
+            auto const tangent = v4((e1 * dv2 - e2 * dv1) * r, 0.f);
+            auto const bitangent = v4((e2 * du1 - e1 * du2) * r, 0.f);
+
+            for (auto c = 0u; c < 3; ++c) {
+                tangents[triangle[c]] += tangent;
+                bitangents[triangle[c]] += bitangent;
+            }
+#endif
+        });
+
+        // gram-schmidt against the normal
+        for (auto i = 0u; i < vertex_count; ++i) {
+            auto& tangent = tangents[i];
+            auto const& normal = vertices[i].normal;
+
+#if LIBLAVA_SIMD_SSE
+            auto const n = _mm_and_ps(xyz_mask(), load_normal(vertices[i]));
+            auto const t = _mm_loadu_ps(&tangent.x);
+
+            auto const orthogonal = normalize3(_mm_sub_ps(t, _mm_mul_ps(n, dot3(n, t))));
+            auto const sign = _mm_cvtss_f32(dot3(cross3(n, orthogonal), _mm_loadu_ps(&bitangents[i].x)));
+
+            _mm_storeu_ps(&tangent.x, orthogonal);
+#else
+            auto const orthogonal = v3(tangent) - normal * glm::dot(normal, v3(tangent));
+            auto const length = glm::length(orthogonal);
+
+            tangent = v4(length > 0.f ? orthogonal / length : v3(0.f), 0.f);
+
+            auto const sign = glm::dot(glm::cross(normal, v3(tangent)), v3(bitangents[i]));
+#endif
+
+            if ((tangent.x == 0.f) && (tangent.y == 0.f) && (tangent.z == 0.f))
+                tangent = v4(fallback_tangent(normal), 1.f);
+            else
+                tangent.w = sign < 0.f ? -1.f : 1.f;
+        }
+
+        return tangents;
+    }
+
+} // namespace lava
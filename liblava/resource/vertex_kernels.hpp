@@ -0,0 +1,37 @@
+// file      : liblava/resource/vertex_kernels.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/resource/mesh.hpp>
+
+namespace lava {
+
+    // sse / avx when compiled for it, LIBLAVA_SIMD 0 -> scalar
+    name get_vertex_kernel_path();
+
+    void translate_vertices(vertex::list& vertices, v3 offset);
+    void scale_vertices(vertex::list& vertices, r32 factor);
+
+    // affine, normals with the inverse transpose and renormalized
+    void transform_vertices(vertex::list& vertices, mat4 const& matrix);
+
+    struct mesh_bounds {
+        v3 min = v3(0.f);
+        v3 max = v3(0.f);
+
+        // sphere around the box center
+        v3 center = v3(0.f);
+        r32 radius = 0.f;
+    };
+
+    mesh_bounds compute_bounds(vertex::list const& vertices);
+
+    // area weighted, by_position -> corners split by uv or color share one normal
+    void compute_normals(mesh_data& data, bool by_position = true);
+
+    // per vertex from uv, xyz tangent / w bitangent sign, needs normals
+    std::vector<v4> compute_tangents(mesh_data const& data);
+
+} // namespace lava
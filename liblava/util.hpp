@@ -6,6 +6,7 @@
 
 #include <liblava/util/log.hpp>
 #include <liblava/util/random.hpp>
+#include <liblava/util/scheduler.hpp>
 #include <liblava/util/telegram.hpp>
 #include <liblava/util/thread.hpp>
 #include <liblava/util/utility.hpp>
@@ -0,0 +1,380 @@
+// file      : liblava/util/scheduler.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <array>
+#include <future>
+#include <liblava/util/thread.hpp>
+#include <type_traits>
+
+namespace lava {
+
+    // Chase-Lev deque: push / pop by owner, steal by everyone else
+    template<typename T, size_t Capacity = 4096>
+    struct work_stealing_deque : no_copy_no_move {
+        static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+        bool push(T* item) {
+            auto b = bottom.load(std::memory_order_relaxed);
+            auto t = top.load(std::memory_order_acquire);
+            if (b - t >= capacity)
+                return false;
+
+            items[b & mask].store(item, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        T* pop() {
+            auto b = bottom.load(std::memory_order_relaxed) - 1;
+            bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto t = top.load(std::memory_order_relaxed);
+
+            if (t > b) {
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            auto item = items[b & mask].load(std::memory_order_relaxed);
+            if (t == b) {
+                // last item - race against thieves
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    item = nullptr;
+
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+
+            return item;
+        }
+
+        T* steal() {
+            auto t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto b = bottom.load(std::memory_order_acquire);
+            if (t >= b)
+                return nullptr;
+
+            auto item = items[t & mask].load(std::memory_order_relaxed);
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return nullptr;
+
+            return item;
+        }
+
+        bool empty() const {
+            return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr i64 const capacity = Capacity;
+        static constexpr i64 const mask = capacity - 1;
+
+        alignas(64) std::atomic<i64> top = { 0 };
+        alignas(64) std::atomic<i64> bottom = { 0 };
+        std::array<std::atomic<T*>, Capacity> items = {};
+    };
+
+    struct task_scheduler;
+
+    // reuse or destroy only after wait() returned
+    struct task_group : no_copy_no_move {
+        bool done() const {
+            return pending.load(std::memory_order_acquire) == 0;
+        }
+
+        ui32 get_pending() const {
+            return pending.load(std::memory_order_relaxed);
+        }
+
+    private:
+        friend struct task_scheduler;
+
+        std::atomic<ui32> pending = { 0 };
+
+        std::mutex continuation_mutex;
+        std::vector<std::function<void()>> continuations;
+    };
+
+    struct task_scheduler : no_copy_no_move {
+        using task = std::function<void()>;
+
+        ~task_scheduler() {
+            teardown();
+        }
+
+        // count 0 -> hardware threads - 1
+        void setup(ui32 count = 0) {
+            if (!workers.empty())
+                return;
+
+            // hardware_concurrency() may be 0
+            if (count == 0)
+                count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+            stop = false;
+
+            for (auto i = 0u; i < count; ++i)
+                workers.emplace_back(std::make_unique<worker>());
+
+            for (auto i = 0u; i < count; ++i)
+                workers[i]->thread = std::thread([&, i]() { run_worker(i); });
+        }
+
+        void teardown() {
+            if (workers.empty())
+                return;
+
+            stop = true;
+            {
+                std::unique_lock<std::mutex> lock(sleep_mutex);
+            }
+            wake.notify_all();
+
+            for (auto& worker : workers)
+                worker->thread.join();
+
+            // left over jobs still run, their groups would never be done otherwise
+            while (auto job = find_job(no_index))
+                run(job);
+
+            workers.clear();
+            queued = 0;
+        }
+
+        ui32 get_worker_count() const {
+            return to_ui32(workers.size());
+        }
+
+        // no_index -> not a worker of this scheduler
+        index get_worker_index() const {
+            auto& ctx = context();
+            return ctx.scheduler == this ? ctx.worker : no_index;
+        }
+
+        static id::ref get_thread_id() {
+            return context().thread_id;
+        }
+
+        void submit(task func, task_group* group = nullptr) {
+            auto job = new scheduled_job{ std::move(func), group };
+
+            if (group)
+                group->pending.fetch_add(1, std::memory_order_acq_rel);
+
+            queued.fetch_add(1);
+
+            auto worker_index = get_worker_index();
+            if ((worker_index == no_index) || !workers[worker_index]->jobs.push(job)) {
+                std::unique_lock<std::mutex> lock(injection_mutex);
+                injection.push_back(job);
+            }
+
+            if (sleeping.load() > 0) {
+                {
+                    std::unique_lock<std::mutex> lock(sleep_mutex);
+                }
+                wake.notify_one();
+            }
+        }
+
+        template<typename F>
+        auto async(F func, task_group* group = nullptr) -> std::future<std::invoke_result_t<F>> {
+            using result_type = std::invoke_result_t<F>;
+
+            auto packaged = std::make_shared<std::packaged_task<result_type()>>(std::move(func));
+            auto result = packaged->get_future();
+
+            submit([packaged]() { (*packaged)(); }, group);
+            return result;
+        }
+
+        // submitted when all tasks of the group are done
+        void then(task_group& group, task func) {
+            {
+                std::unique_lock<std::mutex> lock(group.continuation_mutex);
+                if (group.pending.load(std::memory_order_acquire) > 0) {
+                    group.continuations.push_back(std::move(func));
+                    return;
+                }
+            }
+
+            submit(std::move(func));
+        }
+
+        // runs pending tasks while waiting
+        void wait(task_group& group) {
+            auto worker_index = get_worker_index();
+
+            while (!group.done()) {
+                if (auto job = find_job(worker_index))
+                    run(job);
+                else
+                    std::this_thread::yield();
+            }
+
+            // last finish() may still hold the lock
+            std::unique_lock<std::mutex> lock(group.continuation_mutex);
+        }
+
+        template<typename F>
+        void parallel_for(index begin, index end, F const& func, index grain = 0) {
+            if (begin >= end)
+                return;
+
+            auto count = end - begin;
+            if (grain == 0)
+                grain = std::max(1u, count / ((get_worker_count() + 1) * 4));
+
+            task_group group;
+
+            for (auto first = begin; first < end; first += grain) {
+                auto last = std::min(first + grain, end);
+
+                submit([&func, first, last]() {
+                    for (auto i = first; i < last; ++i)
+                        func(i);
+                },
+                       &group);
+            }
+
+            wait(group);
+        }
+
+    private:
+        struct scheduled_job {
+            task func;
+            task_group* group = nullptr;
+        };
+
+        struct worker {
+            work_stealing_deque<scheduled_job> jobs;
+            std::thread thread;
+        };
+
+        struct worker_context {
+            task_scheduler const* scheduler = nullptr;
+            index worker = no_index;
+            id thread_id;
+        };
+
+        static worker_context& context() {
+            thread_local worker_context ctx;
+            return ctx;
+        }
+
+        void run_worker(index worker_index) {
+            auto& ctx = context();
+            ctx.scheduler = this;
+            ctx.worker = worker_index;
+            ctx.thread_id = ids::next();
+
+            auto const spin_count = 64u;
+
+            while (!stop) {
+                scheduled_job* job = nullptr;
+
+                for (auto spin = 0u; (spin < spin_count) && !job && !stop; ++spin) {
+                    job = find_job(worker_index);
+                    if (!job)
+                        std::this_thread::yield();
+                }
+
+                if (job) {
+                    run(job);
+                    continue;
+                }
+
+                sleeping.fetch_add(1);
+                {
+                    std::unique_lock<std::mutex> lock(sleep_mutex);
+                    wake.wait(lock, [&]() { return stop || (queued.load() > 0); });
+                }
+                sleeping.fetch_sub(1);
+            }
+
+            ids::free(ctx.thread_id);
+            ctx = {};
+        }
+
+        scheduled_job* find_job(index worker_index) {
+            scheduled_job* job = nullptr;
+
+            if (worker_index != no_index)
+                job = workers[worker_index]->jobs.pop();
+
+            if (!job) {
+                std::unique_lock<std::mutex> lock(injection_mutex, std::try_to_lock);
+                if (lock.owns_lock() && !injection.empty()) {
+                    job = injection.front();
+                    injection.pop_front();
+                }
+            }
+
+            if (!job) {
+                auto count = to_ui32(workers.size());
+                auto start = (worker_index != no_index) ? worker_index + 1 : 0u;
+
+                for (auto i = 0u; (i < count) && !job; ++i) {
+                    auto victim = (start + i) % count;
+                    if (victim != worker_index)
+                        job = workers[victim]->jobs.steal();
+                }
+            }
+
+            if (job)
+                queued.fetch_sub(1);
+
+            return job;
+        }
+
+        void run(scheduled_job* job) {
+            job->func();
+
+            if (job->group)
+                finish(*job->group);
+
+            delete job;
+        }
+
+        void finish(task_group& group) {
+            // not the last one -> no lock
+            auto current = group.pending.load(std::memory_order_relaxed);
+            while (current > 1) {
+                if (group.pending.compare_exchange_weak(current, current - 1, std::memory_order_acq_rel))
+                    return;
+            }
+
+            std::vector<task> continuations;
+            {
+                // then() checks pending under the same lock
+                std::unique_lock<std::mutex> lock(group.continuation_mutex);
+                if (group.pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                    return;
+
+                continuations.swap(group.continuations);
+            }
+
+            // group not touched any more, it may be gone
+            for (auto& func : continuations)
+                submit(std::move(func));
+        }
+
+        std::vector<std::unique_ptr<worker>> workers;
+
+        std::deque<scheduled_job*> injection;
+        std::mutex injection_mutex;
+
+        std::atomic<i32> queued = { 0 };
+        std::atomic<i32> sleeping = { 0 };
+
+        std::mutex sleep_mutex;
+        std::condition_variable wake;
+
+        std::atomic<bool> stop = { false };
+    };
+
+} // namespace lava
@@ -6,7 +6,7 @@
 
 #include <any>
 #include <cmath>
-#include <liblava/util/thread.hpp>
+#include <liblava/util/scheduler.hpp>
 #include <set>
 
 namespace lava {
@@ -43,11 +43,11 @@ namespace lava {
 
     struct dispatcher {
         void setup(ui32 threadcount) {
-            pool.setup(threadcount);
+            scheduler.setup(threadcount);
         }
 
         void teardown() {
-            pool.teardown();
+            scheduler.teardown();
         }
 
         void update(ms current) {
@@ -72,9 +72,9 @@ namespace lava {
 
     private:
         void discharge(telegram::ref message) {
-            pool.enqueue([&, message](id::ref thread) {
+            scheduler.submit([&, message]() {
                 if (on_message)
-                    on_message(message, thread);
+                    on_message(message, task_scheduler::get_thread_id());
             });
         }
 
@@ -87,7 +87,7 @@ namespace lava {
 
         ms current_time;
 
-        thread_pool pool;
+        task_scheduler scheduler;
         std::set<telegram> messages;
     };
 
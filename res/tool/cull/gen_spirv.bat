@@ -0,0 +1,3 @@
+@ECHO on
+
+glslangValidator -V -x -o cull.comp.u32 cull.comp
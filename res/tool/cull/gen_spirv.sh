@@ -0,0 +1,3 @@
+#!/bin/bash
+
+glslangValidator -V -x -o cull.comp.u32 cull.comp
@@ -0,0 +1,3 @@
+@ECHO on
+
+glslangValidator -V -x -o mip.comp.u32 mip.comp
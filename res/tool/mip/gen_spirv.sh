@@ -0,0 +1,3 @@
+#!/bin/bash
+
+glslangValidator -V -x -o mip.comp.u32 mip.comp
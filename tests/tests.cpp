@@ -405,3 +405,1596 @@ LAVA_TEST(8, "imgui demo") {
 
     return app.run();
 }
+
+LAVA_TEST(9, "task scheduler") {
+    setup_log({ .debug = true });
+
+    auto const thread_count = std::max(2u, std::thread::hardware_concurrency());
+    auto const task_count = 1000000u;
+
+    std::atomic<ui32> counter = 0;
+
+    thread_pool pool;
+    pool.setup(thread_count);
+
+    timer timer;
+    for (auto i = 0u; i < task_count; ++i)
+        pool.enqueue([&](id::ref) { ++counter; });
+
+    while (counter < task_count)
+        std::this_thread::yield();
+
+    auto pool_time = timer.elapsed();
+    pool.teardown();
+
+    // every task exactly once
+    auto passed = counter == task_count;
+
+    task_scheduler scheduler;
+    scheduler.setup(thread_count);
+
+    counter = 0;
+    timer.reset();
+
+    task_group group;
+    for (auto i = 0u; i < task_count; ++i)
+        scheduler.submit([&]() { ++counter; }, &group);
+
+    scheduler.wait(group);
+    auto scheduler_time = timer.elapsed();
+
+    passed &= counter == task_count;
+
+    counter = 0;
+    timer.reset();
+
+    scheduler.parallel_for(0, task_count, [&](ui32) { ++counter; });
+    auto parallel_time = timer.elapsed();
+
+    passed &= counter == task_count;
+
+    // nested spawn from inside the workers
+    counter = 0;
+    timer.reset();
+
+    task_group nested;
+    for (auto i = 0u; i < thread_count; ++i)
+        scheduler.submit([&]() {
+            for (auto j = 0u; j < task_count / thread_count; ++j)
+                scheduler.submit([&]() { ++counter; }, &nested);
+        },
+                         &nested);
+
+    scheduler.wait(nested);
+    auto nested_time = timer.elapsed();
+
+    auto const nested_count = task_count / thread_count * thread_count;
+    passed &= counter == nested_count;
+
+    task_group chain;
+    scheduler.submit([&]() { ++counter; }, &chain);
+
+    std::promise<bool> chained;
+    auto done = chained.get_future();
+    scheduler.then(chain, [&]() { chained.set_value(true); });
+
+    auto result = scheduler.async([&]() { return counter.load(); });
+    scheduler.wait(chain);
+
+    auto result_value = result.get();
+    auto done_value = done.get();
+
+    scheduler.teardown();
+
+    // async may run before or after the chained task
+    passed &= (counter == nested_count + 1) && (result_value >= nested_count) && (result_value <= nested_count + 1) && done_value;
+
+    log()->info("{} tasks on {} threads", task_count, thread_count);
+    log()->info("thread pool: {} ms", pool_time.count());
+    log()->info("task scheduler: {} ms", scheduler_time.count());
+    log()->info("parallel for: {} ms", parallel_time.count());
+    log()->info("nested spawn: {} ms", nested_time.count());
+    log()->info("async: {} - then: {}", result_value, done_value);
+
+    return passed ? 0 : -1;
+}
+
+LAVA_TEST(10, "id allocation") {
+    setup_log({ .debug = true });
+
+    auto const thread_count = std::max(2u, std::thread::hardware_concurrency());
+    auto const id_count = 1000000u;
+
+    for (auto threads = 1u; threads <= thread_count; threads *= 2) {
+        std::vector<std::thread> workers;
+
+        timer timer;
+        for (auto t = 0u; t < threads; ++t)
+            workers.emplace_back([&]() {
+                id::list list(64);
+
+                for (auto i = 0u; i < id_count / 64; ++i) {
+                    for (auto& id : list)
+                        id = ids::next();
+
+                    for (auto& id : list)
+                        ids::free(id);
+                }
+            });
+
+        for (auto& worker : workers)
+            worker.join();
+
+        auto time = timer.elapsed();
+        log()->info("{} threads: {} ids in {} ms", threads, threads * id_count, time.count());
+    }
+
+    log()->info("max id: {}", ids::global().get_max());
+
+    // a value comes back with the next version, never twice at once
+    auto const first = ids::next();
+    ids::free(first);
+
+    auto const second = ids::next();
+    auto passed = (second.value == first.value) && (second.version == first.version + 1);
+    ids::free(second);
+
+    std::vector<id::list> handed_out(thread_count);
+    {
+        std::vector<std::thread> workers;
+
+        for (auto t = 0u; t < thread_count; ++t)
+            workers.emplace_back([&, t]() {
+                id::list list(64);
+
+                for (auto i = 0u; i < 1000; ++i) {
+                    for (auto& id : list) {
+                        id = ids::next();
+                        handed_out[t].push_back(id);
+                    }
+
+                    for (auto& id : list)
+                        ids::free(id);
+                }
+            });
+
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    id::list all;
+    for (auto& list : handed_out)
+        all.insert(all.end(), list.begin(), list.end());
+
+    std::sort(all.begin(), all.end());
+    passed &= std::adjacent_find(all.begin(), all.end()) == all.end();
+
+    return passed ? 0 : -1;
+}
+
+LAVA_TEST(11, "vertex kernels") {
+    setup_log({ .debug = true });
+
+    auto const grid_size = 3163u; // 10m vertices
+    auto const vertex_count = grid_size * grid_size;
+
+    mesh_data data;
+    data.vertices.resize(vertex_count);
+
+    for (auto y = 0u; y < grid_size; ++y)
+        for (auto x = 0u; x < grid_size; ++x) {
+            auto& vertex = data.vertices[y * grid_size + x];
+            vertex.position = v3(to_r32(x), std::sin(to_r32(x) * 0.01f) * std::cos(to_r32(y) * 0.01f), to_r32(y));
+            vertex.normal = v3(0.f, 1.f, 0.f);
+            vertex.color = v4(1.f);
+            vertex.uv = v2(to_r32(x), to_r32(y)) / to_r32(grid_size);
+        }
+
+    // has to stay zero through the transform
+    data.vertices.front().normal = v3(0.f);
+
+    for (auto y = 0u; y + 1 < grid_size; ++y)
+        for (auto x = 0u; x + 1 < grid_size; ++x) {
+            auto const i = y * grid_size + x;
+            data.indices.insert(data.indices.end(), { i, i + grid_size, i + 1, i + 1, i + grid_size, i + grid_size + 1 });
+        }
+
+    // sse by default, avx with the LIBLAVA_AVX2 option, both checked against the scalar reference
+    log()->info("{} vertices, {} path", vertex_count, get_vertex_kernel_path());
+
+    auto result = true;
+
+    // scalar reference on a copy, every vertex compared with the kernel result
+    auto measure = [&](name label, auto&& scalar, auto&& kernel) {
+        auto expected = data.vertices;
+
+        timer timer;
+        scalar(expected);
+        auto const scalar_time = timer.elapsed();
+
+        timer.reset();
+        kernel();
+        auto const kernel_time = timer.elapsed();
+
+        log()->info("{}: scalar {} ms, kernel {} ms", label, scalar_time.count(), kernel_time.count());
+
+        auto mismatch_count = 0u;
+        for (auto i = 0u; i < vertex_count; ++i) {
+            auto const& a = expected[i];
+            auto const& b = data.vertices[i];
+
+            if ((glm::length(a.position - b.position) > 1e-5f * (1.f + glm::length(a.position)))
+                || (glm::length(a.normal - b.normal) > 1e-4f))
+                ++mismatch_count;
+        }
+
+        if (mismatch_count > 0) {
+            log()->error("{}: {} mismatches", label, mismatch_count);
+            result = false;
+        }
+    };
+
+    // zero normals stay zero like in the kernels
+    auto normalize = [](v3 const& value) {
+        auto const length = glm::length(value);
+        return length > 0.f ? value / length : v3(0.f);
+    };
+
+    measure(
+        "move",
+        [&](vertex::list& vertices) {
+            for (auto& vertex : vertices)
+                vertex.position += v3(1.f);
+        },
+        [&]() { translate_vertices(data.vertices, v3(1.f)); });
+
+    measure(
+        "scale",
+        [&](vertex::list& vertices) {
+            for (auto& vertex : vertices)
+                vertex.position *= 2.f;
+        },
+        [&]() { scale_vertices(data.vertices, 2.f); });
+
+    auto const matrix = glm::rotate(mat4(1.f), glm::radians(30.f), v3(0.f, 1.f, 0.f));
+
+    measure(
+        "transform",
+        [&](vertex::list& vertices) {
+            auto const normal_matrix = glm::transpose(glm::inverse(mat3(matrix)));
+
+            for (auto& vertex : vertices) {
+                vertex.position = v3(matrix * v4(vertex.position, 1.f));
+                vertex.normal = normalize(normal_matrix * vertex.normal);
+            }
+        },
+        [&]() { transform_vertices(data.vertices, matrix); });
+
+    mesh_bounds scalar_bounds;
+    scalar_bounds.min = data.vertices.front().position;
+    scalar_bounds.max = scalar_bounds.min;
+
+    timer timer;
+    for (auto const& vertex : data.vertices) {
+        scalar_bounds.min = glm::min(scalar_bounds.min, vertex.position);
+        scalar_bounds.max = glm::max(scalar_bounds.max, vertex.position);
+    }
+    auto const scalar_time = timer.elapsed();
+
+    timer.reset();
+    auto const bounds = compute_bounds(data.vertices);
+    log()->info("bounds: scalar {} ms, kernel {} ms", scalar_time.count(), timer.elapsed().count());
+
+    if ((bounds.min != scalar_bounds.min) || (bounds.max != scalar_bounds.max)) {
+        log()->error("bounds mismatch");
+        result = false;
+    }
+
+    measure(
+        "normals",
+        [&](vertex::list& vertices) {
+            std::vector<v3> normals(vertex_count, v3(0.f));
+
+            for (auto i = 0u; i < data.indices.size(); i += 3) {
+                auto const& p0 = vertices[data.indices[i]].position;
+                auto const face = glm::cross(vertices[data.indices[i + 1]].position - p0,
+                                             vertices[data.indices[i + 2]].position - p0);
+
+                for (auto c = 0u; c < 3; ++c)
+                    normals[data.indices[i + c]] += face;
+            }
+
+            for (auto i = 0u; i < vertex_count; ++i)
+                vertices[i].normal = normalize(normals[i]);
+        },
+        [&]() { compute_normals(data, false); });
+
+    timer.reset();
+    auto const tangents = compute_tangents(data);
+    log()->info("tangents: {} ms", timer.elapsed().count());
+
+    result &= tangents.size() == vertex_count;
+
+    return result ? 0 : -1;
+}
+
+LAVA_TEST(12, "geometry pool") {
+    // freed range is reused at the same offset, neighbours merge
+    range_allocator allocator;
+    allocator.reset(100);
+
+    auto const first = allocator.alloc(30);
+    auto const second = allocator.alloc(30);
+    auto const third = allocator.alloc(30);
+
+    allocator.free(second, 30);
+    if (allocator.alloc(30) != second)
+        return -1;
+
+    allocator.free(first, 30);
+    allocator.free(second, 30);
+    if ((allocator.alloc(60) != first) || (allocator.alloc(20) != no_index) || (third != 60))
+        return -1;
+
+    frame frame(argh);
+    if (!frame.ready())
+        return error::not_ready;
+
+    auto device = frame.create_device();
+    if (!device)
+        return error::create_failed;
+
+    // device local, uploads queued in staging
+    lava::staging staging;
+    if (!staging.create(device))
+        return error::create_failed;
+
+    auto pool = make_geometry_pool();
+    if (!pool->create(device, 1024, 4096, &staging))
+        return error::create_failed;
+
+    id::list geometries;
+    for (auto type : { mesh_type::cube, mesh_type::triangle, mesh_type::quad }) {
+        auto mesh = create_mesh(nullptr, type);
+        geometries.push_back(pool->add(mesh));
+    }
+
+    // freed range is reused
+    auto const removed = *pool->get(geometries[1]);
+    pool->remove(geometries[1]);
+    geometries[1] = pool->add(create_mesh(nullptr, mesh_type::triangle));
+
+    auto const reused = pool->get(geometries[1]);
+    if (!reused || (reused->first_vertex != removed.first_vertex) || (reused->first_index != removed.first_index))
+        return -1;
+
+    auto batch = make_draw_batch();
+    if (!batch->create(pool, 2))
+        return error::create_failed;
+
+    auto const instance_count = 10000u;
+    for (auto i = 0u; i < instance_count; ++i)
+        batch->add(geometries[i % geometries.size()], glm::translate(mat4(1.f), v3(to_r32(i), 0.f, 0.f)));
+
+    timer timer;
+    if (!batch->update(0))
+        return error::create_failed;
+
+    log()->info("{} instances -> {} indirect commands in {} ms, {} / {} vertices used", batch->get_instance_count(),
+                batch->get_command_count(0), timer.elapsed().count(), pool->get_vertex_allocator().get_used(),
+                pool->get_vertex_allocator().get_capacity());
+
+    auto const result = staging.busy() && (batch->get_command_count(0) == geometries.size());
+
+    pool->destroy();
+    staging.destroy();
+
+    return result ? 0 : -1;
+}
+
+LAVA_TEST(13, "instance culling") {
+    frame frame(argh);
+    if (!frame.ready())
+        return error::not_ready;
+
+    // headless, e.g. lavapipe
+    auto device = frame.create_device();
+    if (!device)
+        return error::create_failed;
+
+    auto pool = make_geometry_pool();
+    if (!pool->create(device, 1024, 4096))
+        return error::create_failed;
+
+    auto const cube = pool->add(create_mesh(nullptr, mesh_type::cube));
+
+    auto culler = make_instance_culler();
+    if (!culler->create(pool, 1))
+        return error::create_failed;
+
+    auto const grid_size = 100;
+    for (auto y = 0; y < grid_size; ++y)
+        for (auto x = 0; x < grid_size; ++x)
+            culler->add(cube, glm::translate(mat4(1.f), v3(to_r32(x - grid_size / 2) * 4.f, 0.f, to_r32(y - grid_size / 2) * 4.f)));
+
+    auto const view_projection = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 100.f)
+                                 * glm::lookAt(v3(0.f, 10.f, 0.f), v3(0.f, 0.f, -50.f), v3(0.f, 1.f, 0.f));
+
+    culler->set_gpu_active(false);
+    if (!culler->update(0, view_projection))
+        return error::create_failed;
+
+    auto const cpu_visible = culler->get_visible_count(0);
+    log()->info("cpu: {} / {} visible", cpu_visible, culler->get_instance_count(0));
+
+    // one geometry -> one command for all visible instances
+    if ((cpu_visible == 0) || (culler->get_command_count(0) != 1))
+        return -1;
+
+    // built-in shader, missing only without the device features
+    if (!culler->gpu_supported()) {
+        log()->info("gpu culling not supported");
+
+        return device->get_features().drawIndirectFirstInstance ? -1 : 0;
+    }
+
+    // spheres touching a plane may go either way in float
+    frustum const view_frustum(view_projection);
+    auto const sphere = pool->get(cube);
+
+    auto borderline = 0;
+    for (auto y = 0; y < grid_size; ++y)
+        for (auto x = 0; x < grid_size; ++x) {
+            auto const center = sphere->center + v3(to_r32(x - grid_size / 2) * 4.f, 0.f, to_r32(y - grid_size / 2) * 4.f);
+
+            for (auto const& plane : view_frustum.planes)
+                if (std::abs(glm::dot(v3(plane), center) + plane.w + sphere->radius) < 0.001f) {
+                    ++borderline;
+                    break;
+                }
+        }
+
+    culler->set_gpu_active(true);
+    if (!culler->update(0, view_projection))
+        return error::create_failed;
+
+    VkCommandPool cmd_pool;
+    if (!device->vkCreateCommandPool(device->graphics_queue().family, &cmd_pool))
+        return error::create_failed;
+
+    VkCommandBuffer cmd_buf;
+    if (!device->vkAllocateCommandBuffers(cmd_pool, 1, &cmd_buf))
+        return error::create_failed;
+
+    VkCommandBufferBeginInfo const begin_info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+
+    if (failed(device->call().vkBeginCommandBuffer(cmd_buf, &begin_info)))
+        return error::create_failed;
+
+    culler->dispatch(cmd_buf, 0);
+
+    if (failed(device->call().vkEndCommandBuffer(cmd_buf)))
+        return error::create_failed;
+
+    VkSubmitInfo const submit_info{
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &cmd_buf,
+    };
+
+    if (failed(device->call().vkQueueSubmit(device->graphics_queue().vk_queue, 1, &submit_info, 0)))
+        return error::create_failed;
+
+    device->wait_for_idle();
+
+    auto const gpu_visible = culler->get_visible_count(0);
+    log()->info("gpu: {} / {} visible", gpu_visible, culler->get_instance_count(0));
+
+    device->vkFreeCommandBuffers(cmd_pool, 1, &cmd_buf);
+    device->vkDestroyCommandPool(cmd_pool);
+
+    culler->destroy();
+    pool->destroy();
+
+    log()->info("{} borderline", borderline);
+
+    return (gpu_visible > 0) && (std::abs(to_i32(gpu_visible) - to_i32(cpu_visible)) <= borderline) ? 0 : -1;
+}
+
+LAVA_TEST(14, "bvh") {
+    setup_log({ .debug = true });
+
+    auto cube = create_mesh(nullptr, mesh_type::cube);
+    if (!cube)
+        return error::create_failed;
+
+    bvh::box cube_box;
+    for (auto const& vertex : cube->get_vertices())
+        cube_box.grow(vertex.position);
+
+    auto const grid_size = 200;
+
+    bvh::box::list boxes;
+    for (auto y = 0; y < grid_size; ++y)
+        for (auto x = 0; x < grid_size; ++x)
+            boxes.push_back(cube_box.transform(glm::translate(mat4(1.f), v3(to_r32(x - grid_size / 2) * 4.f, 0.f, to_r32(y - grid_size / 2) * 4.f))));
+
+    timer timer;
+
+    bvh tree;
+    if (!tree.build(boxes))
+        return error::create_failed;
+
+    log()->info("{} instances -> {} nodes in {} ms", boxes.size(), tree.get_nodes().size(), timer.elapsed().count());
+
+    camera camera;
+    camera.position = v3(0.f, 10.f, 0.f);
+    camera.rotation = v3(30.f, 0.f, 0.f);
+    camera.aspect_ratio = 16.f / 9.f;
+    camera.update_projection();
+    camera.update_view(0.f, mouse_position{});
+
+    auto const view_frustum = frustum(camera.get_view_projection());
+
+    timer.reset();
+    index_list visible;
+    tree.query(view_frustum, visible);
+    auto const query_time = timer.elapsed();
+
+    timer.reset();
+    auto linear_visible = 0u;
+    for (auto const& box : boxes)
+        if (view_frustum.intersects(box.min, box.max))
+            ++linear_visible;
+    auto const linear_time = timer.elapsed();
+
+    log()->info("frustum: {} visible, bvh {} ms, linear {} ms", visible.size(), query_time.count(), linear_time.count());
+
+    // mouse picking against a scan over all instances
+    uv2 const window_size = { 1280, 720 };
+    auto picked = 0u;
+
+    for (auto y = 0u; y <= window_size.y; y += 40)
+        for (auto x = 0u; x <= window_size.x; x += 40) {
+            auto const ray = camera.get_ray({ to_r64(x), to_r64(y) }, window_size);
+            auto const hit = tree.intersect(ray);
+
+            auto nearest = std::numeric_limits<r32>::max();
+            for (auto const& box : boxes) {
+                auto enter = 0.f;
+                auto exit = nearest;
+
+                for (auto a = 0; a < 3; ++a) {
+                    auto const t1 = (box.min[a] - ray.origin[a]) / ray.direction[a];
+                    auto const t2 = (box.max[a] - ray.origin[a]) / ray.direction[a];
+
+                    enter = std::max(enter, std::min(t1, t2));
+                    exit = std::min(exit, std::max(t1, t2));
+                }
+
+                if (enter <= exit)
+                    nearest = enter;
+            }
+
+            if (hit.valid() != (nearest < std::numeric_limits<r32>::max()))
+                return -1;
+
+            if (hit.valid()) {
+                if (std::abs(hit.distance - nearest) > 0.001f)
+                    return -1;
+
+                ++picked;
+            }
+        }
+
+    log()->info("picking: {} hits", picked);
+
+    // triangles, refit after a move
+    auto const size = 256u;
+
+    mesh_data terrain;
+    for (auto y = 0u; y <= size; ++y)
+        for (auto x = 0u; x <= size; ++x)
+            terrain.vertices.push_back({ .position = v3(to_r32(x), 0.f, to_r32(y)) });
+
+    for (auto y = 0u; y < size; ++y)
+        for (auto x = 0u; x < size; ++x) {
+            auto const i = y * (size + 1) + x;
+            terrain.indices.insert(terrain.indices.end(), { i, i + size + 1, i + 1, i + 1, i + size + 1, i + size + 2 });
+        }
+
+    mesh_bvh terrain_bvh;
+    if (!terrain_bvh.build(terrain))
+        return error::create_failed;
+
+    terrain.move(v3(0.f, 2.f, 0.f));
+    if (!terrain_bvh.refit(terrain))
+        return error::create_failed;
+
+    auto const terrain_hit = terrain_bvh.intersect({ v3(100.25f, 10.f, 50.5f), v3(0.f, -1.f, 0.f) });
+    log()->info("terrain: {} triangles, hit {} at {}", terrain_bvh.get_triangle_count(), terrain_hit.triangle, terrain_hit.distance);
+
+    if (!terrain_hit.valid() || (std::abs(terrain_hit.distance - 8.f) > 0.001f))
+        return -1;
+
+    return visible.size() == linear_visible ? 0 : -1;
+}
+
+LAVA_TEST(15, "texture mips") {
+    frame frame(argh);
+    if (!frame.ready())
+        return error::not_ready;
+
+    auto device = frame.create_device();
+    if (!device)
+        return error::create_failed;
+
+    lava::staging staging;
+    if (!staging.create(device))
+        return error::create_failed;
+
+    // built-in shader, missing only without the device feature
+    lava::mip_generator mip_generator;
+    if (mip_generator.create(device, 1))
+        staging.set_mip_func(mip_generator.get_func(), mip_generator.get_check());
+    else if (device->get_features().shaderStorageImageWriteWithoutFormat)
+        return -1;
+
+    uv2 const size = { 1024, 512 };
+    uv2 const level_size = { size.x / 2, size.y / 2 };
+
+    // exact in both formats
+    auto value = [](ui32 x, ui32 y, ui32 c) {
+        return to_r32((x * 7 + y * 13 + c * 29) % 256) / 255.f;
+    };
+
+    // float formats are often not blittable with a linear filter
+    texture::list textures;
+    for (auto format : { VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R32G32B32A32_SFLOAT }) {
+        auto texture = make_texture();
+        if (!texture->create(device, size, format, {}, texture_type::tex_2d, true))
+            return error::create_failed;
+
+        auto const unorm = format == VK_FORMAT_R8G8B8A8_UNORM;
+
+        std::vector<char> pixels(to_size_t(size.x) * size.y * format_block_size(format));
+        for (auto y = 0u; y < size.y; ++y)
+            for (auto x = 0u; x < size.x; ++x)
+                for (auto c = 0u; c < 4; ++c) {
+                    auto const i = (to_size_t(y) * size.x + x) * 4 + c;
+                    if (unorm)
+                        pixels[i] = (char) std::lround(value(x, y, c) * 255.f);
+                    else
+                        reinterpret_cast<r32*>(pixels.data())[i] = value(x, y, c);
+                }
+
+        if (!texture->upload(pixels.data(), pixels.size()))
+            return error::create_failed;
+
+        auto const path = texture->mip_blit_supported() ? "blit" : (mip_generator.supported(*texture) ? "compute" : "none");
+        log()->info("{} levels, {}", texture->get_level_count(), path);
+
+        if (!texture->mip_blit_supported() && !mip_generator.supported(*texture)) {
+            texture->destroy();
+            continue;
+        }
+
+        staging.add(texture);
+        textures.push_back(texture);
+    }
+
+    VkCommandPool cmd_pool;
+    if (!device->vkCreateCommandPool(device->graphics_queue().family, &cmd_pool))
+        return error::create_failed;
+
+    std::array<VkCommandBuffer, 2> cmd_bufs;
+    if (!device->vkAllocateCommandBuffers(cmd_pool, to_ui32(cmd_bufs.size()), cmd_bufs.data()))
+        return error::create_failed;
+
+    VkCommandBufferBeginInfo const begin_info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+
+    auto submit = [&](VkCommandBuffer cmd_buf) {
+        if (failed(device->call().vkEndCommandBuffer(cmd_buf)))
+            return false;
+
+        VkSubmitInfo const submit_info{
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &cmd_buf,
+        };
+
+        if (failed(device->call().vkQueueSubmit(device->graphics_queue().vk_queue, 1, &submit_info, 0)))
+            return false;
+
+        device->wait_for_idle();
+        return true;
+    };
+
+    if (failed(device->call().vkBeginCommandBuffer(cmd_bufs[0], &begin_info)))
+        return error::create_failed;
+
+    mip_generator.reclaim(0);
+    auto result = staging.stage(cmd_bufs[0], 0);
+
+    if (!submit(cmd_bufs[0]))
+        return error::create_failed;
+
+    // level 1 back to the host
+    buffer::list readbacks;
+
+    if (failed(device->call().vkBeginCommandBuffer(cmd_bufs[1], &begin_info)))
+        return error::create_failed;
+
+    for (auto& texture : textures) {
+        auto readback = make_buffer();
+        if (!readback->create(device, nullptr, to_size_t(level_size.x) * level_size.y * format_block_size(texture->get_format()),
+                              VK_BUFFER_USAGE_TRANSFER_DST_BIT, true, VMA_MEMORY_USAGE_GPU_TO_CPU))
+            return error::create_failed;
+
+        auto barrier = image_memory_barrier(texture->get_image()->get(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 1, 1, 0, 1 };
+
+        device->call().vkCmdPipelineBarrier(cmd_bufs[1], VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                                            0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkBufferImageCopy const region{
+            .imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 1, 0, 1 },
+            .imageExtent = { level_size.x, level_size.y, 1 },
+        };
+
+        device->call().vkCmdCopyImageToBuffer(cmd_bufs[1], texture->get_image()->get(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                              readback->get(), 1, &region);
+
+        readbacks.push_back(readback);
+    }
+
+    if (!submit(cmd_bufs[1]))
+        return error::create_failed;
+
+    // 2x2 box filter on the cpu
+    for (auto t = 0u; t < textures.size(); ++t) {
+        auto const unorm = textures[t]->get_format() == VK_FORMAT_R8G8B8A8_UNORM;
+        auto const tolerance = unorm ? 1.5f / 255.f : 1e-4f;
+
+        readbacks[t]->invalidate();
+        auto const mapped = readbacks[t]->get_mapped_data();
+
+        auto max_error = 0.f;
+        for (auto y = 0u; y < level_size.y; ++y)
+            for (auto x = 0u; x < level_size.x; ++x)
+                for (auto c = 0u; c < 4; ++c) {
+                    auto const expected = (value(x * 2, y * 2, c) + value(x * 2 + 1, y * 2, c)
+                                           + value(x * 2, y * 2 + 1, c) + value(x * 2 + 1, y * 2 + 1, c))
+                                          * 0.25f;
+
+                    auto const i = (to_size_t(y) * level_size.x + x) * 4 + c;
+                    auto const actual = unorm ? to_r32(static_cast<ui8 const*>(mapped)[i]) / 255.f
+                                              : static_cast<r32 const*>(mapped)[i];
+
+                    max_error = std::max(max_error, std::abs(actual - expected));
+                }
+
+        log()->info("level 1 format {} - max error {}", to_ui32(textures[t]->get_format()), max_error);
+
+        result &= max_error <= tolerance;
+    }
+
+    device->vkFreeCommandBuffers(cmd_pool, to_ui32(cmd_bufs.size()), cmd_bufs.data());
+    device->vkDestroyCommandPool(cmd_pool);
+
+    for (auto& readback : readbacks)
+        readback->destroy();
+
+    staging.set_mip_func({});
+    mip_generator.destroy();
+    staging.destroy();
+
+    result &= !textures.empty() && (textures.front()->get_level_count() == mip_level_count(size));
+
+    for (auto& texture : textures)
+        texture->destroy();
+
+    return result ? 0 : -1;
+}
+
+LAVA_TEST(16, "async loading") {
+    frame frame(argh);
+    if (!frame.ready())
+        return error::not_ready;
+
+    auto device = frame.create_device();
+    if (!device)
+        return error::create_failed;
+
+    lava::staging staging;
+    if (!staging.create(device))
+        return error::create_failed;
+
+    // next to the test, no file system mounted
+    name texture_path = "async_test.tga";
+    name mesh_path = "async_test.obj";
+
+    file_remover texture_remover(texture_path);
+    file_remover mesh_remover(mesh_path);
+
+    uv2 const size = { 256, 256 };
+    {
+        // uncompressed true color, top left origin
+        std::array<ui8, 18> header = {};
+        header[2] = 2;
+        header[12] = size.x & 0xff;
+        header[13] = size.x >> 8;
+        header[14] = size.y & 0xff;
+        header[15] = size.y >> 8;
+        header[16] = 32;
+        header[17] = 0x28;
+
+        std::vector<char> pixels(to_size_t(size.x) * size.y * 4);
+        for (auto i = 0u; i < pixels.size(); ++i)
+            pixels[i] = (char) (i % 251);
+
+        file file(texture_path, true);
+        if (!file.opened())
+            return error::create_failed;
+
+        file.write((data_cptr) header.data(), header.size());
+        file.write(pixels.data(), pixels.size());
+    }
+    {
+        string const obj = "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 1 1 0\nf 1 2 3\nf 2 4 3\n";
+
+        file file(mesh_path, true);
+        if (!file.opened())
+            return error::create_failed;
+
+        file.write(obj.data(), obj.size());
+    }
+
+    task_scheduler scheduler;
+    scheduler.setup();
+
+    asset_loader loader;
+    if (!loader.create(device, scheduler, &staging))
+        return error::create_failed;
+
+    timer timer;
+
+    std::vector<texture_load::ptr> textures;
+    for (auto i = 0u; i < 16; ++i)
+        textures.push_back(loader.load_texture({ texture_path }, texture_type::tex_2d,
+                                               i < 4 ? load_priority::high : load_priority::low));
+
+    auto mesh = loader.load_mesh(mesh_path, false, load_priority::normal);
+
+    auto cancelled = loader.load_texture({ texture_path }, texture_type::tex_2d, load_priority::low);
+    cancelled->cancel();
+
+    auto missing = loader.load_texture({ "async_missing.png" });
+
+    // budget per frame
+    auto frames = 0u;
+    while (loader.busy()) {
+        loader.poll(4);
+        ++frames;
+
+        sleep(ms(1));
+    }
+
+    log()->info("{} textures and a mesh in {} ms, {} polls", textures.size(), timer.elapsed().count(), frames);
+
+    loader.destroy();
+    scheduler.teardown();
+
+    auto result = true;
+
+    for (auto& texture : textures)
+        result &= texture->get_state() == load_state::ready;
+
+    result &= mesh->get() && (mesh->get()->get_indices().size() == 6);
+    result &= cancelled->get_state() == load_state::cancelled;
+    result &= missing->get_state() == load_state::failed;
+
+    if (result) {
+        VkCommandPool cmd_pool;
+        if (!device->vkCreateCommandPool(device->graphics_queue().family, &cmd_pool))
+            return error::create_failed;
+
+        VkCommandBuffer cmd_buf;
+        if (!device->vkAllocateCommandBuffers(cmd_pool, 1, &cmd_buf))
+            return error::create_failed;
+
+        VkCommandBufferBeginInfo const begin_info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
+
+        if (failed(device->call().vkBeginCommandBuffer(cmd_buf, &begin_info)))
+            return error::create_failed;
+
+        result &= staging.stage(cmd_buf, 0);
+
+        if (failed(device->call().vkEndCommandBuffer(cmd_buf)))
+            return error::create_failed;
+
+        VkSubmitInfo const submit_info{
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &cmd_buf,
+        };
+
+        if (failed(device->call().vkQueueSubmit(device->graphics_queue().vk_queue, 1, &submit_info, 0)))
+            return error::create_failed;
+
+        device->wait_for_idle();
+
+        device->vkFreeCommandBuffers(cmd_pool, 1, &cmd_buf);
+        device->vkDestroyCommandPool(cmd_pool);
+    }
+
+    staging.destroy();
+
+    for (auto& texture : textures)
+        if (texture->get())
+            texture->get()->destroy();
+
+    if (mesh->get())
+        mesh->get()->destroy();
+
+    return result ? 0 : -1;
+}
+
+// reference decoders, texels of a 4x4 block in row order as rgba
+using decoded_block = std::array<std::array<ui8, 4>, 16>;
+
+static std::array<ui32, 3> decode_rgb565(ui32 value) {
+    auto const r = (value >> 11) & 31;
+    auto const g = (value >> 5) & 63;
+    auto const b = value & 31;
+
+    return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+}
+
+// bc3 color blocks always use four colors
+static void decode_bc1(ui8 const* block, decoded_block& result, bool four_colors) {
+    auto const color0 = ui32(block[0]) | (ui32(block[1]) << 8);
+    auto const color1 = ui32(block[2]) | (ui32(block[3]) << 8);
+    auto const bits = ui32(block[4]) | (ui32(block[5]) << 8) | (ui32(block[6]) << 16) | (ui32(block[7]) << 24);
+
+    std::array<std::array<ui32, 4>, 4> palette = {};
+
+    auto const end0 = decode_rgb565(color0);
+    auto const end1 = decode_rgb565(color1);
+
+    for (auto c = 0u; c < 3; ++c) {
+        palette[0][c] = end0[c];
+        palette[1][c] = end1[c];
+
+        if (four_colors || (color0 > color1)) {
+            palette[2][c] = (2 * end0[c] + end1[c]) / 3;
+            palette[3][c] = (end0[c] + 2 * end1[c]) / 3;
+        } else {
+            palette[2][c] = (end0[c] + end1[c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    palette[3][3] = (four_colors || (color0 > color1)) ? 255 : 0;
+
+    for (auto i = 0u; i < 16; ++i)
+        for (auto c = 0u; c < 4; ++c)
+            result[i][c] = ui8(palette[(bits >> (2 * i)) & 3][c]);
+}
+
+static void decode_bc3_alpha(ui8 const* block, decoded_block& result) {
+    std::array<ui32, 8> palette = { block[0], block[1] };
+
+    if (palette[0] > palette[1]) {
+        for (auto i = 2u; i < 8; ++i)
+            palette[i] = ((8 - i) * palette[0] + (i - 1) * palette[1]) / 7;
+    } else {
+        for (auto i = 2u; i < 6; ++i)
+            palette[i] = ((6 - i) * palette[0] + (i - 1) * palette[1]) / 5;
+
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    auto bits = ui64(0);
+    for (auto i = 0u; i < 6; ++i)
+        bits |= ui64(block[2 + i]) << (8 * i);
+
+    for (auto i = 0u; i < 16; ++i)
+        result[i][3] = ui8(palette[(bits >> (3 * i)) & 7]);
+}
+
+// mode 6 only, false -> any other mode
+static bool decode_bc7(ui8 const* block, decoded_block& result) {
+    auto position = 0u;
+    auto read = [&](ui32 count) {
+        auto value = 0u;
+        for (auto i = 0u; i < count; ++i, ++position)
+            value |= ((block[position >> 3] >> (position & 7)) & 1u) << i;
+        return value;
+    };
+
+    if (read(7) != 64)
+        return false;
+
+    std::array<std::array<ui32, 4>, 2> endpoints = {};
+    for (auto c = 0u; c < 4; ++c) {
+        endpoints[0][c] = read(7);
+        endpoints[1][c] = read(7);
+    }
+
+    auto const p0 = read(1);
+    auto const p1 = read(1);
+
+    for (auto c = 0u; c < 4; ++c) {
+        endpoints[0][c] = (endpoints[0][c] << 1) | p0;
+        endpoints[1][c] = (endpoints[1][c] << 1) | p1;
+    }
+
+    std::array<ui32, 16> const weights = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    // anchor index one bit shorter
+    for (auto i = 0u; i < 16; ++i) {
+        auto const weight = weights[read(i == 0 ? 3 : 4)];
+        for (auto c = 0u; c < 4; ++c)
+            result[i][c] = ui8(((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+    }
+
+    return position == 128;
+}
+
+static bool decode_blocks(VkFormat format, std::vector<char> const& blocks, uv2 size, std::vector<char>& result) {
+    auto const block_size = get_encoder_block_size(format);
+    auto const block_count = uv2{ ceil_div(size.x, 4u), ceil_div(size.y, 4u) };
+
+    result.assign(to_size_t(size.x) * size.y * 4, 0);
+
+    for (auto by = 0u; by < block_count.y; ++by)
+        for (auto bx = 0u; bx < block_count.x; ++bx) {
+            auto const block = (ui8 const*) blocks.data() + (to_size_t(by) * block_count.x + bx) * block_size;
+
+            decoded_block texels = {};
+            if (format == VK_FORMAT_BC7_UNORM_BLOCK) {
+                if (!decode_bc7(block, texels))
+                    return false;
+            } else if (format == VK_FORMAT_BC3_UNORM_BLOCK) {
+                decode_bc1(block + 8, texels, true);
+                decode_bc3_alpha(block, texels);
+            } else {
+                decode_bc1(block, texels, false);
+            }
+
+            for (auto i = 0u; i < 16; ++i) {
+                auto const x = bx * 4 + i % 4;
+                auto const y = by * 4 + i / 4;
+                if ((x < size.x) && (y < size.y))
+                    memcpy(result.data() + (to_size_t(y) * size.x + x) * 4, texels[i].data(), 4);
+            }
+        }
+
+    return true;
+}
+
+// over channels first to first + count of rgba texels
+static r64 get_psnr(std::vector<char> const& reference, std::vector<char> const& value, ui32 first, ui32 count) {
+    auto error = 0.0;
+    for (auto i = size_t(0); i < reference.size(); i += 4)
+        for (auto c = first; c < first + count; ++c) {
+            auto const delta = r64((ui8) reference[i + c]) - r64((ui8) value[i + c]);
+            error += delta * delta;
+        }
+
+    auto const mse = error / r64(reference.size() / 4 * count);
+    return mse == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+LAVA_TEST(17, "texture encoding") {
+    setup_log({ .debug = true });
+
+    texture_data source;
+    source.size = { 1024, 1024 };
+    source.mip_levels_generation = true;
+    source.pixels.resize(to_size_t(source.size.x) * source.size.y * 4);
+
+    for (auto y = 0u; y < source.size.y; ++y)
+        for (auto x = 0u; x < source.size.x; ++x) {
+            auto pixel = (ui8*) source.pixels.data() + (to_size_t(y) * source.size.x + x) * 4;
+            pixel[0] = (ui8) (x / 4);
+            pixel[1] = (ui8) (y / 4);
+            pixel[2] = (ui8) (128.f + 127.f * std::sin(to_r32(x) * 0.05f) * std::cos(to_r32(y) * 0.03f));
+            pixel[3] = ((x / 64 + y / 64) % 2) ? 255 : (ui8) (x % 256);
+        }
+
+    task_scheduler scheduler;
+    scheduler.setup();
+
+    auto result = true;
+
+    // minimum psnr in db against the reference decoders, 0 -> channel not checked
+    struct quality {
+        VkFormat format;
+        r64 color = 0.0;
+        r64 alpha = 0.0;
+    };
+
+    for (auto const& [format, min_color, min_alpha] : { quality{ VK_FORMAT_BC1_RGB_UNORM_BLOCK, 38.0 },
+                                                        quality{ VK_FORMAT_BC3_UNORM_BLOCK, 38.0, 40.0 },
+                                                        quality{ VK_FORMAT_BC7_UNORM_BLOCK, 50.0, 46.0 } }) {
+        std::vector<char> serial(get_block_data_size(format, source.size));
+        std::vector<char> parallel(serial.size());
+
+        timer timer;
+        result &= encode_blocks(format, source.pixels.data(), source.size, serial.data());
+        auto const serial_time = timer.elapsed();
+
+        timer.reset();
+        result &= encode_blocks(format, source.pixels.data(), source.size, parallel.data(), &scheduler);
+        auto const parallel_time = timer.elapsed();
+
+        log()->info("format {}: serial {} ms, parallel {} ms", to_ui32(format), serial_time.count(), parallel_time.count());
+
+        result &= serial == parallel;
+
+        std::vector<char> decoded;
+        if (!decode_blocks(format, serial, source.size, decoded)) {
+            log()->error("format {}: not decodable", to_ui32(format));
+            result = false;
+            continue;
+        }
+
+        auto const color = get_psnr(source.pixels, decoded, 0, 3);
+        auto const alpha = get_psnr(source.pixels, decoded, 3, 1);
+
+        log()->info("format {}: color {:.2f} db, alpha {:.2f} db", to_ui32(format), color, alpha);
+
+        result &= color >= min_color;
+        result &= alpha >= min_alpha;
+    }
+
+    // a flat block is exact in every format, color representable in 565 and 7 bit + p bit
+    std::vector<char> flat(16 * 4);
+    for (auto i = 0u; i < 16; ++i)
+        memcpy(flat.data() + i * 4, std::array<ui8, 4>{ 255, 69, 41, 255 }.data(), 4);
+
+    for (auto format : { VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_BC3_UNORM_BLOCK, VK_FORMAT_BC7_UNORM_BLOCK }) {
+        std::vector<char> block(get_encoder_block_size(format));
+        std::vector<char> decoded;
+
+        result &= encode_blocks(format, flat.data(), { 4, 4 }, block.data())
+                  && decode_blocks(format, block, { 4, 4 }, decoded) && (decoded == flat);
+    }
+
+    texture_data encoded;
+    result &= encode_texture(source, VK_FORMAT_BC7_UNORM_BLOCK, encoded, &scheduler);
+
+    scheduler.teardown();
+
+    result &= (encoded.layers.size() == 1) && (encoded.layers.front().levels.size() == mip_level_count(source.size));
+
+    auto const cache_path = "encoding_test.ktx";
+    file_remover cache_remover(cache_path);
+
+    result &= write_texture_cache(cache_path, encoded, 1, 2);
+
+    texture_data cached;
+    result &= read_texture_cache(cache_path, VK_FORMAT_BC7_UNORM_BLOCK, cached, 1, 2);
+    result &= cached.pixels == encoded.pixels;
+
+    // outdated source
+    result &= !read_texture_cache(cache_path, VK_FORMAT_BC7_UNORM_BLOCK, cached, 1, 3);
+
+    return result ? 0 : -1;
+}
+
+LAVA_TEST(18, "asset manager") {
+    frame frame(argh);
+    if (!frame.ready())
+        return error::not_ready;
+
+    auto device = frame.create_device();
+    if (!device)
+        return error::create_failed;
+
+    // next to the test, no file system mounted
+    name mesh_path = "manager_test.obj";
+    file_remover mesh_remover(mesh_path);
+    {
+        string const obj = "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 1 1 0\nf 1 2 3\nf 2 4 3\n";
+
+        file file(mesh_path, true);
+        if (!file.opened())
+            return error::create_failed;
+
+        file.write(obj.data(), obj.size());
+    }
+
+    auto const frame_count = 2u;
+
+    asset_manager manager;
+    if (!manager.create(device, frame_count))
+        return error::create_failed;
+
+    auto result = true;
+    {
+        auto first = manager.load_mesh(mesh_path);
+        auto second = manager.load_mesh(mesh_path);
+        auto optimized = manager.load_mesh(mesh_path, true);
+
+        result &= first && (first.get() == second.get()) && (first.get() != optimized.get());
+        result &= manager.get_stats().asset_count == 2;
+    }
+
+    // released, still cached
+    result &= manager.get_stats().unreferenced_count == 2;
+
+    auto again = manager.load_mesh(mesh_path);
+    result &= manager.get_stats().hit_count == 2;
+
+    // over budget -> unreferenced one evicted, kept for frames in flight
+    manager.set_budget({ .gpu = 1 });
+    manager.update();
+
+    result &= (manager.get_stats().asset_count == 1) && (manager.get_stats().evict_count == 1);
+    result &= again && manager.get_meshes().has(again.get_id());
+
+    for (auto i = 0u; i <= frame_count; ++i)
+        manager.update();
+
+    result &= manager.get_stats().retired_count == 0;
+
+    again.reset();
+    manager.destroy();
+
+    return result ? 0 : -1;
+}
+
+LAVA_TEST(19, "texture streaming") {
+    frame frame(argh);
+    if (!frame.ready())
+        return error::not_ready;
+
+    auto device = frame.create_device();
+    if (!device)
+        return error::create_failed;
+
+    lava::staging staging;
+    if (!staging.create(device))
+        return error::create_failed;
+
+    auto const frame_count = 2u;
+
+    texture_stream stream;
+    if (!stream.create(device, staging, frame_count))
+        return error::create_failed;
+
+    // level 0 only, chain generated on the cpu
+    auto make_data = [](uv2 size) {
+        texture_data data;
+        data.size = size;
+        data.mip_levels_generation = true;
+        data.pixels.resize(to_size_t(size.x) * size.y * 4);
+
+        for (auto i = 0u; i < data.pixels.size(); ++i)
+            data.pixels[i] = (char) (i % 251);
+
+        return data;
+    };
+
+    auto detail = stream.add(make_data({ 2048, 2048 }), "detail");
+    auto distant = stream.add(make_data({ 2048, 2048 }), "distant");
+    if (!detail || !distant)
+        return error::create_failed;
+
+    auto const tail_size = stream.get_resident_size();
+
+    auto result = (detail->get_resident_level() == detail->get_tail_level()) && (detail->get()->get_size().x <= 64);
+
+    // upload budget per update, the finer one first
+    for (auto i = 0u; i < 2; ++i) {
+        stream.request_extent(*detail, 2048.f);
+        stream.request_extent(*distant, 100.f);
+        stream.update();
+    }
+
+    result &= (detail->get_resident_level() == 0) && (detail->get()->get_size().x == 2048);
+    result &= distant->get_resident_level() == get_stream_level(distant->get_size(), 100.f);
+
+    // budget below both, the one not requested any more gives way
+    stream.set_config({ .budget = stream.get_resident_size() / 2 });
+
+    for (auto i = 0u; i < 4; ++i) {
+        stream.request_extent(*distant, 2048.f);
+        stream.update();
+    }
+
+    result &= (distant->get_resident_level() < detail->get_resident_level()) && (stream.get_resident_size() <= stream.get_config().budget);
+
+    // nothing requested -> back to the tail
+    stream.set_config({ .keep_frames = 1 });
+
+    for (auto i = 0u; i <= frame_count + 2; ++i)
+        stream.update();
+
+    result &= stream.get_resident_size() == tail_size;
+
+    stream.destroy();
+    staging.destroy();
+
+    return result ? 0 : -1;
+}
+
+static ui32 pipeline_vert_shader[] = {
+#include "../res/tool/imgui/imgui.vert.u32"
+};
+
+static ui32 pipeline_frag_shader[] = {
+#include "../res/tool/imgui/imgui.frag.u32"
+};
+
+LAVA_TEST(20, "pipeline recreation") {
+    frame frame(argh);
+    if (!frame.ready())
+        return error::not_ready;
+
+    auto device = frame.create_device();
+    if (!device)
+        return error::create_failed;
+
+    auto const size = uv2(64, 64);
+    auto const format = VK_FORMAT_R8G8B8A8_UNORM;
+
+    auto color = make_image(format);
+    color->set_usage(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+    if (!color->create(device, size))
+        return error::create_failed;
+
+    auto pass = make_render_pass(device);
+    {
+        auto color_attachment = make_attachment(format);
+        color_attachment->set_op(VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
+        color_attachment->set_stencil_op(VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE);
+        color_attachment->set_layouts(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+        pass->add(color_attachment);
+
+        auto subpass = make_subpass(VK_PIPELINE_BIND_POINT_GRAPHICS);
+        subpass->set_color_attachment(0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+        pass->add(subpass);
+    }
+
+    if (!pass->create({ { color->get_view() } }, { {}, size }))
+        return error::create_failed;
+
+    pass->set_clear_color();
+    pass->get_subpass()->set_secondary(device);
+
+    auto descriptor = make_descriptor();
+    descriptor->add_binding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
+    if (!descriptor->create(device))
+        return error::create_failed;
+
+    auto layout = make_pipeline_layout();
+    layout->add(descriptor);
+    layout->add({ VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(r32) * 4 });
+    if (!layout->create(device))
+        return error::create_failed;
+
+    auto pipeline = make_graphics_pipeline(device);
+    pipeline->set_vertex_input_binding({ 0, sizeof(r32) * 5, VK_VERTEX_INPUT_RATE_VERTEX });
+    pipeline->set_vertex_input_attributes({
+        { 0, 0, VK_FORMAT_R32G32_SFLOAT, 0 },
+        { 1, 0, VK_FORMAT_R32G32_SFLOAT, sizeof(r32) * 2 },
+        { 2, 0, VK_FORMAT_R8G8B8A8_UNORM, sizeof(r32) * 4 },
+    });
+    pipeline->add_color_blend_attachment();
+
+    // destroy() drops shaders and layout
+    auto create_pipeline = [&]() {
+        if (!pipeline->add_shader({ pipeline_vert_shader, sizeof(pipeline_vert_shader) }, VK_SHADER_STAGE_VERTEX_BIT))
+            return false;
+
+        if (!pipeline->add_shader({ pipeline_frag_shader, sizeof(pipeline_frag_shader) }, VK_SHADER_STAGE_FRAGMENT_BIT))
+            return false;
+
+        pipeline->set_layout(layout);
+        return pipeline->create(pass->get());
+    };
+
+    if (!create_pipeline())
+        return error::create_failed;
+
+    auto record_count = 0u;
+    pipeline->on_process = [&](VkCommandBuffer) {
+        ++record_count;
+    };
+    pipeline->set_reusable();
+
+    pass->add(pipeline);
+
+    block block;
+    if (!block.create(device, 1, device->graphics_queue().family))
+        return error::create_failed;
+
+    block.add_command([&](VkCommandBuffer cmd_buf) {
+        pass->process(cmd_buf, block.get_current_frame());
+    });
+
+    auto result = block.process(0) && block.process(0);
+    result &= record_count == 1;
+
+    // new vk pipeline -> cached secondary recorded again
+    auto const version = pipeline->get_version();
+
+    pipeline->destroy();
+    if (!create_pipeline())
+        return error::create_failed;
+
+    result &= pipeline->get_version() != version;
+
+    result &= block.process(0);
+    result &= record_count == 2;
+
+    result &= block.process(0);
+    result &= record_count == 2;
+
+    block.destroy();
+
+    pass->destroy();
+    layout->destroy();
+    descriptor->destroy();
+    color->destroy();
+
+    return result ? 0 : -1;
+}
+
+LAVA_TEST(21, "mesh simplification") {
+    setup_log({ .debug = true });
+
+    // unit sphere, texture seam at u 0 / 1 with split vertices
+    auto const segments = 100u;
+    auto const rings = 101u;
+
+    mesh_data data;
+    for (auto y = 0u; y <= rings; ++y)
+        for (auto x = 0u; x <= segments; ++x) {
+            auto const u = to_r32(x) / to_r32(segments);
+            auto const v = to_r32(y) / to_r32(rings);
+
+            // same position on both sides of the seam
+            auto const theta = to_r32(x % segments) / to_r32(segments) * 2.f * glm::pi<r32>();
+            auto const phi = v * glm::pi<r32>();
+
+            vertex vertex;
+            vertex.position = v3(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+            vertex.uv = v2(u, v);
+            data.vertices.push_back(vertex);
+        }
+
+    for (auto y = 0u; y < rings; ++y)
+        for (auto x = 0u; x < segments; ++x) {
+            auto const i = y * (segments + 1) + x;
+            auto const below = i + segments + 1;
+
+            // no degenerate triangles at the poles
+            if (y > 0)
+                data.indices.insert(data.indices.end(), { i, i + 1, below });
+            if (y + 1 < rings)
+                data.indices.insert(data.indices.end(), { i + 1, below + 1, below });
+        }
+
+    auto const triangle_count = data.indices.size() / 3;
+    auto const target_error = 0.02f;
+
+    timer timer;
+
+    r32 error = 0.f;
+    auto const indices = simplify_mesh(data.indices, data.vertices, data.indices.size() / 4 / 3 * 3, target_error, &error);
+
+    log()->info("{} -> {} triangles, error {} in {} ms", triangle_count, indices.size() / 3, error, timer.elapsed().count());
+
+    auto result = (triangle_count >= 20000) && (indices.size() <= data.indices.size() / 4) && (error <= target_error);
+
+    for (auto i = 0u; i < indices.size(); i += 3) {
+        auto const& a = data.vertices[indices[i]];
+        auto const& b = data.vertices[indices[i + 1]];
+        auto const& c = data.vertices[indices[i + 2]];
+
+        auto const center = (a.position + b.position + c.position) / 3.f;
+        auto const normal = glm::cross(b.position - a.position, c.position - a.position);
+
+        // faces outwards and close to the sphere
+        result &= glm::dot(normal, center) > 0.f;
+        result &= 1.f - glm::length(center) <= 4.f * target_error;
+
+        // never stretched across the seam
+        result &= std::max({ a.uv.x, b.uv.x, c.uv.x }) - std::min({ a.uv.x, b.uv.x, c.uv.x }) < 0.5f;
+    }
+
+    // seam vertices collapse along the seam as well
+    std::vector<bool> used(data.vertices.size(), false);
+    for (auto index : indices)
+        used[index] = true;
+
+    auto seam_vertices = 0u;
+    for (auto i = 0u; i < data.vertices.size(); i += segments + 1)
+        if (used[i])
+            ++seam_vertices;
+
+    log()->info("seam: {} -> {} vertices", rings + 1, seam_vertices);
+
+    result &= seam_vertices < rings * 3 / 4;
+
+    return result ? 0 : -1;
+}
+
+LAVA_TEST(22, "mesh optimization") {
+    setup_log({ .debug = true });
+
+    auto const grid_size = 200u;
+    auto const row = grid_size + 1;
+
+    mesh_data data;
+    for (auto y = 0u; y < row; ++y)
+        for (auto x = 0u; x < row; ++x) {
+            vertex vertex;
+            vertex.position = v3(to_r32(x), to_r32(y), std::sin(to_r32(x) * 0.1f));
+            data.vertices.push_back(vertex);
+        }
+
+    index_list grid;
+    for (auto y = 0u; y < grid_size; ++y)
+        for (auto x = 0u; x < grid_size; ++x) {
+            auto const i = y * row + x;
+            grid.insert(grid.end(), { i, i + 1, i + row, i + 1, i + row + 1, i + row });
+        }
+
+    // scattered triangle order, stride coprime to the count
+    auto const triangle_count = to_ui32(grid.size() / 3);
+    for (auto t = 0u; t < triangle_count; ++t) {
+        auto const source = (to_size_t(t) * 7919 % triangle_count) * 3;
+        data.indices.insert(data.indices.end(), grid.begin() + source, grid.begin() + source + 3);
+    }
+
+    auto const before = analyze_vertex_cache(data.indices, data.vertices.size());
+
+    auto result = optimize_vertex_cache(data.indices, data.vertices.size());
+    auto const optimized = analyze_vertex_cache(data.indices, data.vertices.size());
+
+    result &= optimize_overdraw(data.indices, data.vertices);
+    auto const overdraw = analyze_vertex_cache(data.indices, data.vertices.size());
+
+    log()->info("acmr {} -> {}, {} with overdraw", before.acmr, optimized.acmr, overdraw.acmr);
+
+    // a grid gets close to one miss per two triangles
+    result &= (before.acmr > 2.f) && (optimized.acmr < 0.8f);
+    result &= overdraw.acmr <= optimized.acmr * 1.05f + 0.001f;
+
+    // same triangles, only in another order
+    auto sorted = [](index_list const& indices) {
+        std::vector<std::array<ui32, 3>> triangles;
+        for (auto i = 0u; i < indices.size(); i += 3) {
+            std::array<ui32, 3> triangle = { indices[i], indices[i + 1], indices[i + 2] };
+            std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+            triangles.push_back(triangle);
+        }
+
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    };
+
+    result &= sorted(data.indices) == sorted(grid);
+
+    return result ? 0 : -1;
+}